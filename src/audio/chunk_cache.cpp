@@ -0,0 +1,135 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "chunk_cache.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <system_error>
+
+#include <fmt/format.h>
+
+#include "../io/streams.hpp"
+#include "../md5.h"
+
+using std::size_t;
+
+using namespace srb2::audio;
+using namespace srb2;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+constexpr uint32_t kCacheMagic = 0x43584653; // "SFXC"
+constexpr uint32_t kCacheVersion = 1;
+constexpr uintmax_t kHeaderSize = 4 * sizeof(uint32_t);
+
+// Samples are stored as raw floats, so files are only valid on machines
+// with the same float layout. The magic doubles as a byte order check.
+static_assert(sizeof(Sample<1>) == sizeof(float));
+
+std::string cache_path(const std::string& directory, tcb::span<const std::byte> source)
+{
+	std::array<unsigned char, 16> digest;
+	md5_buffer(reinterpret_cast<const char*>(source.data()), source.size(), digest.data());
+
+	std::string name;
+	for (unsigned char c : digest)
+	{
+		name += fmt::format("{:02x}", c);
+	}
+
+	return fmt::format("{}/{}.sfx", directory, name);
+}
+
+} // namespace
+
+std::optional<SoundChunk> srb2::audio::load_cached_chunk(const std::string& directory, tcb::span<const std::byte> source)
+{
+	std::string path = cache_path(directory, source);
+
+	// FileStream reads nothing at EOF rather than throwing, so a truncated
+	// file has to be caught before reading the samples.
+	std::error_code ec;
+	uintmax_t file_size = fs::file_size(path, ec);
+	if (ec || file_size < kHeaderSize)
+	{
+		return std::nullopt;
+	}
+
+	try
+	{
+		io::FileStream file {path, io::FileStreamMode::kRead};
+
+		uint32_t magic = io::read_uint32(file);
+		uint32_t version = io::read_uint32(file);
+		uint32_t source_size = io::read_uint32(file);
+		uint32_t count = io::read_uint32(file);
+
+		// The size check guards against the (unlikely) hash collision.
+		if (magic != kCacheMagic || version != kCacheVersion || source_size != source.size() ||
+			file_size != kHeaderSize + static_cast<uintmax_t>(count) * sizeof(Sample<1>))
+		{
+			return std::nullopt;
+		}
+
+		SoundChunk chunk;
+		chunk.samples.resize(count);
+		io::read_exact(file, tcb::as_writable_bytes(tcb::make_span(chunk.samples)));
+
+		return chunk;
+	}
+	catch (...)
+	{
+		// Unreadable; decode it again instead
+		return std::nullopt;
+	}
+}
+
+void srb2::audio::store_cached_chunk(
+	const std::string& directory,
+	tcb::span<const std::byte> source,
+	const SoundChunk& chunk
+)
+{
+	// Several sounds can share the same data, so write to a unique name and
+	// rename over the final one; readers only ever see complete files.
+	static std::atomic<uint32_t> temp_counter {0};
+
+	std::string path = cache_path(directory, source);
+	std::string temp_path = fmt::format("{}.{}.tmp", path, temp_counter.fetch_add(1, std::memory_order_relaxed));
+
+	try
+	{
+		std::error_code ec;
+		fs::create_directories(directory, ec);
+
+		{
+			io::FileStream file {temp_path, io::FileStreamMode::kWrite};
+
+			io::write(kCacheMagic, file);
+			io::write(kCacheVersion, file);
+			io::write(static_cast<uint32_t>(source.size()), file);
+			io::write(static_cast<uint32_t>(chunk.samples.size()), file);
+			io::write_exact(file, tcb::as_bytes(tcb::make_span(chunk.samples)));
+			file.close();
+		}
+
+		fs::rename(temp_path, path);
+	}
+	catch (...)
+	{
+		std::error_code ec;
+		fs::remove(temp_path, ec);
+	}
+}
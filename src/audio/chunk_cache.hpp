@@ -0,0 +1,36 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_AUDIO_CHUNK_CACHE_HPP__
+#define __SRB2_AUDIO_CHUNK_CACHE_HPP__
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include <tcb/span.hpp>
+
+#include "sound_chunk.hpp"
+
+namespace srb2::audio
+{
+
+// An on-disk cache of decoded sound chunks, one file per chunk, named after
+// the MD5 of the data it was decoded from. Both functions are safe to call
+// from any thread.
+
+/// @brief The chunk previously stored for this source data, if any.
+std::optional<SoundChunk> load_cached_chunk(const std::string& directory, tcb::span<const std::byte> source);
+
+/// @brief Stores a chunk decoded from source. Failures are ignored; the chunk is simply decoded again next time.
+void store_cached_chunk(const std::string& directory, tcb::span<const std::byte> source, const SoundChunk& chunk);
+
+} // namespace srb2::audio
+
+#endif // __SRB2_AUDIO_CHUNK_CACHE_HPP__
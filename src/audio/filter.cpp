@@ -10,6 +10,8 @@
 
 #include "filter.hpp"
 
+#include <algorithm>
+
 using std::shared_ptr;
 using std::size_t;
 
@@ -20,10 +22,12 @@ using srb2::audio::Source;
 template <size_t IC, size_t OC>
 size_t Filter<IC, OC>::generate(tcb::span<Sample<OC>> buffer)
 {
-	input_buffer_.clear();
 	input_buffer_.resize(buffer.size());
 
-	input_->generate(input_buffer_);
+	size_t read = input_->generate(input_buffer_);
+
+	// Only the part the input didn't write needs silencing
+	std::fill(input_buffer_.begin() + std::min(read, input_buffer_.size()), input_buffer_.end(), Sample<IC> {});
 
 	return filter(input_buffer_, buffer);
 }
@@ -11,6 +11,9 @@
 #include "gain.hpp"
 
 #include <algorithm>
+#include <cmath>
+
+#include "kernels.hpp"
 
 using std::size_t;
 
@@ -20,17 +23,33 @@ using srb2::audio::Sample;
 
 constexpr const float kGainInterpolationAlpha = 0.8f;
 
+// Once the interpolated gain is this close to the target, snap to it so the
+// rest of the buffer can be scaled in bulk.
+constexpr const float kGainSettleEpsilon = 1e-6f;
+
 template <size_t C>
 size_t Gain<C>::filter(tcb::span<Sample<C>> input_buffer, tcb::span<Sample<C>> buffer)
 {
 	size_t written = std::min(buffer.size(), input_buffer.size());
-	for (size_t i = 0; i < written; i++)
+	size_t i = 0;
+	for (; i < written && gain_ != new_gain_; i++)
 	{
 		buffer[i] = input_buffer[i];
 		buffer[i] *= gain_;
 		gain_ += (new_gain_ - gain_) * kGainInterpolationAlpha;
+		if (std::fabs(new_gain_ - gain_) < kGainSettleEpsilon)
+		{
+			gain_ = new_gain_;
+		}
 	}
 
+	srb2::audio::kernels::scale(
+		reinterpret_cast<float*>(buffer.data() + i),
+		reinterpret_cast<const float*>(input_buffer.data() + i),
+		(written - i) * C,
+		gain_
+	);
+
 	return written;
 }
 
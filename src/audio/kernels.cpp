@@ -0,0 +1,245 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "kernels.hpp"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SRB2_AUDIO_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(SRB2_AUDIO_SSE2) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SRB2_AUDIO_AVX2
+#include <immintrin.h>
+#endif
+
+using std::size_t;
+
+namespace
+{
+
+using MixFn = void (*)(float*, const float*, size_t);
+using ScaleFn = void (*)(float*, const float*, size_t, float);
+using ClampFn = void (*)(float*, size_t);
+
+struct KernelTable
+{
+	MixFn mix;
+	ScaleFn scale;
+	ClampFn clamp;
+	const char* name;
+};
+
+void mix_scalar(float* dst, const float* src, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		dst[i] += src[i];
+	}
+}
+
+void scale_scalar(float* dst, const float* src, size_t count, float gain)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		dst[i] = src[i] * gain;
+	}
+}
+
+void clamp_scalar(float* buf, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		buf[i] = std::clamp(buf[i], -1.f, 1.f);
+	}
+}
+
+#ifdef SRB2_AUDIO_SSE2
+void mix_sse2(float* dst, const float* src, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+	}
+	mix_scalar(dst + i, src + i, count - i);
+}
+
+void scale_sse2(float* dst, const float* src, size_t count, float gain)
+{
+	const __m128 g = _mm_set1_ps(gain);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(src + i), g));
+	}
+	scale_scalar(dst + i, src + i, count - i, gain);
+}
+
+void clamp_sse2(float* buf, size_t count)
+{
+	const __m128 lo = _mm_set1_ps(-1.f);
+	const __m128 hi = _mm_set1_ps(1.f);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(buf + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(buf + i), lo), hi));
+	}
+	clamp_scalar(buf + i, count - i);
+}
+#endif
+
+#ifdef SRB2_AUDIO_AVX2
+__attribute__((target("avx2"))) void mix_avx2(float* dst, const float* src, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+	}
+	mix_sse2(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx2"))) void scale_avx2(float* dst, const float* src, size_t count, float gain)
+{
+	const __m256 g = _mm256_set1_ps(gain);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), g));
+	}
+	scale_sse2(dst + i, src + i, count - i, gain);
+}
+
+__attribute__((target("avx2"))) void clamp_avx2(float* buf, size_t count)
+{
+	const __m256 lo = _mm256_set1_ps(-1.f);
+	const __m256 hi = _mm256_set1_ps(1.f);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_ps(buf + i, _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(buf + i), lo), hi));
+	}
+	clamp_sse2(buf + i, count - i);
+}
+#endif
+
+KernelTable select_kernels()
+{
+#ifdef SRB2_AUDIO_AVX2
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return {mix_avx2, scale_avx2, clamp_avx2, "AVX2"};
+	}
+#endif
+#ifdef SRB2_AUDIO_SSE2
+	return {mix_sse2, scale_sse2, clamp_sse2, "SSE2"};
+#else
+	return {mix_scalar, scale_scalar, clamp_scalar, "scalar"};
+#endif
+}
+
+const KernelTable& active_kernels()
+{
+	static const KernelTable table = select_kernels();
+	return table;
+}
+
+} // namespace
+
+namespace srb2::audio::kernels
+{
+
+void mix(float* dst, const float* src, size_t count) noexcept
+{
+	active_kernels().mix(dst, src, count);
+}
+
+void scale(float* dst, const float* src, size_t count, float gain) noexcept
+{
+	active_kernels().scale(dst, src, count, gain);
+}
+
+void clamp(float* buf, size_t count) noexcept
+{
+	active_kernels().clamp(buf, count);
+}
+
+void pan_mono(float* dst, const float* src, size_t frames, float left, float right) noexcept
+{
+	size_t i = 0;
+#ifdef SRB2_AUDIO_SSE2
+	const __m128 lr = _mm_setr_ps(left, right, left, right);
+	for (; i + 4 <= frames; i += 4)
+	{
+		__m128 mono = _mm_loadu_ps(src + i);
+		_mm_storeu_ps(dst + i * 2, _mm_mul_ps(_mm_unpacklo_ps(mono, mono), lr));
+		_mm_storeu_ps(dst + i * 2 + 4, _mm_mul_ps(_mm_unpackhi_ps(mono, mono), lr));
+	}
+#endif
+	for (; i < frames; i++)
+	{
+		dst[i * 2] = src[i] * left;
+		dst[i * 2 + 1] = src[i] * right;
+	}
+}
+
+template <size_t C>
+size_t resample_linear(float* dst, size_t max_frames, const float* src, size_t src_frames, int& pos, float& frac, float step) noexcept
+{
+	const int last = static_cast<int>(src_frames) - 1;
+	int p = pos;
+	float f = frac;
+	size_t written = 0;
+
+	for (; written < max_frames && p < last; written++)
+	{
+		const float* a = src + p * C;
+		float* out = dst + written * C;
+
+#ifdef SRB2_AUDIO_SSE2
+		if constexpr (C == 2)
+		{
+			// frames p and p + 1 in one load: [a0 a1 b0 b1]
+			__m128 ab = _mm_loadu_ps(a);
+			__m128 b = _mm_movehl_ps(ab, ab);
+			_mm_storel_pi(reinterpret_cast<__m64*>(out), _mm_add_ps(_mm_mul_ps(_mm_sub_ps(b, ab), _mm_set1_ps(f)), ab));
+		}
+		else
+#endif
+		{
+			for (size_t c = 0; c < C; c++)
+			{
+				out[c] = (a[c + C] - a[c]) * f + a[c];
+			}
+		}
+
+		// f stays non-negative, so truncation is floor
+		f += step;
+		int whole = static_cast<int>(f);
+		p += whole;
+		f -= whole;
+	}
+
+	pos = p;
+	frac = f;
+	return written;
+}
+
+template size_t resample_linear<1>(float*, size_t, const float*, size_t, int&, float&, float) noexcept;
+template size_t resample_linear<2>(float*, size_t, const float*, size_t, int&, float&, float) noexcept;
+
+const char* instruction_set() noexcept
+{
+	return active_kernels().name;
+}
+
+} // namespace srb2::audio::kernels
@@ -0,0 +1,55 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_AUDIO_KERNELS_HPP__
+#define __SRB2_AUDIO_KERNELS_HPP__
+
+#include <cstddef>
+
+namespace srb2::audio::kernels
+{
+
+// Bulk operations over interleaved float samples, used by the DSP graph.
+// Counts are in floats (frames * channels) unless stated otherwise. Each
+// kernel picks the widest vector instruction set the CPU supports, falling
+// back to plain scalar code.
+
+/// @brief dst[i] += src[i]
+void mix(float* dst, const float* src, std::size_t count) noexcept;
+
+/// @brief dst[i] = src[i] * gain. dst and src may be the same buffer.
+void scale(float* dst, const float* src, std::size_t count, float gain) noexcept;
+
+/// @brief Clamps every value to [-1, 1].
+void clamp(float* buf, std::size_t count) noexcept;
+
+/// @brief Writes frames of stereo output from frames of mono input at fixed left/right gains.
+void pan_mono(float* dst, const float* src, std::size_t frames, float left, float right) noexcept;
+
+/// @brief Linear interpolation through src (src_frames frames of C channels), starting at frame
+/// pos + frac and stepping by step frames each output frame. Stops after max_frames outputs or
+/// when the next output would need the frame after the last one. Updates pos and frac and
+/// returns the number of frames written.
+template <std::size_t C>
+std::size_t resample_linear(
+	float* dst,
+	std::size_t max_frames,
+	const float* src,
+	std::size_t src_frames,
+	int& pos,
+	float& frac,
+	float step
+) noexcept;
+
+/// @brief Name of the instruction set the kernels are using, for diagnostics.
+const char* instruction_set() noexcept;
+
+} // namespace srb2::audio::kernels
+
+#endif // __SRB2_AUDIO_KERNELS_HPP__
@@ -12,6 +12,8 @@
 
 #include <algorithm>
 
+#include "kernels.hpp"
+
 using std::shared_ptr;
 using std::size_t;
 
@@ -25,16 +27,17 @@ namespace
 template <size_t C>
 void default_init_sample_buffer(Sample<C>* buffer, size_t size)
 {
-	std::for_each(buffer, buffer + size, [](auto& i) { i = Sample<C> {}; });
+	std::fill_n(reinterpret_cast<float*>(buffer), size * C, 0.f);
 }
 
 template <size_t C>
 void mix_sample_buffers(Sample<C>* dst, size_t size, Sample<C>* src, size_t src_size)
 {
-	for (size_t i = 0; i < size && i < src_size; i++)
-	{
-		dst[i] += src[i];
-	}
+	srb2::audio::kernels::mix(
+		reinterpret_cast<float*>(dst),
+		reinterpret_cast<const float*>(src),
+		std::min(size, src_size) * C
+	);
 }
 
 } // namespace
@@ -50,6 +53,12 @@ size_t Mixer<C>::generate(tcb::span<Sample<C>> buffer)
 	{
 		size_t read = source->generate(buffer_);
 
+		if (read == 0)
+		{
+			// Idle sound effect channels are the common case
+			continue;
+		}
+
 		mix_sample_buffers<C>(buffer.data(), buffer.size(), buffer_.data(), read);
 	}
 
@@ -11,17 +11,24 @@
 #include "music_player.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
 #include <exception>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <variant>
 #include <vector>
 
 #include <stb_vorbis.h>
+#include <tracy/tracy/Tracy.hpp>
 
+#include "../core/spsc_queue.hpp"
 #include "../cxxutil.hpp"
 #include "../io/streams.hpp"
 #include "ogg_player.hpp"
@@ -38,32 +45,116 @@ using srb2::audio::MusicPlayer;
 using srb2::audio::Resampler;
 using srb2::audio::Sample;
 using srb2::audio::Source;
+using srb2::audio::kSampleRate;
 using namespace srb2;
 
+namespace
+{
+
+// Music is decoded on its own thread, kChunkCount chunks of kChunkFrames
+// ahead of the audio callback, so a slow decode can't underrun the mix or
+// hold the audio lock. Chunks circulate between the threads through two
+// queues, so neither side ever allocates or blocks.
+constexpr size_t kChunkFrames = 1024;
+constexpr size_t kChunkCount = 16; // ~370 ms at 44100 Hz
+constexpr size_t kControlCapacity = 256;
+
+struct MusicChunk
+{
+	array<Sample<2>, kChunkFrames> frames;
+	size_t count;
+	uint32_t generation;
+	float position; // song position of frames[0], in seconds
+	bool end; // nothing follows this chunk
+};
+
+enum class MusicControlType
+{
+	kPlay,
+	kStop,
+	kSeek,
+	kLoopPoint,
+	kPause,
+	kResume
+};
+
+struct MusicControl
+{
+	MusicControlType type;
+	uint32_t generation;
+	float value;
+	bool looping;
+	bool active; // kSeek: keep decoding afterwards
+};
+
+} // namespace
+
 class MusicPlayer::Impl
 {
 public:
 	Impl() = default;
-	Impl(tcb::span<std::byte> data) : Impl() { _load(data); }
+	Impl(tcb::span<std::byte> data) : Impl()
+	{
+		_load(data);
+
+		if (resampler_)
+		{
+			chunks_ = make_unique<MusicChunk[]>(kChunkCount);
+			for (size_t i = 0; i < kChunkCount; i++)
+			{
+				free_chunks_.push(&chunks_[i]);
+			}
+
+			decode_thread_ = std::thread([this] { decode_loop(); });
+		}
+	}
+
+	Impl(const Impl&) = delete;
+	Impl& operator=(const Impl&) = delete;
+
+	~Impl()
+	{
+		if (decode_thread_.joinable())
+		{
+			quit_.store(true, std::memory_order_relaxed);
+			wake_decoder();
+			decode_thread_.join();
+		}
+	}
 
 	size_t generate(tcb::span<Sample<2>> buffer)
 	{
-		if (!resampler_)
+		if (!type_)
 			return 0;
 
 		if (!playing_)
 			return 0;
 
 		size_t total_written = 0;
+		bool released = false;
 
 		while (total_written < buffer.size())
 		{
-			const size_t generated = resampler_->generate(buffer.subspan(total_written));
+			if (current_ == nullptr)
+			{
+				current_ = next_chunk();
+				current_offset_ = 0;
+
+				if (current_ == nullptr)
+				{
+					// The decoder is behind; the rest of this buffer is silence.
+					break;
+				}
+			}
+
+			const size_t generated = std::min(current_->count - current_offset_, buffer.size() - total_written);
+			const Sample<2>* frames = current_->frames.data() + current_offset_;
 
 			// To avoid a branch preventing optimizations, we're always going to apply
 			// the fade gain, even if it would clamp anyway.
 			for (std::size_t i = 0; i < generated; i++)
 			{
+				buffer[total_written + i] = frames[i];
 				buffer[total_written + i] *= current_fade_gain(i);
 			}
 
@@ -77,14 +168,30 @@ public:
 			}
 
 			total_written += generated;
+			current_offset_ += generated;
 
-			if (generated == 0)
+			if (current_offset_ >= current_->count)
 			{
-				playing_ = false;
-				break;
+				const bool end = current_->end;
+
+				position_ = current_->position + current_->count / static_cast<float>(kSampleRate);
+				free_chunks_.push(current_);
+				current_ = nullptr;
+				released = true;
+
+				if (end)
+				{
+					playing_ = false;
+					break;
+				}
 			}
 		}
 
+		if (released)
+		{
+			wake_decoder();
+		}
+
 		return total_written;
 	}
 
@@ -101,6 +208,9 @@ public:
 			ogg_inst_ = std::make_shared<audio::OggPlayer<2>>(std::move(ogg));
 			ogg_inst_->looping(looping_);
 			resampler_ = Resampler<2>(ogg_inst_, ogg_inst_->sample_rate() / 44100.f);
+			type_ = audio::MusicType::kOgg;
+			duration_ = ogg_inst_->duration_seconds();
+			loop_point_ = ogg_inst_->loop_point_seconds();
 		}
 		catch (const std::exception& ex)
 		{
@@ -119,6 +229,8 @@ public:
 				xmp_inst_->looping(looping_);
 
 				resampler_ = Resampler<2>(xmp_inst_, 1.f);
+				type_ = audio::MusicType::kMod;
+				duration_ = xmp_inst_->duration_seconds();
 			}
 			catch (const std::exception& ex)
 			{
@@ -135,122 +247,68 @@ public:
 
 	void play(bool looping)
 	{
-		if (ogg_inst_)
-		{
-			ogg_inst_->looping(looping);
-			ogg_inst_->playing(true);
-			playing_ = true;
-			ogg_inst_->reset();
-		}
-		else if (xmp_inst_)
-		{
-			xmp_inst_->looping(looping);
-			playing_ = true;
-			xmp_inst_->reset();
-		}
+		if (!type_)
+			return;
+
+		flush({MusicControlType::kPlay, 0, 0.f, looping});
+		position_ = 0.f;
+		playing_ = true;
 	}
 
 	void unpause()
 	{
-		if (ogg_inst_)
-		{
-			ogg_inst_->playing(true);
-			playing_ = true;
-		}
-		else if (xmp_inst_)
-		{
-			playing_ = true;
-		}
+		if (!type_)
+			return;
+
+		push_control({MusicControlType::kResume, generation_});
+		playing_ = true;
 	}
 
 	void pause()
 	{
-		if (ogg_inst_)
-		{
-			ogg_inst_->playing(false);
-			playing_ = false;
-		}
-		else if (xmp_inst_)
-		{
-			playing_ = false;
-		}
-	}
+		if (!type_)
+			return;
 
-	void stop()
-	{
-		if (ogg_inst_)
-		{
-			ogg_inst_->reset();
-			ogg_inst_->playing(false);
-			playing_ = false;
-		}
-		else if (xmp_inst_)
-		{
-			xmp_inst_->reset();
-			playing_ = false;
-		}
+		push_control({MusicControlType::kPause, generation_});
+		playing_ = false;
 	}
 
-	void seek(float position_seconds)
+	void stop()
 	{
-		if (ogg_inst_)
-		{
-			ogg_inst_->seek(position_seconds);
-			return;
-		}
-		if (xmp_inst_)
-		{
-			xmp_inst_->seek(position_seconds);
+		if (!type_)
 			return;
-		}
-	}
-
-	bool playing() const
-	{
-		if (ogg_inst_)
-			return ogg_inst_->playing();
-		else if (xmp_inst_)
-			return playing_;
 
-		return false;
+		flush({MusicControlType::kStop});
+		position_ = 0.f;
+		playing_ = false;
 	}
 
-	std::optional<audio::MusicType> music_type() const
+	void seek(float position_seconds)
 	{
-		if (ogg_inst_)
-			return audio::MusicType::kOgg;
-		else if (xmp_inst_)
-			return audio::MusicType::kMod;
+		if (!type_)
+			return;
 
-		return std::nullopt;
+		flush({MusicControlType::kSeek, 0, position_seconds, false, playing_});
+		position_ = position_seconds;
 	}
 
-	std::optional<float> duration_seconds() const
-	{
-		if (ogg_inst_)
-			return ogg_inst_->duration_seconds();
-		if (xmp_inst_)
-			return xmp_inst_->duration_seconds();
+	bool playing() const { return type_ && playing_; }
 
-		return std::nullopt;
-	}
+	std::optional<audio::MusicType> music_type() const { return type_; }
 
-	std::optional<float> loop_point_seconds() const
-	{
-		if (ogg_inst_)
-			return ogg_inst_->loop_point_seconds();
+	std::optional<float> duration_seconds() const { return duration_; }
 
-		return std::nullopt;
-	}
+	std::optional<float> loop_point_seconds() const { return loop_point_; }
 
 	std::optional<float> position_seconds() const
 	{
-		if (ogg_inst_)
-			return ogg_inst_->position_seconds();
-		if (xmp_inst_)
-			return xmp_inst_->position_seconds();
+		if (!type_)
+			return std::nullopt;
 
-		return std::nullopt;
+		if (current_)
+			return current_->position + current_offset_ / static_cast<float>(kSampleRate);
+
+		return position_;
 	}
 
 	void fade_to(float gain, float seconds) { fade_from_to(current_fade_gain(0), gain, seconds); }
@@ -272,8 +330,12 @@ public:
 
 	void loop_point_seconds(float loop_point)
 	{
-		if (ogg_inst_)
-			ogg_inst_->loop_point_seconds(loop_point);
+		if (type_ != audio::MusicType::kOgg)
+			return;
+
+		// Only affects the next loop, so decoded audio is kept.
+		push_control({MusicControlType::kLoopPoint, generation_, loop_point});
+		loop_point_ = loop_point;
 	}
 
 	void internal_gain(float gain)
@@ -286,12 +348,24 @@ public:
 	}
 
 private:
+	// Decode thread only, once it has started
 	std::shared_ptr<OggPlayer<2>> ogg_inst_;
 	std::shared_ptr<XmpPlayer<2>> xmp_inst_;
 	std::optional<Resampler<2>> resampler_;
-	bool playing_ {false};
 	bool looping_ {false};
 
+	// Fixed after loading
+	std::optional<audio::MusicType> type_;
+	std::optional<float> duration_;
+
+	// Audio callback, or the game thread holding the audio lock
+	bool playing_ {false};
+	std::optional<float> loop_point_;
+	float position_ {0.f};
+	MusicChunk* current_ {nullptr};
+	size_t current_offset_ {0};
+	uint32_t generation_ {0};
+
 	// fade control
 	float gain_target_ {1.f};
 	float gain_ {1.f};
@@ -299,12 +373,226 @@ private:
 	uint64_t gain_samples_ {0};
 	uint64_t gain_samples_target_ {1};
 
+	// Shared between the two sides
+	std::unique_ptr<MusicChunk[]> chunks_;
+	SpScQueue<MusicChunk*> free_chunks_ {kChunkCount}; // to the decoder
+	SpScQueue<MusicChunk*> filled_chunks_ {kChunkCount}; // to the callback
+	SpScQueue<MusicControl> controls_ {kControlCapacity}; // to the decoder
+	std::atomic<bool> quit_ {false};
+	std::atomic<bool> sleeping_ {false};
+	std::mutex wake_mutex_;
+	std::condition_variable wake_cv_;
+	std::thread decode_thread_;
+
 	float current_fade_gain(uint64_t i) const
 	{
 		const float alpha = 1.0 - (gain_samples_target_ - std::min(gain_samples_ + i, gain_samples_target_)) /
 									  static_cast<double>(gain_samples_target_);
 		return (gain_target_ - gain_) * std::clamp(alpha, 0.f, 1.f) + gain_;
 	}
+
+	// Pairs with the fence in decode_loop: either the decoder sees what was
+	// just pushed before it sleeps, or this sees it asleep and takes the
+	// mutex to notify. The lock is only taken when the decoder is idle.
+	void wake_decoder()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleeping_.load(std::memory_order_relaxed))
+		{
+			std::lock_guard<std::mutex> lock {wake_mutex_};
+			wake_cv_.notify_one();
+		}
+	}
+
+	void push_control(const MusicControl& control)
+	{
+		// The decoder drains these every chunk, so this only fails if it
+		// has stopped running entirely.
+		if (controls_.push(control))
+		{
+			wake_decoder();
+		}
+	}
+
+	// Discards everything decoded so far, then sends a control that starts
+	// a new generation. Chunks the decoder tags with an older generation
+	// are dropped as they arrive.
+	void flush(MusicControl control)
+	{
+		if (current_)
+		{
+			free_chunks_.push(current_);
+			current_ = nullptr;
+		}
+
+		while (std::optional<MusicChunk*> chunk = filled_chunks_.pop())
+		{
+			free_chunks_.push(*chunk);
+		}
+
+		control.generation = ++generation_;
+		push_control(control);
+	}
+
+	MusicChunk* next_chunk()
+	{
+		while (std::optional<MusicChunk*> chunk = filled_chunks_.pop())
+		{
+			if ((*chunk)->generation == generation_)
+			{
+				return *chunk;
+			}
+
+			free_chunks_.push(*chunk);
+		}
+
+		return nullptr;
+	}
+
+	float decoder_position() const
+	{
+		if (ogg_inst_)
+			return ogg_inst_->position_seconds();
+		if (xmp_inst_)
+			return xmp_inst_->position_seconds();
+
+		return 0.f;
+	}
+
+	// Decode thread only; set by kStop, cleared by kPlay.
+	bool stopped_ {true};
+
+	// Ends with a non-looping song stop the instance on their own.
+	void resume_instance()
+	{
+		if (ogg_inst_)
+			ogg_inst_->playing(true);
+	}
+
+	// Returns whether the decoder should keep producing.
+	bool apply_control(const MusicControl& control, bool active)
+	{
+		switch (control.type)
+		{
+		case MusicControlType::kPlay:
+			if (ogg_inst_)
+			{
+				ogg_inst_->looping(control.looping);
+				ogg_inst_->playing(true);
+				ogg_inst_->reset();
+			}
+			else if (xmp_inst_)
+			{
+				xmp_inst_->looping(control.looping);
+				xmp_inst_->reset();
+			}
+			stopped_ = false;
+			return true;
+		case MusicControlType::kStop:
+			if (ogg_inst_)
+			{
+				ogg_inst_->reset();
+				ogg_inst_->playing(false);
+			}
+			else if (xmp_inst_)
+			{
+				xmp_inst_->reset();
+			}
+			stopped_ = true;
+			return false;
+		case MusicControlType::kSeek:
+			if (ogg_inst_)
+				ogg_inst_->seek(control.value);
+			else if (xmp_inst_)
+				xmp_inst_->seek(control.value);
+			// The song may already have been decoded to its end; seeking while
+			// playing has to start the decoder again.
+			if (!control.active || stopped_)
+				return false;
+			resume_instance();
+			return true;
+		case MusicControlType::kLoopPoint:
+			if (ogg_inst_)
+				ogg_inst_->loop_point_seconds(control.value);
+			return active;
+		case MusicControlType::kPause:
+			return false;
+		case MusicControlType::kResume:
+			// Chunks already queued stay valid, so just carry on from here.
+			return !stopped_;
+		}
+
+		return active;
+	}
+
+	void decode_loop()
+	{
+		tracy::SetThreadName("Music Decode Thread");
+
+		bool active = false;
+		uint32_t generation = 0;
+
+		while (!quit_.load(std::memory_order_relaxed))
+		{
+			while (std::optional<MusicControl> control = controls_.pop())
+			{
+				generation = control->generation;
+				active = apply_control(*control, active);
+			}
+
+			std::optional<MusicChunk*> chunk = active ? free_chunks_.pop() : std::nullopt;
+
+			if (!chunk)
+			{
+				// Sleep until a control arrives or, while active, a chunk is
+				// handed back. Paused or stopped, only a control wakes us.
+				std::unique_lock<std::mutex> lock {wake_mutex_};
+				sleeping_.store(true, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				wake_cv_.wait(
+					lock,
+					[this, active]
+					{
+						return quit_.load(std::memory_order_relaxed) || !controls_.empty() ||
+							(active && !free_chunks_.empty());
+					}
+				);
+				sleeping_.store(false, std::memory_order_relaxed);
+				continue;
+			}
+
+			MusicChunk* c = *chunk;
+			c->generation = generation;
+			c->position = decoder_position();
+			c->count = 0;
+
+			try
+			{
+				while (c->count < kChunkFrames)
+				{
+					const size_t generated = resampler_->generate(tcb::span {c->frames}.subspan(c->count));
+
+					if (generated == 0)
+						break;
+
+					c->count += generated;
+				}
+			}
+			catch (...)
+			{
+				// Treat a broken stream as the end of the song.
+			}
+
+			c->end = c->count < kChunkFrames;
+
+			if (c->end)
+			{
+				active = false;
+			}
+
+			filled_chunks_.push(c);
+		}
+	}
 };
 
 // The special member functions MUST be declared in this unit, where Impl is complete.
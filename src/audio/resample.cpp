@@ -16,6 +16,8 @@
 #include <utility>
 #include <vector>
 
+#include "kernels.hpp"
+
 using std::shared_ptr;
 using std::size_t;
 using std::vector;
@@ -77,9 +79,15 @@ size_t Resampler<C>::generate(tcb::span<Sample<C>> buffer)
 			continue;
 		}
 
-		buffer[written] = (buf_[pos_ + 1] - buf_[pos_]) * pos_frac_ + buf_[pos_];
-		advance(ratio_);
-		written++;
+		written += kernels::resample_linear<C>(
+			reinterpret_cast<float*>(buffer.data() + written),
+			buffer.size() - written,
+			reinterpret_cast<const float*>(buf_.data()),
+			buf_.size(),
+			pos_,
+			pos_frac_,
+			ratio_
+		);
 	}
 
 	return written;
@@ -51,9 +51,9 @@ private:
 
 	void advance(float samples)
 	{
+		// pos_frac_ stays non-negative, so truncation is floor
 		pos_frac_ += samples;
-		float integer;
-		std::modf(pos_frac_, &integer);
+		int integer = static_cast<int>(pos_frac_);
 		pos_ += integer;
 		pos_frac_ -= integer;
 	}
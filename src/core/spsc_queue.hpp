@@ -0,0 +1,85 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_CORE_SPSC_QUEUE_HPP__
+#define __SRB2_CORE_SPSC_QUEUE_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+#include "../cxxutil.hpp"
+
+namespace srb2
+{
+
+/// @brief Fixed-capacity, wait-free ring buffer for exactly one producer thread and one consumer thread.
+/// Unlike SpMcQueue it never allocates after construction, so it is safe to consume from a realtime thread.
+template <typename T>
+class SpScQueue
+{
+	std::unique_ptr<T[]> buffer_;
+	size_t mask_;
+
+	alignas(64) std::atomic<size_t> head_; // next slot to pop, written by the consumer
+	alignas(64) std::atomic<size_t> tail_; // next slot to push, written by the producer
+
+public:
+	explicit SpScQueue(size_t capacity) : buffer_(new T[capacity]), mask_(capacity - 1), head_(0), tail_(0)
+	{
+		SRB2_ASSERT(capacity && (!(capacity & (capacity - 1))) && "Capacity must be a power of 2!");
+	}
+
+	SpScQueue(const SpScQueue&) = delete;
+	SpScQueue& operator=(const SpScQueue&) = delete;
+
+	size_t capacity() const noexcept { return mask_ + 1; }
+
+	bool empty() const noexcept
+	{
+		return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+	}
+
+	/// @brief Producer only. Returns false without modifying the queue if it is full.
+	bool push(const T& v) noexcept
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		size_t head = head_.load(std::memory_order_acquire);
+
+		if (tail - head > mask_)
+		{
+			return false;
+		}
+
+		buffer_[tail & mask_] = v;
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// @brief Consumer only.
+	std::optional<T> pop() noexcept
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+		size_t tail = tail_.load(std::memory_order_acquire);
+
+		if (head == tail)
+		{
+			return std::nullopt;
+		}
+
+		T v = buffer_[head & mask_];
+		head_.store(head + 1, std::memory_order_release);
+		return v;
+	}
+};
+
+} // namespace srb2
+
+#endif // __SRB2_CORE_SPSC_QUEUE_HPP__
@@ -40,7 +40,7 @@ static void do_work(ThreadPool::Task& work)
 	(work.deleter)(work.raw.data());
 	if (work.pseudosema)
 	{
-		work.pseudosema->fetch_sub(1, std::memory_order_relaxed);
+		work.pseudosema->fetch_sub(1, std::memory_order_release);
 	}
 }
 
@@ -344,3 +344,32 @@ void I_ThreadPoolWaitIdle(void)
 
 	g_main_threadpool->wait_idle();
 }
+
+struct srb2ctask_s
+{
+	ThreadPool::Sema sema;
+};
+
+srb2ctask_t* I_ThreadPoolSubmitTask(srb2cthunk_t thunk, void* data)
+{
+	SRB2_ASSERT(g_main_threadpool != nullptr);
+
+	srb2ctask_t* task = new srb2ctask_t;
+
+	g_main_threadpool->begin_sema();
+	g_main_threadpool->schedule([=]() {
+		(thunk)(data);
+	});
+	task->sema = g_main_threadpool->end_sema();
+	g_main_threadpool->notify_sema(task->sema);
+
+	return task;
+}
+
+void I_ThreadPoolWaitTask(srb2ctask_t* task)
+{
+	SRB2_ASSERT(g_main_threadpool != nullptr);
+
+	g_main_threadpool->wait_sema(task->sema);
+	delete task;
+}
@@ -150,12 +150,18 @@ extern "C" {
 #endif // __cplusplus
 
 typedef void (*srb2cthunk_t)(void*);
+typedef struct srb2ctask_s srb2ctask_t;
 
 void I_ThreadPoolInit(void);
 void I_ThreadPoolShutdown(void);
 void I_ThreadPoolSubmit(srb2cthunk_t thunk, void* data);
 void I_ThreadPoolWaitIdle(void);
 
+/// Like I_ThreadPoolSubmit, but the task can be joined on its own with
+/// I_ThreadPoolWaitTask, which must be called exactly once.
+srb2ctask_t* I_ThreadPoolSubmitTask(srb2cthunk_t thunk, void* data);
+void I_ThreadPoolWaitTask(srb2ctask_t* task);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -42,6 +42,8 @@
 #include "y_inter.h"
 #include "r_local.h"
 #include "m_argv.h"
+#include "m_bench.h"
+#include "g_demoverify.h"
 #include "p_setup.h"
 #include "lzf.h"
 #include "lua_script.h"
@@ -6167,6 +6169,10 @@ boolean TryRunTics(tic_t realtics)
 
 			ps_tictime = I_GetPreciseTime() - ps_tictime;
 
+			M_BenchmarkTic();
+
+			G_VerifyDemosTic(consistancy[gametic % BACKUPTICS]);
+
 			// Leave a certain amount of tics present in the net buffer as long as we've ran at least one tic this frame.
 			if (client && gamestate == GS_LEVEL && leveltime > 1 && neededtic <= gametic + cv_netticbuffer.value)
 			{
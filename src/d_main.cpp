@@ -48,6 +48,8 @@
 #include "i_threads.h"
 #include "i_video.h"
 #include "m_argv.h"
+#include "m_bench.h"
+#include "g_demoverify.h"
 #include "k_menu.h"
 #include "m_misc.h"
 #include "p_setup.h"
@@ -73,6 +75,7 @@
 #include "g_input.h" // tutorial mode control scheming
 #include "m_perfstats.h"
 #include "core/memory.h"
+#include "io/save_queue.hpp"
 
 #include "monocypher/monocypher.h"
 #include "stun.h"
@@ -626,10 +629,7 @@ static bool D_Display(bool world)
 
 				if (rendermode == render_soft)
 				{
-					for (i = 0; i <= r_splitscreen; i++)
-					{
-						R_ApplyViewMorph(i);
-					}
+					R_ApplyViewMorphs();
 				}
 
 				ps_rendercalltime = I_GetPreciseTime() - ps_rendercalltime;
@@ -825,6 +825,9 @@ static bool D_Display(bool world)
 		ps_swaptime = I_GetPreciseTime();
 		I_FinishUpdate(); // page flip or blit buffer
 		ps_swaptime = I_GetPreciseTime() - ps_swaptime;
+
+		if (demo.timing)
+			M_BenchmarkFrame();
 	}
 
 	return ranwipe;
@@ -897,6 +900,7 @@ void D_SRB2Loop(void)
 		g_dc = {};
 		Z_Frame_Reset();
 		srb2::r_debug::clear_frame_list();
+		srb2::io::poll_saves();
 
 		{
 			// Casting the return value of a function is bad practice (apparently)
@@ -1625,6 +1629,18 @@ void D_SRB2Main(void)
 		}
 	}
 
+	// Replay verification farm: the parent process only hands the demo list
+	// out to worker processes, and never starts the game itself.
+	if (M_CheckParm("-verifydemos") && !M_CheckParm("-verifyworker"))
+	{
+		INT32 status = G_VerifyDemosRunWorkers();
+		if (status >= 0)
+		{
+			I_ShutdownSystem();
+			exit(status);
+		}
+	}
+
 	M_LoadJoinedIPs();	// load joined ips
 
 	// Create addons dir
@@ -1998,6 +2014,23 @@ void D_SRB2Main(void)
 	if (!autostart)
 		M_PushSpecialParameters(); // push all "+" parameters at the command buffer
 
+	if (G_VerifyDemosStart())
+	{
+		G_SetGamestate(GS_NULL);
+		wipegamestate = GS_NULL;
+		return;
+	}
+
+	if (M_CheckParm("-benchmark") && M_IsNextParm())
+	{
+		if (M_BenchmarkStart(M_GetNextParm()))
+		{
+			G_SetGamestate(GS_NULL);
+			wipegamestate = GS_NULL;
+			return;
+		}
+	}
+
 	// demo doesn't need anymore to be added with D_AddFile()
 	p = M_CheckParm("-playdemo");
 	if (!p)
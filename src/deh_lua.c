@@ -111,6 +111,7 @@ static inline int lib_freeslot(lua_State *L)
 					CONS_Printf("State S_%s allocated.\n",word);
 					FREE_STATES[i] = Z_Malloc(strlen(word)+1, PU_STATIC, NULL);
 					strcpy(FREE_STATES[i],word);
+					DEH_AddName(DEHNAME_STATE, word, S_FIRSTFREESLOT + i);
 					freeslotusage[0][0]++;
 					lua_pushinteger(L, S_FIRSTFREESLOT + i);
 					r++;
@@ -127,6 +128,7 @@ static inline int lib_freeslot(lua_State *L)
 					CONS_Printf("MobjType MT_%s allocated.\n",word);
 					FREE_MOBJS[i] = Z_Malloc(strlen(word)+1, PU_STATIC, NULL);
 					strcpy(FREE_MOBJS[i],word);
+					DEH_AddName(DEHNAME_MOBJTYPE, word, MT_FIRSTFREESLOT + i);
 					freeslotusage[1][0]++;
 					lua_pushinteger(L, MT_FIRSTFREESLOT + i);
 					r++;
@@ -143,6 +145,7 @@ static inline int lib_freeslot(lua_State *L)
 					CONS_Printf("Skincolor SKINCOLOR_%s allocated.\n",word);
 					FREE_SKINCOLORS[i] = Z_Malloc(strlen(word)+1, PU_STATIC, NULL);
 					strcpy(FREE_SKINCOLORS[i],word);
+					DEH_AddName(DEHNAME_SKINCOLOR, word, SKINCOLOR_FIRSTFREESLOT + i);
 					skincolors[i].cache_spraycan = UINT16_MAX;
 					numskincolors++;
 					lua_pushinteger(L, SKINCOLOR_FIRSTFREESLOT + i);
@@ -437,19 +440,11 @@ static inline int lib_getenum(lua_State *L)
 			lua_pushinteger(L, S_FIRSTFREESLOT);
 			return 1;
 		}
-		for (i = 0; i < NUMSTATEFREESLOTS; i++) {
-			if (!FREE_STATES[i])
-				break;
-			if (fastcmp(p, FREE_STATES[i])) {
-				lua_pushinteger(L, S_FIRSTFREESLOT+i);
-				return 1;
-			}
+		i = DEH_FindName(DEHNAME_STATE, p);
+		if (i != -1) {
+			lua_pushinteger(L, i);
+			return 1;
 		}
-		for (i = 0; i < S_FIRSTFREESLOT; i++)
-			if (fastcmp(p, STATE_LIST[i]+2)) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
 		return luaL_error(L, "state '%s' does not exist.\n", word);
 	}
 	else if (fastncmp("MT_",word,3)) {
@@ -459,19 +454,11 @@ static inline int lib_getenum(lua_State *L)
 			lua_pushinteger(L, MT_FIRSTFREESLOT);
 			return 1;
 		}
-		for (i = 0; i < NUMMOBJFREESLOTS; i++) {
-			if (!FREE_MOBJS[i])
-				break;
-			if (fastcmp(p, FREE_MOBJS[i])) {
-				lua_pushinteger(L, MT_FIRSTFREESLOT+i);
-				return 1;
-			}
+		i = DEH_FindName(DEHNAME_MOBJTYPE, p);
+		if (i != -1) {
+			lua_pushinteger(L, i);
+			return 1;
 		}
-		for (i = 0; i < MT_FIRSTFREESLOT; i++)
-			if (fastcmp(p, MOBJTYPE_LIST[i]+3)) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
 		return luaL_error(L, "mobjtype '%s' does not exist.\n", word);
 	}
 	else if (fastncmp("SPR_",word,4)) {
@@ -512,7 +499,16 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (fastncmp("sfx_",word,4)) {
 		p = word+4;
-		for (i = 0; i < NUMSFX; i++)
+		// The index is case insensitive, so only scan for an exact
+		// match when the first match differs in case.
+		i = DEH_FindName(DEHNAME_SFX, p);
+		if (i == -1)
+			return 0;
+		if (fastcmp(p, S_sfx[i].name)) {
+			lua_pushinteger(L, i);
+			return 1;
+		}
+		for (i++; i < NUMSFX; i++)
 			if (S_sfx[i].name && fastcmp(p, S_sfx[i].name)) {
 				lua_pushinteger(L, i);
 				return 1;
@@ -521,20 +517,20 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (mathlib && fastncmp("SFX_",word,4)) { // SOCs are ALL CAPS!
 		p = word+4;
-		for (i = 0; i < NUMSFX; i++)
-			if (S_sfx[i].name && fasticmp(p, S_sfx[i].name)) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
+		i = DEH_FindName(DEHNAME_SFX, p);
+		if (i != -1) {
+			lua_pushinteger(L, i);
+			return 1;
+		}
 		return luaL_error(L, "sfx '%s' could not be found.\n", word);
 	}
 	else if (mathlib && fastncmp("DS",word,2)) {
 		p = word+2;
-		for (i = 0; i < NUMSFX; i++)
-			if (S_sfx[i].name && fasticmp(p, S_sfx[i].name)) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
+		i = DEH_FindName(DEHNAME_SFX, p);
+		if (i != -1) {
+			lua_pushinteger(L, i);
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "sfx '%s' could not be found.\n", word);
 		return 0;
 	}
@@ -558,19 +554,11 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (fastncmp("SKINCOLOR_",word,10)) {
 		p = word+10;
-		for (i = 0; i < NUMCOLORFREESLOTS; i++) {
-			if (!FREE_SKINCOLORS[i])
-				break;
-			if (fastcmp(p, FREE_SKINCOLORS[i])) {
-				lua_pushinteger(L, SKINCOLOR_FIRSTFREESLOT+i);
-				return 1;
-			}
+		i = DEH_FindName(DEHNAME_SKINCOLOR, p);
+		if (i != -1) {
+			lua_pushinteger(L, i);
+			return 1;
 		}
-		for (i = 0; i < SKINCOLOR_FIRSTFREESLOT; i++)
-			if (fastcmp(p, COLOR_ENUMS[i])) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
 		return luaL_error(L, "skincolor '%s' could not be found.\n", word);
 	}
 	else if (fastncmp("PRECIP_",word,7)) {
@@ -306,6 +306,7 @@ void readfreeslots(MYFILE *f)
 						CONS_Printf("State S_%s allocated.\n",word);
 						FREE_STATES[i] = Z_Malloc(strlen(word)+1, PU_STATIC, NULL);
 						strcpy(FREE_STATES[i],word);
+						DEH_AddName(DEHNAME_STATE, word, S_FIRSTFREESLOT+i);
 						freeslotusage[0][0]++;
 						break;
 					}
@@ -320,6 +321,7 @@ void readfreeslots(MYFILE *f)
 						CONS_Printf("MobjType MT_%s allocated.\n",word);
 						FREE_MOBJS[i] = Z_Malloc(strlen(word)+1, PU_STATIC, NULL);
 						strcpy(FREE_MOBJS[i],word);
+						DEH_AddName(DEHNAME_MOBJTYPE, word, MT_FIRSTFREESLOT+i);
 						freeslotusage[1][0]++;
 						break;
 					}
@@ -334,6 +336,7 @@ void readfreeslots(MYFILE *f)
 						CONS_Printf("Skincolor SKINCOLOR_%s allocated.\n",word);
 						FREE_SKINCOLORS[i] = Z_Malloc(strlen(word)+1, PU_STATIC, NULL);
 						strcpy(FREE_SKINCOLORS[i],word);
+						DEH_AddName(DEHNAME_SKINCOLOR, word, SKINCOLOR_FIRSTFREESLOT+i);
 						skincolors[i].cache_spraycan = UINT16_MAX;
 						numskincolors++;
 						break;
@@ -4566,60 +4569,42 @@ void readweather(MYFILE *f, INT32 num)
 
 mobjtype_t get_mobjtype(const char *word)
 { // Returns the value of MT_ enumerations
-	mobjtype_t i;
+	INT32 i;
 	if (*word >= '0' && *word <= '9')
 		return atoi(word);
 	if (fastncmp("MT_",word,3))
 		word += 3; // take off the MT_
-	for (i = 0; i < NUMMOBJFREESLOTS; i++) {
-		if (!FREE_MOBJS[i])
-			break;
-		if (fastcmp(word, FREE_MOBJS[i]))
-			return MT_FIRSTFREESLOT+i;
-	}
-	for (i = 0; i < MT_FIRSTFREESLOT; i++)
-		if (fastcmp(word, MOBJTYPE_LIST[i]+3))
-			return i;
+	i = DEH_FindName(DEHNAME_MOBJTYPE, word);
+	if (i != -1)
+		return i;
 	deh_warning("Couldn't find mobjtype named 'MT_%s'",word);
 	return MT_NULL;
 }
 
 statenum_t get_state(const char *word)
 { // Returns the value of S_ enumerations
-	statenum_t i;
+	INT32 i;
 	if (*word >= '0' && *word <= '9')
 		return atoi(word);
 	if (fastncmp("S_",word,2))
 		word += 2; // take off the S_
-	for (i = 0; i < NUMSTATEFREESLOTS; i++) {
-		if (!FREE_STATES[i])
-			break;
-		if (fastcmp(word, FREE_STATES[i]))
-			return S_FIRSTFREESLOT+i;
-	}
-	for (i = 0; i < S_FIRSTFREESLOT; i++)
-		if (fastcmp(word, STATE_LIST[i]+2))
-			return i;
+	i = DEH_FindName(DEHNAME_STATE, word);
+	if (i != -1)
+		return i;
 	deh_warning("Couldn't find state named 'S_%s'",word);
 	return S_NULL;
 }
 
 skincolornum_t get_skincolor(const char *word)
 { // Returns the value of SKINCOLOR_ enumerations
-	skincolornum_t i;
+	INT32 i;
 	if (*word >= '0' && *word <= '9')
 		return atoi(word);
 	if (fastncmp("SKINCOLOR_",word,10))
 		word += 10; // take off the SKINCOLOR_
-	for (i = 0; i < NUMCOLORFREESLOTS; i++) {
-		if (!FREE_SKINCOLORS[i])
-			break;
-		if (fastcmp(word, FREE_SKINCOLORS[i]))
-			return SKINCOLOR_FIRSTFREESLOT+i;
-	}
-	for (i = 0; i < SKINCOLOR_FIRSTFREESLOT; i++)
-		if (fastcmp(word, COLOR_ENUMS[i]))
-			return i;
+	i = DEH_FindName(DEHNAME_SKINCOLOR, word);
+	if (i != -1)
+		return i;
 	deh_warning("Couldn't find skincolor named 'SKINCOLOR_%s'",word);
 	return SKINCOLOR_GREEN;
 }
@@ -4654,16 +4639,16 @@ playersprite_t get_sprite2(const char *word)
 
 sfxenum_t get_sfx(const char *word)
 { // Returns the value of SFX_ enumerations
-	sfxenum_t i;
+	INT32 i;
 	if (*word >= '0' && *word <= '9')
 		return atoi(word);
 	if (fastncmp("SFX_",word,4))
 		word += 4; // take off the SFX_
 	else if (fastncmp("DS",word,2))
 		word += 2; // take off the DS
-	for (i = 0; i < NUMSFX; i++)
-		if (S_sfx[i].name && fasticmp(word, S_sfx[i].name))
-			return i;
+	i = DEH_FindName(DEHNAME_SFX, word);
+	if (i != -1)
+		return i;
 	deh_warning("Couldn't find sfx named 'SFX_%s'",word);
 	return sfx_None;
 }
@@ -26,6 +26,8 @@
 #include "k_boss.h" // spottype_t (for lua)
 
 #include "deh_tables.h"
+#include "fastcmp.h"
+#include "z_zone.h"
 
 char *FREE_STATES[NUMSTATEFREESLOTS];
 char *FREE_MOBJS[NUMMOBJFREESLOTS];
@@ -5173,3 +5175,180 @@ void DEH_TableCheck(void)
 		I_Error("You forgot to update the Dehacked colors list, you dolt!\n(%d colors defined, versus %s in the Dehacked list)\n", SKINCOLOR_FIRSTFREESLOT, sizeu1(dehcolors));
 #endif
 }
+
+// Name -> enum indexes, so resolving a name doesn't scan thousands of list
+// entries. Only values are stored; names are read back from the lists, so an
+// entry whose name has since changed (sfx freeslots get renamed) just stops
+// matching. Every name that is set after an index is built must be added
+// with DEH_AddName.
+
+struct dehnameindex_s
+{
+	INT32 *values; // -1 = empty slot
+	UINT32 *hashes;
+	size_t capacity; // power of 2, 0 until built
+	size_t count;
+};
+
+static struct dehnameindex_s dehnameindex[NUMDEHNAMETYPES];
+
+static const char *DEH_NameOf(dehnametype_t type, INT32 value)
+{
+	switch (type)
+	{
+		case DEHNAME_STATE:
+			return value < S_FIRSTFREESLOT ? STATE_LIST[value]+2 : FREE_STATES[value-S_FIRSTFREESLOT];
+		case DEHNAME_MOBJTYPE:
+			return value < MT_FIRSTFREESLOT ? MOBJTYPE_LIST[value]+3 : FREE_MOBJS[value-MT_FIRSTFREESLOT];
+		case DEHNAME_SKINCOLOR:
+			return value < SKINCOLOR_FIRSTFREESLOT ? COLOR_ENUMS[value] : FREE_SKINCOLORS[value-SKINCOLOR_FIRSTFREESLOT];
+		case DEHNAME_SFX:
+			return S_sfx[value].name;
+		default:
+			return NULL;
+	}
+}
+
+static boolean DEH_NameMatches(dehnametype_t type, INT32 value, const char *name)
+{
+	const char *n = DEH_NameOf(type, value);
+
+	if (!n)
+		return false;
+
+	// SOC sound names are case insensitive
+	return (type == DEHNAME_SFX) ? fasticmp(n, name) : fastcmp(n, name);
+}
+
+// Which of two values with the same name the old list scans found first:
+// freeslots before the built-in list, then the lower value.
+static boolean DEH_NameBefore(dehnametype_t type, INT32 a, INT32 b)
+{
+	INT32 firstfree;
+
+	switch (type)
+	{
+		case DEHNAME_STATE: firstfree = S_FIRSTFREESLOT; break;
+		case DEHNAME_MOBJTYPE: firstfree = MT_FIRSTFREESLOT; break;
+		case DEHNAME_SKINCOLOR: firstfree = SKINCOLOR_FIRSTFREESLOT; break;
+		default: return a < b;
+	}
+
+	if ((a >= firstfree) != (b >= firstfree))
+		return a >= firstfree;
+
+	return a < b;
+}
+
+static void DEH_InsertName(struct dehnameindex_s *index, UINT32 hash, INT32 value)
+{
+	size_t mask = index->capacity - 1;
+	size_t i;
+
+	for (i = hash & mask; index->values[i] != -1; i = (i + 1) & mask)
+	{
+		if (index->values[i] == value && index->hashes[i] == hash)
+			return; // already there
+	}
+
+	index->values[i] = value;
+	index->hashes[i] = hash;
+	index->count++;
+}
+
+static void DEH_GrowNameIndex(struct dehnameindex_s *index, size_t capacity)
+{
+	struct dehnameindex_s old = *index;
+	size_t i;
+
+	index->values = Z_Malloc(capacity * sizeof (*index->values), PU_STATIC, NULL);
+	index->hashes = Z_Malloc(capacity * sizeof (*index->hashes), PU_STATIC, NULL);
+	memset(index->values, -1, capacity * sizeof (*index->values));
+	index->capacity = capacity;
+	index->count = 0;
+
+	for (i = 0; i < old.capacity; i++)
+	{
+		if (old.values[i] != -1)
+			DEH_InsertName(index, old.hashes[i], old.values[i]);
+	}
+
+	Z_Free(old.values);
+	Z_Free(old.hashes);
+}
+
+void DEH_AddName(dehnametype_t type, const char *name, INT32 value)
+{
+	struct dehnameindex_s *index = &dehnameindex[type];
+
+	if (!index->capacity || !name)
+		return; // picked up when the index is built
+
+	// keep it at most half full
+	if ((index->count + 1) * 2 > index->capacity)
+		DEH_GrowNameIndex(index, index->capacity * 2);
+
+	DEH_InsertName(index, quickncasehash(name, SIZE_MAX), value);
+}
+
+static void DEH_BuildNameIndex(dehnametype_t type)
+{
+	INT32 i;
+
+	DEH_GrowNameIndex(&dehnameindex[type], 1024);
+
+	switch (type)
+	{
+		case DEHNAME_STATE:
+			for (i = 0; i < S_FIRSTFREESLOT; i++)
+				DEH_AddName(type, STATE_LIST[i]+2, i);
+			for (i = 0; i < NUMSTATEFREESLOTS && FREE_STATES[i]; i++)
+				DEH_AddName(type, FREE_STATES[i], S_FIRSTFREESLOT+i);
+			break;
+		case DEHNAME_MOBJTYPE:
+			for (i = 0; i < MT_FIRSTFREESLOT; i++)
+				DEH_AddName(type, MOBJTYPE_LIST[i]+3, i);
+			for (i = 0; i < NUMMOBJFREESLOTS && FREE_MOBJS[i]; i++)
+				DEH_AddName(type, FREE_MOBJS[i], MT_FIRSTFREESLOT+i);
+			break;
+		case DEHNAME_SKINCOLOR:
+			for (i = 0; i < SKINCOLOR_FIRSTFREESLOT; i++)
+				DEH_AddName(type, COLOR_ENUMS[i], i);
+			for (i = 0; i < NUMCOLORFREESLOTS && FREE_SKINCOLORS[i]; i++)
+				DEH_AddName(type, FREE_SKINCOLORS[i], SKINCOLOR_FIRSTFREESLOT+i);
+			break;
+		case DEHNAME_SFX:
+			for (i = 0; i < NUMSFX; i++)
+				DEH_AddName(type, S_sfx[i].name, i);
+			break;
+		default:
+			break;
+	}
+}
+
+INT32 DEH_FindName(dehnametype_t type, const char *name)
+{
+	struct dehnameindex_s *index = &dehnameindex[type];
+	UINT32 hash = quickncasehash(name, SIZE_MAX);
+	INT32 found = -1;
+	size_t mask;
+	size_t i;
+
+	if (!index->capacity)
+		DEH_BuildNameIndex(type);
+
+	mask = index->capacity - 1;
+
+	for (i = hash & mask; index->values[i] != -1; i = (i + 1) & mask)
+	{
+		INT32 value = index->values[i];
+
+		if (index->hashes[i] != hash || !DEH_NameMatches(type, value, name))
+			continue;
+
+		if (found == -1 || DEH_NameBefore(type, value, found))
+			found = value;
+	}
+
+	return found;
+}
@@ -81,6 +81,22 @@ extern struct int_const_s const INT_CONST[];
 // Moved to this file because it can't work compile-time otherwise
 void DEH_TableCheck(void);
 
+typedef enum
+{
+	DEHNAME_STATE, // without S_
+	DEHNAME_MOBJTYPE, // without MT_
+	DEHNAME_SKINCOLOR, // without SKINCOLOR_
+	DEHNAME_SFX, // without sfx_, any case
+	NUMDEHNAMETYPES
+} dehnametype_t;
+
+// Hashed name lookups, built on first use.
+// Returns the value the list scans would have found, or -1.
+INT32 DEH_FindName(dehnametype_t type, const char *name);
+
+// Call whenever a freeslot or sound gets (re)named.
+void DEH_AddName(dehnametype_t type, const char *name, INT32 value);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
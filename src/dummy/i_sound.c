@@ -20,6 +20,12 @@ void *I_GetSfx(sfxinfo_t *sfx)
 	return NULL;
 }
 
+void I_GetSfxBatch(sfxinfo_t **sfx, size_t count)
+{
+	(void)sfx;
+	(void)count;
+}
+
 void I_FreeSfx(sfxinfo_t *sfx)
 {
 	(void)sfx;
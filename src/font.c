@@ -17,6 +17,7 @@
 
 font_t       fontv[MAX_FONTS];
 int          fontc;
+UINT32       fontgeneration;
 
 static void
 FontCache (font_t *fnt)
@@ -34,6 +35,8 @@ FontCache (font_t *fnt)
 				fnt->digits,
 				c);
 	}
+
+	fontgeneration++;
 }
 
 void
@@ -34,6 +34,12 @@ struct font_t
 extern font_t fontv[MAX_FONTS];
 extern int    fontc;
 
+/*
+Bumped every time glyph patches are (re)loaded, so
+anything measured from them can tell it is stale.
+*/
+extern UINT32 fontgeneration;
+
 /*
 Reloads already registered fonts.
 */
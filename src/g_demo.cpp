@@ -33,10 +33,12 @@
 #include "r_main.h"
 #include "g_game.h"
 #include "g_demo.h"
+#include "g_demoverify.h"
 #include "m_misc.h"
 #include "m_cond.h"
 #include "k_menu.h"
 #include "m_argv.h"
+#include "m_bench.h"
 #include "hu_stuff.h"
 #include "z_zone.h"
 #include "i_video.h"
@@ -3947,6 +3949,7 @@ void G_TimeDemo(const char *name)
 void G_DoneLevelLoad(void)
 {
 	CONS_Printf(M_GetText("Loaded level in %f sec\n"), (double)(I_GetTime() - demostarttime) / TICRATE);
+	M_BenchmarkLevelLoaded(I_GetTime() - demostarttime);
 	framecount = 0;
 	demostarttime = I_GetTime();
 }
@@ -4031,6 +4034,19 @@ static void G_StopTimingDemo(void)
 	if (restorecv_vidwait != cv_vidwait.value)
 		CV_SetValue(&cv_vidwait, restorecv_vidwait);
 
+	if (M_BenchmarkActive())
+	{
+		// Moves on to the next demo, or quits after the last one
+		M_BenchmarkDemoDone(leveltime, demotime);
+		return;
+	}
+
+	if (G_VerifyDemosActive())
+	{
+		G_VerifyDemosDone();
+		return;
+	}
+
 	if (timedemo_quit)
 		COM_ImmedExecute("quit");
 	else
@@ -68,6 +68,7 @@ extern "C" {
 extern consvar_t cv_recordmultiplayerdemos, cv_netdemosyncquality;
 
 extern tic_t demostarttime;
+extern boolean demosynced;
 
 struct democharlist_t {
 	char name[SKINNAMESIZE+1];
@@ -0,0 +1,426 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  g_demoverify.cpp
+/// \brief Batch replay verification
+///
+/// -verifydemos <list.txt> plays every demo in the list (one path per line)
+/// with no rendering or audio, as fast as the simulation runs. The list is
+/// split across -verifyjobs worker processes. For each demo the state hash
+/// of every tic (the same value Consistancy() sends to the server) is
+/// recorded, along with the first tic where playback drifted from the sync
+/// data stored in the demo. Passing an earlier result file with
+/// -verifyreference also reports the first tic whose hash differs from it.
+///
+/// Results are written to -verifyout (verify.json in the home folder by
+/// default). The process exits with status 1 if any demo failed.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#ifdef UNIXCOMMON
+#include <spawn.h>
+#include <sys/wait.h>
+extern char **environ;
+#endif
+
+#include "g_demoverify.h"
+#include "doomdef.h"
+#include "doomstat.h"
+#include "command.h"
+#include "d_main.h" // srb2home
+#include "d_netcmd.h" // timedemo_quit
+#include "g_demo.h"
+#include "g_game.h"
+#include "i_system.h"
+#include "m_argv.h"
+
+using nlohmann::json;
+
+namespace
+{
+
+struct VerifyResult
+{
+	std::string demo;
+	std::vector<UINT16> hashes;
+	INT32 firstdesync = -1;
+	std::string error;
+};
+
+struct Verifier
+{
+	std::vector<std::string> demos;
+	std::vector<VerifyResult> results;
+	std::unordered_map<std::string, std::string> reference;
+	std::string outpath;
+	size_t current = 0;
+	bool started = false;
+	tic_t waited = 0;
+	bool active = false;
+};
+
+Verifier g_verify;
+
+// How long a demo may take to start playing before it's given up on
+constexpr tic_t kStartTimeout = 10*TICRATE;
+
+std::vector<std::string> read_list(const char* path)
+{
+	std::vector<std::string> demos;
+	std::ifstream f(path);
+	std::string line;
+
+	while (std::getline(f, line))
+	{
+		while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t'))
+			line.pop_back();
+
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		demos.push_back(std::move(line));
+	}
+
+	return demos;
+}
+
+std::string out_path()
+{
+	if (M_CheckParm("-verifyout") && M_IsNextParm())
+		return M_GetNextParm();
+	return fmt::format("{}" PATHSEP "{}", srb2home, "verify.json");
+}
+
+std::string encode_hashes(const std::vector<UINT16>& hashes)
+{
+	std::string out;
+	out.reserve(hashes.size() * 4);
+	for (UINT16 h : hashes)
+		out += fmt::format("{:04x}", h);
+	return out;
+}
+
+// First tic where two hash strings disagree, or -1 if they are identical
+INT32 first_divergence(const std::string& a, const std::string& b)
+{
+	size_t len = std::min(a.size(), b.size());
+	for (size_t i = 0; i < len; i += 4)
+	{
+		if (a.compare(i, 4, b, i, 4) != 0)
+			return static_cast<INT32>(i / 4);
+	}
+	if (a.size() != b.size())
+		return static_cast<INT32>(len / 4);
+	return -1;
+}
+
+bool result_passed(const json& r)
+{
+	return r.value("error", "").empty() && r["firstdesync"].is_null() && r["firstdiverge"].is_null();
+}
+
+json result_json(const VerifyResult& r)
+{
+	std::string tichashes = encode_hashes(r.hashes);
+	UINT32 summary = 2166136261u; // FNV-1a over every tic hash
+
+	for (UINT16 h : r.hashes)
+	{
+		summary = (summary ^ (h & 0xFF)) * 16777619u;
+		summary = (summary ^ (h >> 8)) * 16777619u;
+	}
+
+	json out {
+		{"demo", r.demo},
+		{"tics", r.hashes.size()},
+		{"hash", fmt::format("{:08x}", summary)},
+		{"firstdesync", nullptr},
+		{"firstdiverge", nullptr},
+	};
+
+	if (r.firstdesync >= 0)
+		out["firstdesync"] = r.firstdesync;
+
+	auto it = g_verify.reference.find(r.demo);
+	if (it != g_verify.reference.end())
+	{
+		INT32 diverge = first_divergence(it->second, tichashes);
+		if (diverge >= 0)
+			out["firstdiverge"] = diverge;
+	}
+
+	if (!r.error.empty())
+		out["error"] = r.error;
+
+	out["tichashes"] = std::move(tichashes);
+	return out;
+}
+
+void write_results(const std::string& path, const json& demos)
+{
+	bool passed = std::all_of(demos.begin(), demos.end(), result_passed);
+	json out {
+		{"version", 1},
+		{"demos", demos},
+		{"passed", passed},
+	};
+
+	std::ofstream f(path);
+	f << out.dump(1, '\t') << '\n';
+}
+
+void load_reference()
+{
+	if (!(M_CheckParm("-verifyreference") && M_IsNextParm()))
+		return;
+
+	const char* path = M_GetNextParm();
+	try
+	{
+		json ref;
+		std::ifstream f(path);
+		f >> ref;
+
+		for (const json& r : ref.at("demos"))
+			g_verify.reference[r.at("demo").get<std::string>()] = r.value("tichashes", "");
+	}
+	catch (const std::exception& ex)
+	{
+		CONS_Alert(CONS_WARNING, "Replay verification: can't read reference %s: %s\n", path, ex.what());
+	}
+}
+
+void start_current_demo()
+{
+	g_verify.results.emplace_back();
+	g_verify.results.back().demo = g_verify.demos[g_verify.current];
+	g_verify.started = false;
+	g_verify.waited = 0;
+
+	CONS_Printf("Verifying demo '%s'.\n", g_verify.demos[g_verify.current].c_str());
+	G_TimeDemo(g_verify.demos[g_verify.current].c_str());
+
+	// Never render, even if -nodraw was not given
+	nodrawers = true;
+}
+
+void finish()
+{
+	json demos = json::array();
+	for (const VerifyResult& r : g_verify.results)
+		demos.push_back(result_json(r));
+
+	try
+	{
+		write_results(g_verify.outpath, demos);
+	}
+	catch (const std::exception& ex)
+	{
+		CONS_Alert(CONS_ERROR, "Replay verification: can't write %s: %s\n", g_verify.outpath.c_str(), ex.what());
+	}
+
+	g_verify.active = false;
+	COM_ImmedExecute("quit");
+}
+
+void next_demo()
+{
+	g_verify.current++;
+	if (g_verify.current < g_verify.demos.size())
+		start_current_demo();
+	else
+		finish();
+}
+
+} // namespace
+
+INT32 G_VerifyDemosRunWorkers(void)
+{
+#ifdef UNIXCOMMON
+	if (!(M_CheckParm("-verifydemos") && M_IsNextParm()))
+		return -1;
+
+	std::vector<std::string> demos = read_list(M_GetNextParm());
+	std::string outpath = out_path();
+	size_t jobs = std::max(std::thread::hardware_concurrency(), 1u);
+
+	if (M_CheckParm("-verifyjobs") && M_IsNextParm())
+		jobs = std::max(atoi(M_GetNextParm()), 1);
+	jobs = std::max<size_t>(std::min(jobs, demos.size()), 1);
+
+	// Workers never open a real window
+	setenv("SDL_VIDEODRIVER", "dummy", 0);
+
+	std::vector<pid_t> workers;
+	for (size_t i = 0; i < jobs; i++)
+	{
+		std::vector<std::string> args(myargv, myargv + myargc);
+		args.insert(args.end(), {"-verifyworker", std::to_string(i), std::to_string(jobs), "-nodraw", "-noaudio", "-noendtxt"});
+
+		std::vector<char*> argv;
+		for (std::string& arg : args)
+			argv.push_back(arg.data());
+		argv.push_back(nullptr);
+
+		pid_t pid;
+		if (posix_spawnp(&pid, myargv[0], nullptr, nullptr, argv.data(), environ) != 0)
+		{
+			CONS_Alert(CONS_ERROR, "Replay verification: couldn't start worker %s\n", sizeu1(i));
+			continue;
+		}
+		workers.push_back(pid);
+	}
+
+	for (pid_t pid : workers)
+	{
+		int status;
+		waitpid(pid, &status, 0);
+	}
+
+	// Merge each worker's share back into list order
+	json merged = json::array();
+	for (size_t i = 0; i < jobs; i++)
+	{
+		std::string partpath = fmt::format("{}.{}", outpath, i);
+		try
+		{
+			json part;
+			std::ifstream f(partpath);
+			f >> part;
+			for (json& r : part.at("demos"))
+				merged.push_back(std::move(r));
+		}
+		catch (const std::exception&)
+		{
+			// Worker crashed; its demos are reported as missing below
+		}
+		std::remove(partpath.c_str());
+	}
+
+	for (const std::string& demo : demos)
+	{
+		bool found = std::any_of(merged.begin(), merged.end(), [&](const json& r) { return r["demo"] == demo; });
+		if (!found)
+		{
+			merged.push_back({
+				{"demo", demo},
+				{"firstdesync", nullptr},
+				{"firstdiverge", nullptr},
+				{"error", "worker did not report a result"},
+			});
+		}
+	}
+
+	size_t failed = std::count_if(merged.begin(), merged.end(), [](const json& r) { return !result_passed(r); });
+
+	try
+	{
+		write_results(outpath, merged);
+	}
+	catch (const std::exception& ex)
+	{
+		I_OutputMsg("Replay verification: can't write %s: %s\n", outpath.c_str(), ex.what());
+		return 1;
+	}
+
+	I_OutputMsg("Verified %s demos, %s failed. Results saved to '%s'\n",
+		sizeu1(merged.size()), sizeu2(failed), outpath.c_str());
+
+	return failed ? 1 : 0;
+#else
+	return -1;
+#endif
+}
+
+boolean G_VerifyDemosStart(void)
+{
+	if (!(M_CheckParm("-verifydemos") && M_IsNextParm()))
+		return false;
+
+	std::vector<std::string> demos = read_list(M_GetNextParm());
+	size_t worker = 0;
+	size_t jobs = 1;
+
+	if (M_CheckParm("-verifyworker") && M_IsNextParm())
+	{
+		worker = atoi(M_GetNextParm());
+		if (M_IsNextParm())
+			jobs = std::max(atoi(M_GetNextParm()), 1);
+	}
+
+	g_verify.outpath = out_path();
+	if (M_CheckParm("-verifyworker"))
+		g_verify.outpath += fmt::format(".{}", worker);
+
+	for (size_t i = worker; i < demos.size(); i += jobs)
+		g_verify.demos.push_back(std::move(demos[i]));
+
+	load_reference();
+
+	g_verify.active = true;
+	g_verify.current = 0;
+	timedemo_quit = false;
+	timedemo_csv = false;
+
+	if (g_verify.demos.empty())
+	{
+		finish();
+		return true;
+	}
+
+	start_current_demo();
+	return true;
+}
+
+boolean G_VerifyDemosActive(void)
+{
+	return g_verify.active;
+}
+
+void G_VerifyDemosTic(INT16 statehash)
+{
+	if (!g_verify.active)
+		return;
+
+	VerifyResult& result = g_verify.results.back();
+
+	if (demo.playback && gamestate == GS_LEVEL)
+	{
+		g_verify.started = true;
+		result.hashes.push_back(static_cast<UINT16>(statehash));
+
+		if (!demosynced && result.firstdesync < 0)
+			result.firstdesync = static_cast<INT32>(result.hashes.size() - 1);
+		return;
+	}
+
+	if (!g_verify.started && ++g_verify.waited > kStartTimeout)
+	{
+		result.error = "demo failed to start";
+		G_StopDemo();
+		next_demo();
+	}
+}
+
+void G_VerifyDemosDone(void)
+{
+	if (!g_verify.active)
+		return;
+
+	next_demo();
+}
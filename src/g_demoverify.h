@@ -0,0 +1,42 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  g_demoverify.h
+/// \brief Batch replay verification
+
+#ifndef __G_DEMOVERIFY_H__
+#define __G_DEMOVERIFY_H__
+
+#include "doomtype.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Parent process of -verifydemos: runs the worker processes, merges their
+// results and returns the exit status. Returns -1 if workers can't be
+// spawned on this platform, in which case the list is verified in-process.
+INT32 G_VerifyDemosRunWorkers(void);
+
+// Starts verifying this process's share of the -verifydemos list.
+boolean G_VerifyDemosStart(void);
+
+boolean G_VerifyDemosActive(void);
+
+// Records the state hash of the tic that just ran.
+void G_VerifyDemosTic(INT16 statehash);
+
+// The current demo finished. Starts the next one, or writes the results
+// and quits after the last.
+void G_VerifyDemosDone(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __G_DEMOVERIFY_H__
@@ -4967,6 +4967,8 @@ void G_DirtyGameData(void)
 	if (gamedata)
 		gamedata->evercrashed = true;
 
+	G_MarkGameDataCrashed();
+
 	//if (FIL_WriteFileOK(name))
 		handle = fopen(va(pandf, srb2home, gamedatafilename), "r+b");
 
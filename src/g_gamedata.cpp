@@ -11,13 +11,14 @@
 #include "g_gamedata.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstddef>
 #include <exception>
-#include <filesystem>
 
 #include <fmt/format.h>
 
+#include "io/save_queue.hpp"
 #include "io/streams.hpp"
 #include "d_main.h"
 #include "m_argv.h"
@@ -26,11 +27,15 @@
 #include "r_skins.h"
 #include "z_zone.h"
 
-namespace fs = std::filesystem;
 using json = nlohmann::json;
 
 #define GD_VERSION_MAJOR (0xBA5ED321)
 #define GD_VERSION_MINOR (1)
+#define GD_FLAG_MSGPACK (0x80) // payload is MessagePack, not UBJSON
+
+// Set by G_DirtyGameData, which can run from a signal handler while the
+// save thread is writing.
+static std::atomic<bool> gamedata_crashed {false};
 
 void srb2::save_ng_gamedata()
 {
@@ -286,47 +291,53 @@ void srb2::save_ng_gamedata()
 	}
 
 	std::string gamedataname_s {gamedatafilename};
-	fs::path savepath {fmt::format("{}/{}", srb2home, gamedataname_s)};
-	fs::path baksavepath {fmt::format("{}/{}.bak", srb2home, gamedataname_s)};
-
-	json ngdata_json = ng;
-
+	uint8_t flags = GD_VERSION_MINOR;
+	uint8_t dirty = gamedata->evercrashed;
 
-	if (fs::exists(savepath))
+	if (M_CheckParm("-msgpackdata"))
 	{
-		try
-		{
-			fs::rename(savepath, baksavepath);
-		}
-		catch (const fs::filesystem_error& ex)
-		{
-			CONS_Alert(CONS_ERROR, "Failed to record backup save. Not attempting to save. %s\n", ex.what());
-			return;
-		}
+		// Smaller and faster to encode, but older builds can't read it.
+		flags |= GD_FLAG_MSGPACK;
 	}
 
-	try
+	srb2::io::SaveRequest request;
+	request.path = fmt::format("{}/{}", srb2home, gamedataname_s);
+	request.backup_path = fmt::format("{}.bak", request.path);
+	request.write = [ng = std::move(ng), flags, dirty](srb2::io::FileStream& file)
 	{
-		std::string savepathstring = savepath.string();
-		srb2::io::FileStream file {savepathstring, srb2::io::FileStreamMode::kWrite};
+		// A crash after this was queued has already dirtied the old file,
+		// which this one is about to replace, so check again here.
+		uint8_t written_dirty = dirty || gamedata_crashed.load(std::memory_order_acquire);
 
 		// The header is necessary to validate during loading.
 		srb2::io::write(static_cast<uint32_t>(GD_VERSION_MAJOR), file); // major
-		srb2::io::write(static_cast<uint8_t>(GD_VERSION_MINOR), file); // minor/flags
-		srb2::io::write(static_cast<uint8_t>(gamedata->evercrashed), file); // dirty (crash recovery)
+		srb2::io::write(static_cast<uint8_t>(flags), file); // minor/flags
+		srb2::io::write(static_cast<uint8_t>(written_dirty), file); // dirty (crash recovery)
 
-		std::vector<uint8_t> ubjson = json::to_ubjson(ng);
-		srb2::io::write_exact(file, tcb::as_bytes(tcb::make_span(ubjson)));
-		file.close();
-	}
-	catch (const std::exception& ex)
-	{
-		CONS_Alert(CONS_ERROR, "NG Gamedata save failed. Check directory for a ringdata.dat.bak. %s\n", ex.what());
-	}
-	catch (...)
+		json ngdata_json = ng;
+		std::vector<uint8_t> data = (flags & GD_FLAG_MSGPACK) ? json::to_msgpack(ngdata_json) : json::to_ubjson(ngdata_json);
+		srb2::io::write_exact(file, tcb::as_bytes(tcb::make_span(data)));
+
+		// And once more after the slow part, right before the rename.
+		if (!written_dirty && gamedata_crashed.load(std::memory_order_acquire))
+		{
+			file.seek(srb2::io::SeekFrom::kStart, 5);
+			srb2::io::write(static_cast<uint8_t>(1), file);
+		}
+	};
+	request.on_failure = [](const char* what)
 	{
-		CONS_Alert(CONS_ERROR, "NG Gamedata save failed. Check directory for a ringdata.dat.bak.\n");
-	}
+		CONS_Alert(CONS_ERROR, "NG Gamedata save failed. Check directory for a ringdata.dat.bak. %s\n", what);
+	};
+
+	// Serializing and writing happen on the save thread.
+	srb2::io::queue_save(std::move(request));
+}
+
+void G_MarkGameDataCrashed(void)
+{
+	gamedata_crashed.store(true, std::memory_order_release);
+	srb2::io::abandon_saves_on_exit();
 }
 
 // G_SaveGameData
@@ -389,6 +400,9 @@ void srb2::load_ng_gamedata()
 		return;
 	}
 
+	// Don't read it back while a save is still writing it.
+	srb2::io::wait_for_saves();
+
 	std::string datapath {fmt::format("{}/{}", srb2home, gamedatafilename)};
 
 	srb2::io::BufferedInputStream<srb2::io::FileStream> bis;
@@ -433,7 +447,7 @@ void srb2::load_ng_gamedata()
 	{
 		// safety: std::byte repr is always uint8_t 1-byte aligned
 		tcb::span<uint8_t> remainder_as_u8 = tcb::span((uint8_t*)remainder.data(), remainder.size());
-		json parsed = json::from_ubjson(remainder_as_u8);
+		json parsed = (minorversion & GD_FLAG_MSGPACK) ? json::from_msgpack(remainder_as_u8) : json::from_ubjson(remainder_as_u8);
 		js = parsed.template get<GamedataJson>();
 	}
 	catch (const std::exception& ex)
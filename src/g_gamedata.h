@@ -337,6 +337,10 @@ extern "C"
 void G_SaveGameData(void);
 void G_LoadGameData(void);
 
+// Signal safe. Saves still being written pick up the dirty flag, and
+// shutdown stops waiting on them after a moment.
+void G_MarkGameDataCrashed(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif // __cplusplus
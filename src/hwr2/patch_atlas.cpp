@@ -10,6 +10,8 @@
 
 #include "patch_atlas.hpp"
 
+#include <algorithm>
+
 #include <stb_rect_pack.h>
 
 #include "../r_patch.h"
@@ -74,7 +76,11 @@ rhi::Rect srb2::hwr2::trimmed_patch_dimensions(const patch_t* patch)
 
 void srb2::hwr2::convert_patch_to_trimmed_rg8_pixels(const patch_t* patch, std::vector<uint8_t>& out)
 {
-	Rect trimmed_rect = srb2::hwr2::trimmed_patch_dimensions(patch);
+	convert_patch_to_trimmed_rg8_pixels(patch, trimmed_patch_dimensions(patch), out);
+}
+
+void srb2::hwr2::convert_patch_to_trimmed_rg8_pixels(const patch_t* patch, Rect trimmed_rect, std::vector<uint8_t>& out)
+{
 	if (trimmed_rect.w % 2 > 0)
 	{
 		// In order to force 4-byte row alignment, an extra column is added to the image data.
@@ -139,6 +145,17 @@ PatchAtlas::PatchAtlas(Handle<Texture> texture, uint32_t size) : tex_(texture),
 PatchAtlas::PatchAtlas(PatchAtlas&&) = default;
 PatchAtlas& PatchAtlas::operator=(PatchAtlas&&) = default;
 
+void PatchAtlas::clear()
+{
+	const size_t double_size = size_ * 2;
+	for (size_t i = 0; i < double_size; i++)
+	{
+		rp_nodes[i] = {};
+	}
+	stbrp_init_target(rp_ctx.get(), size_, size_, rp_nodes.get(), double_size);
+	entries_.clear();
+}
+
 void PatchAtlas::pack_rects(tcb::span<stbrp_rect> rects)
 {
 	stbrp_pack_rects(rp_ctx.get(), rects.data(), rects.size());
@@ -165,19 +182,6 @@ PatchAtlasCache::PatchAtlasCache(PatchAtlasCache&&) = default;
 PatchAtlasCache& PatchAtlasCache::operator=(PatchAtlasCache&&) = default;
 PatchAtlasCache::~PatchAtlasCache() = default;
 
-bool PatchAtlasCache::need_to_reset() const
-{
-	if (atlases_.size() > max_textures_)
-	{
-		return true;
-	}
-	if (Patch_WasFreedThisFrame())
-	{
-		return true;
-	}
-	return false;
-}
-
 void PatchAtlasCache::reset(Rhi& rhi)
 {
 	for (auto& atlas : atlases_)
@@ -216,110 +220,216 @@ static PatchAtlas create_atlas(Rhi& rhi, uint32_t size)
 	return new_atlas;
 }
 
-void PatchAtlasCache::pack(Rhi& rhi, Handle<GraphicsContext> ctx)
+void PatchAtlasCache::forget_freed_patches(Rhi& rhi)
 {
-	// Prepare stbrp rects for patches to be loaded.
-	std::vector<stbrp_rect> rects;
+	size_t count = 0;
+	patch_t** freed = Patch_TakeFreedPatches(&count);
 
-	std::vector<const patch_t*> large_patches;
-
-	std::vector<const patch_t*> patches;
-	for (auto patch : patches_to_pack_)
+	if (freed == nullptr)
 	{
-		patches.push_back(patch);
+		// Too many to go through one by one (a level or addon was unloaded)
+		reset(rhi);
+		patches_to_pack_.clear();
+		return;
 	}
 
-	for (size_t i = 0; i < patches.size(); i++)
+	for (size_t i = 0; i < count; i++)
 	{
-		const patch_t* patch = patches[i];
-		Rect trimmed_rect = trimmed_patch_dimensions(patch);
+		const patch_t* patch = freed[i];
 
-		if (rect_is_large(trimmed_rect.w, trimmed_rect.h))
+		patches_to_pack_.erase(patch);
+
+		auto itr = patch_lookup_.find(patch);
+		if (itr == patch_lookup_.end())
 		{
-			large_patches.push_back(patch);
 			continue;
 		}
 
-		stbrp_rect rect {};
-
-		rect.id = i;
-		rect.w = trimmed_rect.w;
-		rect.h = trimmed_rect.h;
-		rects.push_back(std::move(rect));
+		// The space isn't reclaimed until the page is evicted; stbrp can't free single rects.
+		atlases_[itr->second].entries_.erase(patch);
+		patch_lookup_.erase(itr);
 	}
+}
 
-	while (rects.size() > 0)
+std::optional<size_t> PatchAtlasCache::least_recently_used(uint64_t before) const
+{
+	std::optional<size_t> lru;
+
+	for (size_t i = 0; i < atlases_.size(); i++)
 	{
-		if (atlases_.size() == 0)
+		if (atlases_[i].last_used_ >= before)
 		{
-			atlases_.push_back(create_atlas(rhi, tex_size_));
+			continue;
 		}
 
-		for (size_t atlas_index = 0; atlas_index < atlases_.size(); atlas_index++)
+		if (!lru || atlases_[i].last_used_ < atlases_[*lru].last_used_)
 		{
-			auto& atlas = atlases_[atlas_index];
-			atlas.pack_rects(rects);
-			for (auto itr = rects.begin(); itr != rects.end();)
-			{
-				auto& rect = *itr;
-				if (rect.was_packed)
-				{
-					PatchAtlas::Entry entry;
-					const patch_t* patch = patches[rect.id];
-					Rect trimmed_rect = trimmed_patch_dimensions(patch);
-					entry.x = static_cast<uint32_t>(rect.x);
-					entry.y = static_cast<uint32_t>(rect.y);
-					entry.w = static_cast<uint32_t>(rect.w);
-					entry.h = static_cast<uint32_t>(rect.h);
-					entry.trim_x = static_cast<uint32_t>(trimmed_rect.x);
-					entry.trim_y = static_cast<uint32_t>(trimmed_rect.y);
-					entry.orig_w = static_cast<uint32_t>(patch->width);
-					entry.orig_h = static_cast<uint32_t>(patch->height);
-					atlas.entries_.insert_or_assign(patch, std::move(entry));
-					patch_lookup_.insert_or_assign(patch, atlas_index);
-					patches_to_upload_.insert(patch);
-					rects.erase(itr);
-					continue;
-				}
-				++itr;
-			}
+			lru = i;
+		}
+	}
+
+	return lru;
+}
+
+void PatchAtlasCache::evict_page(size_t atlas_index)
+{
+	PatchAtlas& atlas = atlases_[atlas_index];
+
+	for (auto& [patch, entry] : atlas.entries_)
+	{
+		patch_lookup_.erase(patch);
+	}
+
+	atlas.clear();
+}
+
+void PatchAtlasCache::evict(Rhi& rhi)
+{
+	forget_freed_patches(rhi);
+
+	// Pages over the limit were only made because every page was in use that frame
+	while (atlases_.size() > max_textures_)
+	{
+		const size_t index = *least_recently_used(frame_ + 1);
+		evict_page(index);
+		rhi.destroy_texture(atlases_[index].texture());
+		atlases_.erase(atlases_.begin() + index);
 
-			// If we still have rects to pack, and we're at the last atlas, create another atlas.
-			if (atlas_index == atlases_.size() - 1 && rects.size() > 0)
+		for (auto& [patch, atlas_index] : patch_lookup_)
+		{
+			if (atlas_index > index)
 			{
-				atlases_.push_back(create_atlas(rhi, tex_size_));
+				atlas_index -= 1;
 			}
 		}
 	}
 
-	patches_to_pack_.clear();
+	frame_ += 1;
+}
+
+void PatchAtlasCache::pack(Rhi& rhi, Handle<GraphicsContext> ctx)
+{
+	if (patches_to_pack_.empty())
+	{
+		return;
+	}
 
-	// TODO Create large patch "atlases"
+	struct Pending
+	{
+		const patch_t* patch;
+		Rect trimmed_rect;
+	};
 
-	SRB2_ASSERT(ready_for_lookup());
+	// Prepare stbrp rects for patches to be loaded.
+	std::vector<Pending> patches;
+	std::vector<stbrp_rect> rects;
+
+	for (auto patch : patches_to_pack_)
+	{
+		Rect trimmed_rect = trimmed_patch_dimensions(patch);
+
+		if (rect_is_large(trimmed_rect.w, trimmed_rect.h) || trimmed_rect.w > tex_size_ || trimmed_rect.h > tex_size_)
+		{
+			// TODO Create large patch "atlases"
+			continue;
+		}
+
+		stbrp_rect rect {};
+
+		rect.id = patches.size();
+		rect.w = trimmed_rect.w;
+		rect.h = trimmed_rect.h;
+		rects.push_back(std::move(rect));
+		patches.push_back({patch, trimmed_rect});
+	}
+
+	patches_to_pack_.clear();
 
-	// Upload atlased patches
 	std::vector<uint8_t> patch_data;
-	for (const patch_t* patch_to_upload : patches_to_upload_)
+
+	// Packs as many rects as fit into a page and uploads them right away.
+	// Returns the number packed.
+	auto pack_into = [&](size_t atlas_index)
 	{
-		srb2::NotNull<PatchAtlas*> atlas = find_patch(patch_to_upload);
+		auto& atlas = atlases_[atlas_index];
+		atlas.pack_rects(rects);
+
+		auto unpacked = std::partition(rects.begin(), rects.end(), [](const stbrp_rect& rect) { return !rect.was_packed; });
+		const size_t packed = rects.end() - unpacked;
+
+		for (auto itr = unpacked; itr != rects.end(); ++itr)
+		{
+			const Pending& pending = patches[itr->id];
+			const patch_t* patch = pending.patch;
+
+			PatchAtlas::Entry entry;
+			entry.x = static_cast<uint32_t>(itr->x);
+			entry.y = static_cast<uint32_t>(itr->y);
+			entry.w = static_cast<uint32_t>(itr->w);
+			entry.h = static_cast<uint32_t>(itr->h);
+			entry.trim_x = static_cast<uint32_t>(pending.trimmed_rect.x);
+			entry.trim_y = static_cast<uint32_t>(pending.trimmed_rect.y);
+			entry.orig_w = static_cast<uint32_t>(patch->width);
+			entry.orig_h = static_cast<uint32_t>(patch->height);
+			atlas.entries_.insert_or_assign(patch, entry);
+			patch_lookup_.insert_or_assign(patch, atlas_index);
+
+			convert_patch_to_trimmed_rg8_pixels(patch, pending.trimmed_rect, patch_data);
+
+			rhi.update_texture(
+				ctx,
+				atlas.tex_,
+				{static_cast<int32_t>(entry.x), static_cast<int32_t>(entry.y), entry.w, entry.h},
+				PixelFormat::kRG8,
+				tcb::as_bytes(tcb::span(patch_data))
+			);
+		}
 
-		std::optional<PatchAtlas::Entry> entry = atlas->find_patch(patch_to_upload);
-		SRB2_ASSERT(entry.has_value());
+		rects.erase(unpacked, rects.end());
+
+		if (packed > 0)
+		{
+			atlas.last_used_ = frame_;
+		}
+
+		return packed;
+	};
+
+	// First fill the free space left on resident pages
+	for (size_t atlas_index = 0; atlas_index < atlases_.size() && !rects.empty(); atlas_index++)
+	{
+		pack_into(atlas_index);
+	}
 
-		convert_patch_to_trimmed_rg8_pixels(patch_to_upload, patch_data);
+	while (!rects.empty())
+	{
+		size_t atlas_index;
 
-		rhi.update_texture(
-			ctx,
-			atlas->tex_,
-			{static_cast<int32_t>(entry->x), static_cast<int32_t>(entry->y), entry->w, entry->h},
-			PixelFormat::kRG8,
-			tcb::as_bytes(tcb::span(patch_data))
-		);
+		if (atlases_.size() < max_textures_)
+		{
+			atlases_.push_back(create_atlas(rhi, tex_size_));
+			atlas_index = atlases_.size() - 1;
+		}
+		else if (std::optional<size_t> lru = least_recently_used(frame_))
+		{
+			evict_page(*lru);
+			atlas_index = *lru;
+		}
+		else
+		{
+			// Every page is drawn from this frame. Go over the limit; evict() trims it afterward.
+			atlases_.push_back(create_atlas(rhi, tex_size_));
+			atlas_index = atlases_.size() - 1;
+		}
 
-		patch_data.clear();
+		if (pack_into(atlas_index) == 0)
+		{
+			// Doesn't fit even an empty page
+			break;
+		}
 	}
-	patches_to_upload_.clear();
+
+	SRB2_ASSERT(ready_for_lookup());
 }
 
 PatchAtlas* PatchAtlasCache::find_patch(srb2::NotNull<const patch_t*> patch)
@@ -358,8 +468,10 @@ const PatchAtlas* PatchAtlasCache::find_patch(srb2::NotNull<const patch_t*> patc
 
 void PatchAtlasCache::queue_patch(srb2::NotNull<const patch_t*> patch)
 {
-	if (patch_lookup_.find(patch) != patch_lookup_.end())
+	auto itr = patch_lookup_.find(patch);
+	if (itr != patch_lookup_.end())
 	{
+		atlases_[itr->second].last_used_ = frame_;
 		return;
 	}
 
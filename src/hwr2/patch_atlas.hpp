@@ -60,8 +60,14 @@ private:
 	std::unique_ptr<stbrp_context> rp_ctx {nullptr};
 	std::unique_ptr<stbrp_node[]> rp_nodes {nullptr};
 
+	// PatchAtlasCache frame in which a patch on this page was last drawn or packed
+	uint64_t last_used_ = 0;
+
 	friend class PatchAtlasCache;
 
+	/// @brief Forget every entry and start packing from scratch. The texture is kept as is.
+	void clear();
+
 public:
 	PatchAtlas(rhi::Handle<rhi::Texture> tex, uint32_t size);
 	PatchAtlas(const PatchAtlas&) = delete;
@@ -82,19 +88,30 @@ public:
 /// @brief A resource-managing pass which creates and manages a set of Atlas Textures with
 /// optimally packed Patches, allowing drawing passes to reuse the same texture binds for
 /// drawing things like sprites and 2D elements.
+///
+/// Patches stay resident across frames and are only converted and uploaded once. New patches
+/// are packed into the free space of existing pages. Once max_textures pages are full, the page
+/// least recently drawn from is cleared and reused.
 class PatchAtlasCache
 {
 	std::vector<PatchAtlas> atlases_;
 	std::unordered_map<const patch_t*, size_t> patch_lookup_;
 
 	std::unordered_set<const patch_t*> patches_to_pack_;
-	std::unordered_set<const patch_t*> patches_to_upload_;
 
 	uint32_t tex_size_ = 2048;
 	size_t max_textures_ = 2;
 
+	uint64_t frame_ = 1;
+
 	bool ready_for_lookup() const;
 
+	/// @brief Index of the least recently used page last used before the given frame, or nullopt if none was.
+	std::optional<size_t> least_recently_used(uint64_t before) const;
+
+	/// @brief Forget the patches on a page and clear it for reuse.
+	void evict_page(size_t atlas_index);
+
 	/// @brief Decide if a rect's dimensions are Large, that is, the rect should not be packed and instead its patch
 	/// should be uploaded in isolation.
 	bool rect_is_large(uint32_t w, uint32_t h) const noexcept { return false; }
@@ -108,8 +125,14 @@ public:
 	PatchAtlasCache& operator=(PatchAtlasCache&&);
 	~PatchAtlasCache();
 
+	/// @brief Drop every patch freed since the last call, so their addresses can't alias new patches.
+	/// Must be called before queueing a frame's patches: a patch allocated at a freed patch's address
+	/// would otherwise be taken for the resident one.
+	void forget_freed_patches(rhi::Rhi& rhi);
+
 	/// @brief Queue a patch to be packed. All patches will be packed after the prepass phase,
-	/// or the owner can explicitly request a pack.
+	/// or the owner can explicitly request a pack. A patch that is already resident is only
+	/// marked as used this frame.
 	void queue_patch(srb2::NotNull<const patch_t*> patch);
 
 	/// @brief Pack queued patches, allowing them to be looked up with find_patch.
@@ -121,7 +144,9 @@ public:
 	const PatchAtlas* find_patch(srb2::NotNull<const patch_t*> patch) const;
 	PatchAtlas* find_patch(srb2::NotNull<const patch_t*> patch);
 
-	bool need_to_reset() const;
+	/// @brief End the frame: forget freed patches and destroy the least recently used pages
+	/// beyond max_textures.
+	void evict(rhi::Rhi& rhi);
 
 	/// @brief Clear the atlases and reset for lookup.
 	void reset(rhi::Rhi& rhi);
@@ -137,6 +162,9 @@ rhi::Rect trimmed_patch_dimensions(const patch_t* patch);
 /// @param out the output vector, cleared before writing.
 void convert_patch_to_trimmed_rg8_pixels(const patch_t* patch, std::vector<uint8_t>& out);
 
+/// @brief As above, with the result of trimmed_patch_dimensions already known.
+void convert_patch_to_trimmed_rg8_pixels(const patch_t* patch, rhi::Rect trimmed_rect, std::vector<uint8_t>& out);
+
 } // namespace srb2::hwr2
 
 #endif // __SRB2_HWR2_PATCH_ATLAS_HPP__
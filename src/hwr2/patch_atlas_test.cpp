@@ -0,0 +1,167 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "patch_atlas_test.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <glm/vec4.hpp>
+
+#include "patch_atlas.hpp"
+#include "resource_management.hpp"
+#include "twodee.hpp"
+#include "twodee_renderer.hpp"
+#include "../r_patch.h"
+#include "../z_zone.h"
+
+using namespace srb2;
+using namespace srb2::hwr2;
+using namespace srb2::rhi;
+
+namespace
+{
+
+void push_le16(std::vector<uint8_t>& out, uint16_t value)
+{
+	out.push_back(value & 0xFF);
+	out.push_back(value >> 8);
+}
+
+void push_le32(std::vector<uint8_t>& out, uint32_t value)
+{
+	push_le16(out, value & 0xFFFF);
+	push_le16(out, value >> 16);
+}
+
+// A square, fully opaque patch in the lump format, one post per column
+std::vector<uint8_t> make_solid_patch(uint8_t size, uint8_t color)
+{
+	std::vector<uint8_t> data;
+	const uint32_t column_size = size + 5;
+	const uint32_t header_size = 8 + 4 * size;
+
+	push_le16(data, size);
+	push_le16(data, size);
+	push_le16(data, 0);
+	push_le16(data, 0);
+	for (uint32_t col = 0; col < size; col++)
+	{
+		push_le32(data, header_size + col * column_size);
+	}
+
+	for (uint32_t col = 0; col < size; col++)
+	{
+		data.push_back(0); // topdelta
+		data.push_back(size); // length
+		data.push_back(0); // padding
+		data.insert(data.end(), size, color);
+		data.push_back(0); // padding
+		data.push_back(0xFF); // end of column
+	}
+
+	return data;
+}
+
+patch_t* create_patch(std::vector<uint8_t>& data, void* dest)
+{
+	return Patch_Create(reinterpret_cast<softwarepatch_t*>(data.data()), data.size(), dest);
+}
+
+// What Z_Free does to a patch, but the memory is kept so the next patch lands at the same address
+void free_patch_keep_address(patch_t* patch)
+{
+	Z_Free(patch->columnofs);
+	Z_Free(patch->columns);
+	patch->columnofs = nullptr;
+	patch->columns = nullptr;
+	Patch_NoteFreed(patch);
+}
+
+void draw_frame(
+	Rhi& rhi,
+	PaletteManager& palette_manager,
+	TwodeeRenderer& renderer,
+	Handle<RenderPass> render_pass,
+	Handle<Texture> target,
+	const patch_t* patch
+)
+{
+	Twodee twodee;
+	twodee.begin_quad().patch(patch).rect(0.f, 0.f, patch->width, patch->height).color(1.f, 1.f, 1.f, 1.f).done();
+
+	Handle<GraphicsContext> ctx = rhi.begin_graphics();
+	palette_manager.update(rhi, ctx);
+	rhi.begin_render_pass(ctx, {render_pass, target, std::nullopt, glm::vec4(0.f)});
+	renderer.flush(rhi, ctx, twodee);
+	rhi.end_render_pass(ctx);
+	rhi.end_graphics(ctx);
+	palette_manager.destroy_per_frame_resources(rhi);
+	rhi.present();
+	rhi.finish();
+}
+
+} // namespace
+
+bool srb2::hwr2::test_patch_atlas_address_reuse(Rhi& rhi)
+{
+	PaletteManager palette_manager;
+	FlatTextureManager flat_manager;
+	PatchAtlasCache atlas_cache {256, 1};
+	TwodeeRenderer renderer {&palette_manager, &flat_manager, &atlas_cache};
+
+	RenderPassDesc pass_desc {};
+	pass_desc.use_depth_stencil = false;
+	pass_desc.color_load_op = AttachmentLoadOp::kClear;
+	pass_desc.color_store_op = AttachmentStoreOp::kStore;
+	pass_desc.depth_load_op = AttachmentLoadOp::kDontCare;
+	pass_desc.depth_store_op = AttachmentStoreOp::kDontCare;
+	pass_desc.stencil_load_op = AttachmentLoadOp::kDontCare;
+	pass_desc.stencil_store_op = AttachmentStoreOp::kDontCare;
+	Handle<RenderPass> render_pass = rhi.create_render_pass(pass_desc);
+
+	TextureDesc target_desc {};
+	target_desc.format = TextureFormat::kRGBA;
+	target_desc.width = 64;
+	target_desc.height = 64;
+	target_desc.u_wrap = TextureWrapMode::kClamp;
+	target_desc.v_wrap = TextureWrapMode::kClamp;
+	Handle<Texture> target = rhi.create_texture(target_desc);
+
+	std::vector<uint8_t> first_data = make_solid_patch(2, 1);
+	std::vector<uint8_t> second_data = make_solid_patch(8, 2);
+
+	void* storage = Z_Calloc(sizeof(patch_t), PU_STATIC, nullptr);
+
+	patch_t* first = create_patch(first_data, storage);
+	draw_frame(rhi, palette_manager, renderer, render_pass, target, first);
+
+	free_patch_keep_address(first);
+	patch_t* second = create_patch(second_data, storage);
+	draw_frame(rhi, palette_manager, renderer, render_pass, target, second);
+
+	// The second patch must have been packed on its own, not mistaken for the first one
+	bool passed = false;
+	if (const PatchAtlas* atlas = atlas_cache.find_patch(second))
+	{
+		std::optional<PatchAtlas::Entry> entry = atlas->find_patch(second);
+		passed = entry && entry->orig_w == 8 && entry->orig_h == 8;
+	}
+
+	Z_Free(second->columnofs);
+	Z_Free(second->columns);
+	Z_Free(storage);
+
+	atlas_cache.reset(rhi);
+	rhi.destroy_texture(target);
+	rhi.destroy_render_pass(render_pass);
+
+	return passed;
+}
@@ -0,0 +1,25 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_HWR2_PATCH_ATLAS_TEST_HPP__
+#define __SRB2_HWR2_PATCH_ATLAS_TEST_HPP__
+
+#include "../rhi/rhi.hpp"
+
+namespace srb2::hwr2
+{
+
+/// @brief Draw a patch, free it, create another at the same address and draw that. Passes if the second
+/// patch was packed in its own right. Takes the freed patch list, so the caller must reset any other
+/// PatchAtlasCache afterwards.
+bool test_patch_atlas_address_reuse(rhi::Rhi& rhi);
+
+} // namespace srb2::hwr2
+
+#endif // __SRB2_HWR2_PATCH_ATLAS_TEST_HPP__
@@ -11,6 +11,7 @@
 #include "twodee_renderer.hpp"
 
 #include <algorithm>
+#include <limits>
 #include <unordered_set>
 
 #include <stb_rect_pack.h>
@@ -231,6 +232,169 @@ void TwodeeRenderer::rewrite_patch_quad_vertices(Draw2dList& list, const Draw2dP
 	list.vertices[vtx_offs + 3].v = clipped_vmax;
 }
 
+// How many batches back a command may look for one it can join
+static constexpr const std::size_t kBatchLookback = 32;
+
+MergedTwodeeCommand TwodeeRenderer::state_for_cmd(const Draw2dCmd& cmd) const
+{
+	MergedTwodeeCommand state;
+	state.pipeline_key = pipeline_key_for_cmd(cmd);
+
+	// We need to split the merged commands based on the kind of texture
+	// Patches are converted to atlas texture indexes, which we've just packed the patch rects for
+	// Flats are uploaded as individual textures.
+	auto tex_visitor = srb2::Overload {
+		[&](const Draw2dPatchQuad& cmd)
+		{
+			if (cmd.patch != nullptr)
+			{
+				srb2::NotNull<const PatchAtlas*> atlas = patch_atlas_cache_->find_patch(cmd.patch);
+				state.texture = atlas->texture();
+			}
+			state.colormap = cmd.colormap;
+		},
+		[&](const Draw2dVertices& cmd)
+		{
+			if (cmd.flat_lump != LUMPERROR)
+			{
+				std::optional<MergedTwodeeCommand::Texture> t = MergedTwodeeCommandFlatTexture {cmd.flat_lump};
+				state.texture = t;
+			}
+		}};
+	std::visit(tex_visitor, cmd);
+
+	return state;
+}
+
+void TwodeeRenderer::batch_commands(
+	Rhi& rhi,
+	Handle<GraphicsContext> ctx,
+	Draw2dList& list,
+	MergedTwodeeCommandList& merged_list
+)
+{
+	batches_.clear();
+	pending_cmds_.clear();
+
+	bool reordered = false;
+	uint32_t index_offset = 0;
+	for (const auto& cmd : list.cmds)
+	{
+		const uint32_t cmd_elements = hwr2::elements(cmd);
+		MergedTwodeeCommand state = state_for_cmd(cmd);
+
+		// Screen bounds of the command, from its final vertex positions
+		float xmin = std::numeric_limits<float>::infinity();
+		float ymin = std::numeric_limits<float>::infinity();
+		float xmax = -std::numeric_limits<float>::infinity();
+		float ymax = -std::numeric_limits<float>::infinity();
+		for (uint32_t i = index_offset; i < index_offset + cmd_elements; i++)
+		{
+			const TwodeeVertex& vtx = list.vertices[list.indices[i]];
+			xmin = std::min(xmin, vtx.x);
+			ymin = std::min(ymin, vtx.y);
+			xmax = std::max(xmax, vtx.x);
+			ymax = std::max(ymax, vtx.y);
+		}
+		if (state.pipeline_key.lines)
+		{
+			// Lines rasterize up to a pixel past their endpoints
+			xmin -= 1.f;
+			ymin -= 1.f;
+			xmax += 1.f;
+			ymax += 1.f;
+		}
+
+		// Look back for a batch with the same state. The command may only be drawn ahead of the batches in between if
+		// it touches none of their pixels, otherwise blending would happen in a different order. Commands with no
+		// area never overlap anything.
+		std::size_t target = batches_.size();
+		const std::size_t lookback_end = batches_.size() - std::min(batches_.size(), kBatchLookback);
+		for (std::size_t i = batches_.size(); i > lookback_end; i--)
+		{
+			const PendingBatch& batch = batches_[i - 1];
+			if (batch.cmd.pipeline_key == state.pipeline_key && batch.cmd.texture == state.texture &&
+				batch.cmd.colormap == state.colormap)
+			{
+				target = i - 1;
+				break;
+			}
+			if (xmin < batch.xmax && batch.xmin < xmax && ymin < batch.ymax && batch.ymin < ymax)
+			{
+				break;
+			}
+		}
+
+		if (target == batches_.size())
+		{
+			if (state.texture)
+			{
+				if (auto flat = std::get_if<MergedTwodeeCommandFlatTexture>(&*state.texture))
+				{
+					flat_manager_->find_or_create_indexed(rhi, ctx, flat->lump);
+				}
+			}
+			batches_.push_back({std::move(state), xmin, ymin, xmax, ymax});
+		}
+		else
+		{
+			PendingBatch& batch = batches_[target];
+			batch.xmin = std::min(batch.xmin, xmin);
+			batch.ymin = std::min(batch.ymin, ymin);
+			batch.xmax = std::max(batch.xmax, xmax);
+			batch.ymax = std::max(batch.ymax, ymax);
+			if (target != batches_.size() - 1)
+			{
+				reordered = true;
+				stats_.reordered++;
+			}
+		}
+
+		batches_[target].cmd.elements += cmd_elements;
+		pending_cmds_.push_back({static_cast<uint32_t>(target), index_offset, cmd_elements});
+		index_offset += cmd_elements;
+	}
+
+	// Lay out each batch's range of the IBO
+	uint32_t batch_offset = 0;
+	for (auto& batch : batches_)
+	{
+		batch.cmd.index_offset = batch_offset;
+		batch_offset += batch.cmd.elements;
+	}
+
+	if (reordered)
+	{
+		// Rewrite the indices in batch order. The vertices stay where they are.
+		indices_.resize(list.indices.size());
+		for (auto& batch : batches_)
+		{
+			// Reused as the write cursor, restored below
+			batch.cmd.elements = 0;
+		}
+		for (const auto& pending : pending_cmds_)
+		{
+			MergedTwodeeCommand& merged = batches_[pending.batch].cmd;
+			std::copy_n(
+				list.indices.begin() + pending.index_offset,
+				pending.elements,
+				indices_.begin() + merged.index_offset + merged.elements
+			);
+			merged.elements += pending.elements;
+		}
+		std::copy(indices_.begin(), indices_.end(), list.indices.begin());
+	}
+
+	merged_list.cmds.reserve(batches_.size());
+	for (auto& batch : batches_)
+	{
+		merged_list.cmds.push_back(std::move(batch.cmd));
+	}
+
+	stats_.commands += list.cmds.size();
+	stats_.batches += batches_.size();
+}
+
 void TwodeeRenderer::initialize(Rhi& rhi, Handle<GraphicsContext> ctx)
 {
 	{
@@ -282,6 +446,9 @@ void TwodeeRenderer::flush(Rhi& rhi, Handle<GraphicsContext> ctx, Twodee& twodee
 		initialize(rhi, ctx);
 	}
 
+	// Forget freed patches before queueing, in case one of this flush's patches reuses a freed address
+	patch_atlas_cache_->forget_freed_patches(rhi);
+
 	// Stage 1 - command list patch detection
 	std::unordered_set<const patch_t*> found_patches;
 	for (const auto& list : twodee)
@@ -371,111 +538,17 @@ void TwodeeRenderer::flush(Rhi& rhi, Handle<GraphicsContext> ctx, Twodee& twodee
 		merged_list.ibo = ibo;
 		merged_list.ibo_size = needed_ibo_size;
 
-		MergedTwodeeCommand new_cmd;
-		new_cmd.index_offset = 0;
-		new_cmd.elements = 0;
-		new_cmd.colormap = nullptr;
-		// safety: a command list is required to have at least 1 command
-		new_cmd.pipeline_key = pipeline_key_for_cmd(list.cmds[0]);
-		merged_list.cmds.push_back(std::move(new_cmd));
-
-		for (auto& cmd : list.cmds)
+		// Perform coordinate transformations first; batching needs the final screen bounds of each command
+		for (const auto& cmd : list.cmds)
 		{
-			auto& merged_cmd = *merged_list.cmds.rbegin();
-			bool new_cmd_needed = false;
-			TwodeePipelineKey pk = pipeline_key_for_cmd(cmd);
-			new_cmd_needed = new_cmd_needed || (pk != merged_cmd.pipeline_key);
-
-			// We need to split the merged commands based on the kind of texture
-			// Patches are converted to atlas texture indexes, which we've just packed the patch rects for
-			// Flats are uploaded as individual textures.
-			auto tex_visitor = srb2::Overload {
-				[&](const Draw2dPatchQuad& cmd)
-				{
-					if (cmd.patch == nullptr)
-					{
-						new_cmd_needed = new_cmd_needed || (merged_cmd.texture != std::nullopt);
-					}
-					else
-					{
-						srb2::NotNull<const PatchAtlas*> atlas = patch_atlas_cache_->find_patch(cmd.patch);
-						std::optional<MergedTwodeeCommand::Texture> atlas_index_texture = atlas->texture();
-						new_cmd_needed = new_cmd_needed || (merged_cmd.texture != atlas_index_texture);
-					}
-
-					new_cmd_needed = new_cmd_needed || (merged_cmd.colormap != cmd.colormap);
-				},
-				[&](const Draw2dVertices& cmd)
-				{
-					if (cmd.flat_lump == LUMPERROR)
-					{
-						new_cmd_needed |= (merged_cmd.texture != std::nullopt);
-					}
-					else
-					{
-						std::optional<MergedTwodeeCommand::Texture> flat_tex = MergedTwodeeCommandFlatTexture {cmd.flat_lump};
-						new_cmd_needed |= (merged_cmd.texture != flat_tex);
-					}
-
-					new_cmd_needed = new_cmd_needed || (merged_cmd.colormap != nullptr);
-				}};
-			std::visit(tex_visitor, cmd);
-
-			if (new_cmd_needed)
-			{
-				MergedTwodeeCommand the_new_one;
-				the_new_one.index_offset = merged_cmd.index_offset + merged_cmd.elements;
-
-				// Map to the merged version of the texture variant. Yay...!
-				auto tex_visitor_again = srb2::Overload {
-					[&](const Draw2dPatchQuad& cmd)
-					{
-						if (cmd.patch != nullptr)
-						{
-							srb2::NotNull<const PatchAtlas*> atlas = patch_atlas_cache_->find_patch(cmd.patch);
-							the_new_one.texture = atlas->texture();
-						}
-						else
-						{
-							the_new_one.texture = std::nullopt;
-						}
-						the_new_one.colormap = cmd.colormap;
-					},
-					[&](const Draw2dVertices& cmd)
-					{
-						if (cmd.flat_lump != LUMPERROR)
-						{
-							flat_manager_->find_or_create_indexed(rhi, ctx, cmd.flat_lump);
-							std::optional<MergedTwodeeCommand::Texture> t = MergedTwodeeCommandFlatTexture {cmd.flat_lump};
-							the_new_one.texture = t;
-						}
-						else
-						{
-							the_new_one.texture = std::nullopt;
-						}
-
-						the_new_one.colormap = nullptr;
-					}};
-				std::visit(tex_visitor_again, cmd);
-				the_new_one.pipeline_key = pipeline_key_for_cmd(cmd);
-				merged_list.cmds.push_back(std::move(the_new_one));
-			}
-
-			// There may or may not be a new current command; update its element count
-			auto& new_merged_cmd = *merged_list.cmds.rbegin();
-			// We know for sure that all commands in a command list have a contiguous range of elements in the IBO
-			// So we can draw them in batch if the pipeline key and textures match
-			new_merged_cmd.elements += hwr2::elements(cmd);
-
-			// Perform coordinate transformations
+			if (const Draw2dPatchQuad* quad = std::get_if<Draw2dPatchQuad>(&cmd))
 			{
-				auto vtx_transform_visitor = srb2::Overload {
-					[&](const Draw2dPatchQuad& cmd) { rewrite_patch_quad_vertices(list, cmd); },
-					[&](const Draw2dVertices& cmd) {}};
-				std::visit(vtx_transform_visitor, cmd);
+				rewrite_patch_quad_vertices(list, *quad);
 			}
 		}
 
+		batch_commands(rhi, ctx, list, merged_list);
+
 		cmd_lists_.push_back(std::move(merged_list));
 
 		list_index++;
@@ -587,9 +660,13 @@ void TwodeeRenderer::flush(Rhi& rhi, Handle<GraphicsContext> ctx, Twodee& twodee
 	// Reset context for next drawing batch
 	twodee = Twodee();
 
-	// Reset the patch atlas if needed
-	if (patch_atlas_cache_->need_to_reset())
-	{
-		patch_atlas_cache_->reset(rhi);
-	}
+	// Drop freed patches and trim the patch atlas back to its page limit
+	patch_atlas_cache_->evict(rhi);
+}
+
+TwodeeBatchStats TwodeeRenderer::take_stats() noexcept
+{
+	TwodeeBatchStats stats = stats_;
+	stats_ = {};
+	return stats;
 }
@@ -68,7 +68,7 @@ struct MergedTwodeeCommand
 	TwodeePipelineKey pipeline_key = {};
 	rhi::Handle<rhi::BindingSet> binding_set = {};
 	std::optional<Texture> texture;
-	const uint8_t* colormap;
+	const uint8_t* colormap = nullptr;
 	uint32_t index_offset = 0;
 	uint32_t elements = 0;
 };
@@ -83,6 +83,14 @@ struct MergedTwodeeCommandList
 	std::vector<MergedTwodeeCommand> cmds;
 };
 
+/// @brief Counters for the batching stage, summed over every flush since they were last taken.
+struct TwodeeBatchStats
+{
+	uint32_t commands = 0; // Draw2dCmds submitted
+	uint32_t batches = 0; // draw calls issued for them
+	uint32_t reordered = 0; // commands drawn ahead of later batches to join an earlier one
+};
+
 class TwodeeRenderer final
 {
 	bool initialized_ = false;
@@ -98,8 +106,35 @@ class TwodeeRenderer final
 	rhi::Handle<rhi::Texture> output_;
 	rhi::Handle<rhi::Texture> default_tex_;
 	std::unordered_map<TwodeePipelineKey, rhi::Handle<rhi::Pipeline>> pipelines_;
+	TwodeeBatchStats stats_;
+
+	// Scratch space for batch_commands, kept to avoid reallocating every flush
+	struct PendingBatch
+	{
+		MergedTwodeeCommand cmd;
+		float xmin;
+		float ymin;
+		float xmax;
+		float ymax;
+	};
+	struct PendingCmd
+	{
+		uint32_t batch;
+		uint32_t index_offset;
+		uint32_t elements;
+	};
+	std::vector<PendingBatch> batches_;
+	std::vector<PendingCmd> pending_cmds_;
+	std::vector<uint16_t> indices_;
 
 	void rewrite_patch_quad_vertices(Draw2dList& list, const Draw2dPatchQuad& cmd) const;
+	MergedTwodeeCommand state_for_cmd(const Draw2dCmd& cmd) const;
+	void batch_commands(
+		rhi::Rhi& rhi,
+		rhi::Handle<rhi::GraphicsContext> ctx,
+		Draw2dList& list,
+		MergedTwodeeCommandList& merged_list
+	);
 
 	void initialize(rhi::Rhi& rhi, rhi::Handle<rhi::GraphicsContext> ctx);
 
@@ -119,6 +154,9 @@ public:
 	/// @param rhi
 	/// @param ctx
 	void flush(rhi::Rhi& rhi, rhi::Handle<rhi::GraphicsContext> ctx, Twodee& twodee);
+
+	/// @brief Returns the batching counters accumulated since the last call and resets them.
+	TwodeeBatchStats take_stats() noexcept;
 };
 
 } // namespace srb2::hwr2
@@ -40,6 +40,15 @@ extern consvar_t cv_samplerate;
 */
 void *I_GetSfx(sfxinfo_t *sfx);
 
+/**	\brief	Decodes several sfx at once, in parallel where possible
+
+	\param	sfx	sfx to setup; their data is set as I_GetSfx would return it
+	\param	count	number of sfx
+
+	\return	void
+*/
+void I_GetSfxBatch(sfxinfo_t **sfx, size_t count);
+
 /**	\brief	The I_FreeSfx function
 
 	\param	sfx	sfx to be freed up
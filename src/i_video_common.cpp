@@ -25,6 +25,7 @@
 #include "hwr2/hardware_state.hpp"
 #include "hwr2/patch_atlas.hpp"
 #include "hwr2/twodee.hpp"
+#include "r_main.h"
 #include "v_video.h"
 
 // KILL THIS WHEN WE KILL OLD OGL SUPPORT PLEASE
@@ -285,6 +286,12 @@ void I_FinishUpdate(void)
 		g_hw_state.twodee_renderer->flush(*rhi, ctx, g_2d);
 		rhi->end_render_pass(ctx);
 
+		// Includes the flushes of any wipes drawn this frame
+		TwodeeBatchStats batch_stats = g_hw_state.twodee_renderer->take_stats();
+		ps_2d_numcmds = batch_stats.commands;
+		ps_2d_numbatches = batch_stats.batches;
+		ps_2d_numreordered = batch_stats.reordered;
+
 		rhi->begin_default_render_pass(ctx, true);
 
 		// Upscale draw the backbuffer (with postprocessing maybe?)
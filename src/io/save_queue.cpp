@@ -0,0 +1,257 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "save_queue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace srb2::io;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+// How long a crashing shutdown waits for saves already queued.
+constexpr std::chrono::milliseconds kAbandonWait {1000};
+
+struct SaveFailure
+{
+	std::function<void(const char* what)> on_failure;
+	std::string what;
+};
+
+std::optional<std::string> save_file(const SaveRequest& request)
+{
+	std::string temp_path = request.path + ".tmp";
+
+	try
+	{
+		FileStream file {temp_path, FileStreamMode::kWrite};
+		request.write(file);
+		file.close();
+
+		// Copy rather than move the old file to the backup, so there is
+		// never a moment where the destination doesn't exist.
+		if (!request.backup_path.empty() && fs::exists(request.path))
+		{
+			fs::copy_file(request.path, request.backup_path, fs::copy_options::overwrite_existing);
+		}
+
+		fs::rename(temp_path, request.path);
+	}
+	catch (const std::exception& ex)
+	{
+		std::error_code ec;
+		fs::remove(temp_path, ec);
+		return std::string(ex.what());
+	}
+	catch (...)
+	{
+		std::error_code ec;
+		fs::remove(temp_path, ec);
+		return std::string("unknown error");
+	}
+
+	return std::nullopt;
+}
+
+class SaveQueue
+{
+	std::mutex mutex_;
+	std::condition_variable work_cv_;
+	std::condition_variable idle_cv_;
+	std::deque<SaveRequest> pending_;
+	std::vector<SaveFailure> failures_;
+	std::atomic<bool> has_failures_ {false};
+	std::atomic<bool> abandon_ {false};
+	bool busy_ = false;
+	bool stopping_ = false;
+	std::thread thread_;
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock {mutex_};
+
+		for (;;)
+		{
+			work_cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+
+			if (pending_.empty())
+			{
+				// Stopping, and everything queued has been written.
+				return;
+			}
+
+			SaveRequest request = std::move(pending_.front());
+			pending_.pop_front();
+			busy_ = true;
+
+			lock.unlock();
+			std::optional<std::string> error = save_file(request);
+			lock.lock();
+
+			busy_ = false;
+
+			if (error)
+			{
+				failures_.push_back({std::move(request.on_failure), std::move(*error)});
+				has_failures_.store(true, std::memory_order_release);
+			}
+
+			if (pending_.empty())
+			{
+				idle_cv_.notify_all();
+			}
+		}
+	}
+
+public:
+	// Runs at exit, so finish any saves made on the way out. Returns false
+	// if the thread was left running, in which case this must outlive it.
+	bool shutdown()
+	{
+		{
+			std::unique_lock<std::mutex> lock {mutex_};
+			stopping_ = true;
+			work_cv_.notify_one();
+
+			if (abandon_.load(std::memory_order_acquire) &&
+				!idle_cv_.wait_for(lock, kAbandonWait, [this] { return pending_.empty() && !busy_; }))
+			{
+				if (thread_.joinable())
+				{
+					thread_.detach();
+				}
+				return false;
+			}
+		}
+
+		if (thread_.joinable())
+		{
+			thread_.join();
+		}
+		return true;
+	}
+
+	void abandon() { abandon_.store(true, std::memory_order_release); }
+
+	void queue(SaveRequest&& request)
+	{
+		{
+			std::lock_guard<std::mutex> lock {mutex_};
+
+			auto it = std::find_if(
+				pending_.begin(),
+				pending_.end(),
+				[&request](const SaveRequest& r) { return r.path == request.path; }
+			);
+
+			if (it != pending_.end())
+			{
+				// Not started yet, so only the newest contents matter.
+				*it = std::move(request);
+			}
+			else
+			{
+				pending_.push_back(std::move(request));
+			}
+
+			if (!thread_.joinable())
+			{
+				thread_ = std::thread([this] { run(); });
+			}
+		}
+		work_cv_.notify_one();
+	}
+
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock {mutex_};
+		idle_cv_.wait(lock, [this] { return pending_.empty() && !busy_; });
+	}
+
+	void poll()
+	{
+		if (!has_failures_.load(std::memory_order_acquire))
+		{
+			return;
+		}
+
+		std::vector<SaveFailure> failures;
+		{
+			std::lock_guard<std::mutex> lock {mutex_};
+			failures.swap(failures_);
+			has_failures_.store(false, std::memory_order_relaxed);
+		}
+
+		for (SaveFailure& failure : failures)
+		{
+			if (failure.on_failure)
+			{
+				failure.on_failure(failure.what.c_str());
+			}
+		}
+	}
+};
+
+// Owns the queue through exit. A crashing exit may leave the save thread
+// running, so the queue is leaked then rather than destroyed under it.
+struct SaveQueueOwner
+{
+	SaveQueue* queue = new SaveQueue;
+
+	~SaveQueueOwner()
+	{
+		if (queue->shutdown())
+		{
+			delete queue;
+		}
+	}
+};
+
+SaveQueue& save_queue()
+{
+	static SaveQueueOwner owner;
+	return *owner.queue;
+}
+
+} // namespace
+
+void srb2::io::queue_save(SaveRequest&& request)
+{
+	save_queue().queue(std::move(request));
+}
+
+void srb2::io::wait_for_saves()
+{
+	save_queue().wait();
+	save_queue().poll();
+}
+
+void srb2::io::poll_saves()
+{
+	save_queue().poll();
+}
+
+void srb2::io::abandon_saves_on_exit()
+{
+	save_queue().abandon();
+}
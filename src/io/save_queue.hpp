@@ -0,0 +1,55 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_IO_SAVE_QUEUE_HPP__
+#define __SRB2_IO_SAVE_QUEUE_HPP__
+
+#include <functional>
+#include <string>
+
+#include "streams.hpp"
+
+namespace srb2::io
+{
+
+// Saves files on a background thread. The new contents are written to a
+// temporary file next to the destination, which is only renamed over the
+// old file once it is complete, so a crash mid-save leaves the old file
+// intact. Queuing a path that is still waiting to be written replaces the
+// waiting save, so bursts of saves to one file cost one write.
+
+struct SaveRequest
+{
+	std::string path;
+
+	/// @brief If not empty, the previous file is moved here before it is replaced.
+	std::string backup_path;
+
+	/// @brief Writes the whole file. Runs on the save thread, so it must only use what it owns.
+	std::function<void(FileStream&)> write;
+
+	/// @brief Called from poll_saves on the main thread if the save fails.
+	std::function<void(const char* what)> on_failure;
+};
+
+void queue_save(SaveRequest&& request);
+
+/// @brief Blocks until every queued save has finished, then reports failures.
+void wait_for_saves();
+
+/// @brief Reports failed saves. Call regularly from the main thread.
+void poll_saves();
+
+/// @brief For the crash path: at exit, wait only briefly for queued saves,
+/// then leave the save thread behind rather than hang the shutdown.
+void abandon_saves_on_exit();
+
+} // namespace srb2::io
+
+#endif // __SRB2_IO_SAVE_QUEUE_HPP__
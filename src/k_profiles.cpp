@@ -16,6 +16,7 @@
 
 #include <fmt/format.h>
 
+#include "io/save_queue.hpp"
 #include "io/streams.hpp"
 #include "doomtype.h"
 #include "d_main.h" // pandf
@@ -250,7 +251,6 @@ void PR_InitNewProfile(void)
 
 void PR_SaveProfiles(void)
 {
-	namespace fs = std::filesystem;
 	using json = nlohmann::json;
 	using namespace srb2;
 	namespace io = srb2::io;
@@ -316,27 +316,12 @@ void PR_SaveProfiles(void)
 		ng.profiles.emplace_back(std::move(jsonprof));
 	}
 
-	std::vector<uint8_t> ubjson = json::to_ubjson(ng);
-
-	std::string realpath = fmt::format("{}/{}", srb2home, PROFILESFILE);
-	std::string bakpath = fmt::format("{}.bak", realpath);
-
-	if (fs::exists(realpath))
+	io::SaveRequest request;
+	request.path = fmt::format("{}/{}", srb2home, PROFILESFILE);
+	request.backup_path = fmt::format("{}.bak", request.path);
+	request.write = [ng = std::move(ng)](io::FileStream& file)
 	{
-		try
-		{
-			fs::rename(realpath, bakpath);
-		}
-		catch (const fs::filesystem_error& ex)
-		{
-			CONS_Alert(CONS_ERROR, "Failed to record profiles backup. Not attempting to save profiles. %s\n", ex.what());
-			return;
-		}
-	}
-
-	try
-	{
-		io::FileStream file {realpath, io::FileStreamMode::kWrite};
+		std::vector<uint8_t> ubjson = json::to_ubjson(ng);
 
 		io::write(static_cast<uint32_t>(0x52494E47), file, io::Endian::kBE); // "RING"
 		io::write(static_cast<uint32_t>(0x5052464C), file, io::Endian::kBE); // "PRFL"
@@ -345,16 +330,14 @@ void PR_SaveProfiles(void)
 		io::write(static_cast<uint8_t>(0), file); // reserved3
 		io::write(static_cast<uint8_t>(0), file); // reserved4
 		io::write_exact(file, tcb::as_bytes(tcb::make_span(ubjson)));
-		file.close();
-	}
-	catch (const std::exception& ex)
-	{
-		I_Error("Couldn't save profiles. Are you out of Disk space / playing in a protected folder? Check directory for a ringprofiles.prf.bak if the profiles file is corrupt.\n\nException: %s", ex.what());
-	}
-	catch (...)
+	};
+	request.on_failure = [](const char* what)
 	{
-		I_Error("Couldn't save profiles. Are you out of Disk space / playing in a protected folder? Check directory for a ringprofiles.prf.bak if the profiles file is corrupt.");
-	}
+		I_Error("Couldn't save profiles. Are you out of Disk space / playing in a protected folder? Check directory for a ringprofiles.prf.bak if the profiles file is corrupt.\n\nException: %s", what);
+	};
+
+	// Serializing and writing happen on the save thread.
+	io::queue_save(std::move(request));
 }
 
 void PR_LoadProfiles(void)
@@ -373,6 +356,9 @@ void PR_LoadProfiles(void)
 		true
 	);
 
+	// Don't read it back while a save is still writing it.
+	io::wait_for_saves();
+
 	std::string datapath {fmt::format("{}/{}", srb2home, PROFILESFILE)};
 
 	io::BufferedInputStream<io::FileStream> bis;
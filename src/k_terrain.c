@@ -45,6 +45,12 @@ static size_t numTerrainDefs = 0;
 static t_floor_t *terrainFloorDefs = NULL;
 static size_t numTerrainFloorDefs = 0;
 
+// Open addressing on textureHash, holding floor def ID + 1 (0 is empty).
+// Textures look up their terrain by name, so this keeps texture loading
+// from scanning every floor def for every texture.
+static size_t *terrainFloorIndex = NULL;
+static size_t terrainFloorIndexSize = 0; // power of 2
+
 static size_t defaultTerrain = SIZE_MAX;
 static size_t defaultOffroadFootstep = SIZE_MAX;
 
@@ -333,28 +339,134 @@ terrain_t *K_GetDefaultTerrain(void)
 }
 
 /*--------------------------------------------------
-	terrain_t *K_GetTerrainForTextureName(const char *checkName)
+	static t_floor_t *K_FindTerrainFloor(const char *checkName, UINT32 checkHash)
 
-		See header file for description.
+		Finds the first floor definition for a texture
+		name, ignoring case.
+
+	Input Arguments:-
+		checkName - Texture name.
+		checkHash - quickncasehash of the name.
+
+	Return:-
+		The floor definition, or NULL if there is none.
 --------------------------------------------------*/
-terrain_t *K_GetTerrainForTextureName(const char *checkName)
+static t_floor_t *K_FindTerrainFloor(const char *checkName, UINT32 checkHash)
 {
-	UINT32 checkHash = quickncasehash(checkName, 8);
-	size_t i;
+	size_t mask = terrainFloorIndexSize - 1;
+	size_t slot;
 
-	if (numTerrainFloorDefs > 0)
+	if (terrainFloorIndexSize == 0)
 	{
-		for (i = 0; i < numTerrainFloorDefs; i++)
+		return NULL;
+	}
+
+	for (slot = checkHash & mask; terrainFloorIndex[slot] != 0; slot = (slot + 1) & mask)
+	{
+		t_floor_t *f = &terrainFloorDefs[terrainFloorIndex[slot] - 1];
+
+		if (checkHash == f->textureHash && !strncasecmp(checkName, f->textureName, 8))
 		{
-			t_floor_t *f = &terrainFloorDefs[i];
+			return f;
+		}
+	}
 
-			if (checkHash == f->textureHash && !strncasecmp(checkName, f->textureName, 8))
-			{
-				return K_GetTerrainByIndex(f->terrainID);
-			}
+	return NULL;
+}
+
+/*--------------------------------------------------
+	static void K_IndexTerrainFloor(size_t id)
+
+		Adds a new floor definition to the lookup
+		index, growing it as needed.
+
+	Input Arguments:-
+		id - Floor definition ID.
+
+	Return:-
+		None
+--------------------------------------------------*/
+static void K_IndexTerrainFloor(size_t id)
+{
+	t_floor_t *f = &terrainFloorDefs[id];
+	size_t mask;
+	size_t slot;
+
+	if (numTerrainFloorDefs * 2 > terrainFloorIndexSize)
+	{
+		size_t i;
+
+		// Keep it at most half full, and rebuild in order
+		// so earlier definitions still win.
+		terrainFloorIndexSize = (terrainFloorIndexSize == 0) ? 64 : terrainFloorIndexSize * 2;
+		terrainFloorIndex = (size_t *)Z_Realloc(terrainFloorIndex, sizeof(size_t) * terrainFloorIndexSize, PU_STATIC, NULL);
+		memset(terrainFloorIndex, 0, sizeof(size_t) * terrainFloorIndexSize);
+
+		for (i = 0; i < id; i++)
+		{
+			K_IndexTerrainFloor(i);
 		}
 	}
 
+	if (K_FindTerrainFloor(f->textureName, f->textureHash) != NULL)
+	{
+		// Differs only in case; lookups get the first one.
+		return;
+	}
+
+	mask = terrainFloorIndexSize - 1;
+
+	for (slot = f->textureHash & mask; terrainFloorIndex[slot] != 0; slot = (slot + 1) & mask)
+	{
+		;
+	}
+
+	terrainFloorIndex[slot] = id + 1;
+}
+
+/*--------------------------------------------------
+	static void K_RefreshTerrainPointers(void)
+
+		Re-resolves the terrain cached on every
+		texture and level flat. Needed after parsing,
+		since adding definitions can move them.
+
+	Input Arguments:-
+		None
+
+	Return:-
+		None
+--------------------------------------------------*/
+static void K_RefreshTerrainPointers(void)
+{
+	INT32 i;
+	size_t j;
+
+	for (i = 0; i < numtextures; i++)
+	{
+		textures[i]->terrain = K_GetTerrainForTextureName(textures[i]->name);
+	}
+
+	for (j = 0; j < numlevelflats; j++)
+	{
+		levelflats[j].terrain = K_GetTerrainForTextureName(levelflats[j].name);
+	}
+}
+
+/*--------------------------------------------------
+	terrain_t *K_GetTerrainForTextureName(const char *checkName)
+
+		See header file for description.
+--------------------------------------------------*/
+terrain_t *K_GetTerrainForTextureName(const char *checkName)
+{
+	t_floor_t *f = K_FindTerrainFloor(checkName, quickncasehash(checkName, 8));
+
+	if (f != NULL)
+	{
+		return K_GetTerrainByIndex(f->terrainID);
+	}
+
 	// This texture doesn't have a terrain directly applied to it,
 	// so we fallback to the default terrain.
 	return K_GetDefaultTerrain();
@@ -2021,6 +2133,8 @@ static boolean K_TERRAINLumpParser(char *data, size_t size)
 
 						strncpy(f->textureName, tkn, 8);
 						f->textureHash = tknHash;
+
+						K_IndexTerrainFloor(i);
 					}
 
 					Z_Free(tkn);
@@ -2222,5 +2336,7 @@ void K_InitTerrain(UINT16 wadNum)
 		}
 	}
 
+	K_RefreshTerrainPointers();
+
 	R_ClearTextureNumCache(false);
 }
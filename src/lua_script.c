@@ -1699,14 +1699,11 @@ void LUA_UnArchive(savebuffer_t *save, boolean network)
 	{
 		do {
 			mobjnum = READUINT32(save->p); // read a mobjnum
-			for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
-			{
-				if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
-					continue;
-				if (((mobj_t *)th)->mobjnum != mobjnum) // find matching mobj
-					continue;
+			if (mobjnum == UINT32_MAX)
+				break;
+			th = (thinker_t *)P_FindNewPosition(mobjnum); // find matching mobj
+			if (th)
 				UnArchiveExtVars(&save->p, th); // apply variables
-			}
 		} while(mobjnum != UINT32_MAX); // repeat until end of mobjs marker.
 
 		LUA_HookNetArchive(NetUnArchive, save); // call the NetArchive hook in unarchive mode
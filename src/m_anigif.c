@@ -23,10 +23,6 @@
 #include "m_misc.h"
 #include "st_stuff.h" // st_palette
 
-#ifdef HWRENDER
-#include "hardware/hw_main.h"
-#endif
-
 // GIFs are always little-endian
 #include "byteptr.h"
 
@@ -38,8 +34,15 @@ static UINT8 gif_dynamicdelay = (UINT8)0; // and messing something up
 // Palette handling
 static boolean gif_localcolortable = false;
 static boolean gif_colorprofile = false;
-static RGBA_t *gif_headerpalette = NULL;
-static RGBA_t *gif_framepalette = NULL;
+static RGBA_t gif_headerpalette[256];
+static RGBA_t gif_framepalette[256];
+
+// Frames are encoded off the main thread, so the encoder keeps its own
+// copy of everything it reads instead of using vid and screens[].
+static INT32 gif_width = 0;
+static INT32 gif_height = 0;
+static UINT8 *gif_screen = NULL; // this frame, palettized
+static UINT8 *gif_prevscreen = NULL; // last frame, for GIF_optimizeregion
 
 static FILE *gif_out = NULL;
 static INT32 gif_frames = 0;
@@ -62,13 +65,13 @@ static UINT8 gif_writeover = 0;
 static UINT8 GIF_optimizecmprow(const UINT8 *dst, const UINT8 *src, INT32 row,
 	INT32 *last, INT32 *left, INT32 *right)
 {
-	const UINT8 *dp = dst + (vid.width * row);
-	const UINT8 *sp = src + (vid.width * row);
+	const UINT8 *dp = dst + (gif_width * row);
+	const UINT8 *sp = src + (gif_width * row);
 	const UINT8 *dtmp, *stmp;
 	UINT8 doleft = 1, doright = 1;
 	INT32 i = 0;
 
-	if (!memcmp(sp, dp, vid.width))
+	if (!memcmp(sp, dp, gif_width))
 		return 0; // unchanged.
 
 	*last = row;
@@ -95,14 +98,14 @@ static UINT8 GIF_optimizecmprow(const UINT8 *dst, const UINT8 *src, INT32 row,
 	}
 
 	// right side
-	i = vid.width - 1;
-	if (*right == vid.width - 1) // edge reached
+	i = gif_width - 1;
+	if (*right == gif_width - 1) // edge reached
 		doright = 0;
 	else if (*right >= 0) // right set, non-end-of-width
 	{
 		dtmp = dp + *right + 1;
 		stmp = sp + *right + 1;
-		if (!memcmp(stmp, dtmp, vid.width - (*right + 1)))
+		if (!memcmp(stmp, dtmp, gif_width - (*right + 1)))
 			doright = 0; // right side not changed
 	}
 	while (doright)
@@ -132,7 +135,7 @@ static UINT8 GIF_optimizecmprow(const UINT8 *dst, const UINT8 *src, INT32 row,
 static void GIF_optimizeregion(const UINT8 *dst, const UINT8 *src,
 	INT32 *x, INT32 *y, INT32 *w, INT32 *h)
 {
-	INT32 st = 0, sb = vid.height - 1; // work from both directions
+	INT32 st = 0, sb = gif_height - 1; // work from both directions
 	INT32 firstchg_t = -1, firstchg_b = -1; // store first changed row.
 	INT32 lastchg_t = -1, lastchg_b = -1; // Store last row... just in case
 	INT32 lmpix = -1, rmpix = -1; // store left and rightmost change
@@ -143,7 +146,7 @@ static void GIF_optimizeregion(const UINT8 *dst, const UINT8 *src,
 		if (!stopt)
 		{
 			if (GIF_optimizecmprow(dst, src, st++, &lastchg_t, &lmpix, &rmpix)
-			 && lmpix == 0 && rmpix == vid.width - 1)
+			 && lmpix == 0 && rmpix == gif_width - 1)
 				stopt = 1;
 			if (firstchg_t < 0 && lastchg_t >= 0)
 				firstchg_t = lastchg_t;
@@ -151,7 +154,7 @@ static void GIF_optimizeregion(const UINT8 *dst, const UINT8 *src,
 		if (!stopb)
 		{
 			if (GIF_optimizecmprow(dst, src, sb--, &lastchg_b, &lmpix, &rmpix)
-			 && lmpix == 0 && rmpix == vid.width - 1)
+			 && lmpix == 0 && rmpix == gif_width - 1)
 				stopb = 1;
 			if (firstchg_b < 0 && lastchg_b >= 0)
 				firstchg_b = lastchg_b;
@@ -254,7 +257,7 @@ static void GIF_prepareLZW(void)
 	giflzw_nextCodeToAssign = GIFLZW_DICTSTART;
 
 	if (!giflzw_hashTable)
-		giflzw_hashTable = Z_Malloc(16384*sizeof(UINT32), PU_STATIC, NULL);
+		giflzw_hashTable = malloc(16384*sizeof(UINT32));
 	memset(giflzw_hashTable, 0, 16384*sizeof(UINT32));
 }
 
@@ -360,8 +363,8 @@ static void GIF_lzw(void)
 		}
 		if ((scrbuf_pos += scrbuf_downscaleamt) >= scrbuf_lineend)
 		{
-			scrbuf_lineend += (vid.width * scrbuf_downscaleamt);
-			scrbuf_linebegin += (vid.width * scrbuf_downscaleamt);
+			scrbuf_lineend += (gif_width * scrbuf_downscaleamt);
+			scrbuf_linebegin += (gif_width * scrbuf_downscaleamt);
 			scrbuf_pos = scrbuf_linebegin;
 		}
 		// Just a bit of overflow prevention
@@ -409,11 +412,9 @@ const UINT8 gifhead_nsid[19] = {0x21,0xFF,0x0B, // extension block + size
 static RGBA_t *GIF_getpalette(size_t palnum)
 {
 	// In hardware mode, always returns the local palette
-#ifdef HWRENDER
-	if (rendermode == render_opengl)
+	if (rendermode != render_soft)
 		return pLocalPalette;
 	else
-#endif
 		return (gif_colorprofile ? &pLocalPalette[palnum*256] : &pMasterPalette[palnum*256]);
 }
 
@@ -422,7 +423,7 @@ static RGBA_t *GIF_getpalette(size_t palnum)
 // writes the gif palette.
 // used both for the header and local color tables.
 //
-static UINT8 *GIF_palwrite(UINT8 *p, RGBA_t *pal)
+static UINT8 *GIF_palwrite(UINT8 *p, const RGBA_t *pal)
 {
 	INT32 i;
 	for (i = 0; i < 256; i++)
@@ -453,14 +454,14 @@ static void GIF_headwrite(void)
 	if (gif_downscale)
 	{
 		scrbuf_downscaleamt = vid.dupx;
-		rwidth = (vid.width / scrbuf_downscaleamt);
-		rheight = (vid.height / scrbuf_downscaleamt);
+		rwidth = (gif_width / scrbuf_downscaleamt);
+		rheight = (gif_height / scrbuf_downscaleamt);
 	}
 	else
 	{
 		scrbuf_downscaleamt = 1;
-		rwidth = vid.width;
-		rheight = vid.height;
+		rwidth = gif_width;
+		rheight = gif_height;
 	}
 
 	WRITEUINT16(p, rwidth);
@@ -495,14 +496,13 @@ static size_t gifframe_size = 8192;
 // GIF_rgbconvert
 // converts an RGB frame to a frame with a palette.
 //
-#ifdef HWRENDER
 static colorlookup_t gif_colorlookup;
 
 static void GIF_rgbconvert(const UINT8 *linear, UINT8 *scr)
 {
 	UINT8 r, g, b;
 	size_t src = 0, dest = 0;
-	size_t size = (vid.width * vid.height * 3);
+	size_t size = (gif_width * gif_height * 3);
 
 	InitColorLUT(&gif_colorlookup, (gif_localcolortable) ? gif_framepalette : gif_headerpalette, true);
 
@@ -516,88 +516,51 @@ static void GIF_rgbconvert(const UINT8 *linear, UINT8 *scr)
 		dest += scrbuf_downscaleamt;
 	}
 }
-#endif
 
 //
 // GIF_framewrite
 // writes a frame into the file.
 //
-static void GIF_framewrite(INT32 input_width, INT32 input_height, const UINT8 *input)
+static void GIF_framewrite(INT32 input_width, INT32 input_height, const UINT8 *input, const RGBA_t *palette, precise_t frametime)
 {
 	UINT8 *p;
-	UINT8 *movie_screen = screens[2];
+	UINT8 *movie_screen = gif_screen;
 	INT32 blitx, blity, blitw, blith;
 	boolean palchanged;
 
-	(void)input_width;
-	(void)input_height;
+	if (!gif_out)
+		return;
 
-	I_Assert(input_width == vid.width && input_height == vid.height);
+	// The resolution changed mid-recording; the GIF can't follow it
+	if (input_width != gif_width || input_height != gif_height)
+		return;
 
 	if (!gifframe_data)
-		gifframe_data = Z_Malloc(gifframe_size, PU_STATIC, NULL);
+		gifframe_data = malloc(gifframe_size);
 	p = gifframe_data;
 
-	if (!gif_out)
-		return;
-
 	// Lactozilla: Compare the header's palette with the current frame's palette and see if it changed.
 	if (gif_localcolortable)
 	{
-		gif_framepalette = GIF_getpalette(max(st_palette, 0));
+		memcpy(gif_framepalette, palette, sizeof(RGBA_t) * 256);
 		palchanged = memcmp(gif_headerpalette, gif_framepalette, sizeof(RGBA_t) * 256);
 	}
 	else
 		palchanged = false;
 
+	GIF_rgbconvert(input, gif_screen);
+
 	// Compare image data (for optimizing GIF)
 	// If the palette has changed, the entire frame is considered to be different.
 	if (gif_optimize && gif_frames > 0 && (!palchanged))
 	{
-		// before blit movie_screen points to last frame, cur_screen points to this frame
-		UINT8 *cur_screen = screens[0];
-		GIF_optimizeregion(cur_screen, movie_screen, &blitx, &blity, &blitw, &blith);
-
-		// blit to temp screen
-		if (rendermode == render_soft)
-		{
-			I_Assert(input != NULL);
-			GIF_rgbconvert(input, movie_screen);
-		}
-#ifdef HWRENDER
-		else if (rendermode == render_opengl)
-		{
-			UINT8 *linear = HWR_GetScreenshot();
-			GIF_rgbconvert(linear, movie_screen);
-			free(linear);
-		}
-#endif
+		GIF_optimizeregion(gif_screen, gif_prevscreen, &blitx, &blity, &blitw, &blith);
 	}
 	else
 	{
 		blitx = blity = 0;
-		blitw = vid.width;
-		blith = vid.height;
-
-#ifdef HWRENDER
-		// Copy the current OpenGL frame into the base screen
-		if (rendermode == render_opengl)
-		{
-			UINT8 *linear = HWR_GetScreenshot();
-			GIF_rgbconvert(linear, screens[0]);
-			free(linear);
-		}
-#endif
-
-		// Copy the first frame into the movie screen
-		// OpenGL already does the same above.
-		if (gif_frames == 0 && rendermode == render_soft)
-		{
-			I_Assert(input != NULL);
-			GIF_rgbconvert(input, screens[0]);
-		}
-
-		movie_screen = screens[0];
+		blitw = gif_width;
+		blith = gif_height;
 	}
 
 	// screen regions are handled in GIF_lzw
@@ -609,7 +572,7 @@ static void GIF_framewrite(INT32 input_width, INT32 input_height, const UINT8 *i
 		{
 			// golden's attempt at creating a "dynamic delay"
 			UINT16 mingifdelay = 10; // minimum gif delay in milliseconds (keep at 10 because gifs can't get more precise).
-			gif_delayus += (I_GetPreciseTime() - gif_prevframetime) / (I_GetPrecisePrecision() / 1000000); // increase delay by how much time was spent between last measurement
+			gif_delayus += (frametime - gif_prevframetime) / (I_GetPrecisePrecision() / 1000000); // increase delay by how much time was spent between last measurement
 
 			if (gif_delayus/1000 >= mingifdelay) // delay is big enough to be able to effect gif frame delay?
 			{
@@ -622,7 +585,7 @@ static void GIF_framewrite(INT32 input_width, INT32 input_height, const UINT8 *i
 		{
 			float delayf = ceil(100.0f/NEWTICRATE);
 
-			delay = (UINT16)((I_GetPreciseTime() - gif_prevframetime)) / (I_GetPrecisePrecision() / 1000000) /10/1000;
+			delay = (UINT16)((frametime - gif_prevframetime)) / (I_GetPrecisePrecision() / 1000000) /10/1000;
 
 			if (delay < (UINT16)(delayf))
 				delay = (UINT16)(delayf);
@@ -670,19 +633,19 @@ static void GIF_framewrite(INT32 input_width, INT32 input_height, const UINT8 *i
 				WRITEUINT8(p, 0); // They are equal, no Local Color Table needed.
 		}
 
-		scrbuf_pos = movie_screen + blitx + (blity * vid.width);
-		scrbuf_writeend = scrbuf_pos + (blitw - 1) + ((blith - 1) * vid.width);
+		scrbuf_pos = movie_screen + blitx + (blity * gif_width);
+		scrbuf_writeend = scrbuf_pos + (blitw - 1) + ((blith - 1) * gif_width);
 
 		if (!gifbwr_buf)
-			gifbwr_buf = Z_Malloc(256, PU_STATIC, NULL);
+			gifbwr_buf = malloc(256);
 		gifbwr_cur = gifbwr_buf;
 
 		GIF_prepareLZW();
 		giflzw_workingCode = UINT16_MAX;
 		WRITEUINT8(p, gifbwr_bits_min - 1);
 
-		startline = (scrbuf_pos - movie_screen) / vid.width;
-		scrbuf_linebegin = movie_screen + (startline * vid.width) + blitx;
+		startline = (scrbuf_pos - movie_screen) / gif_width;
+		scrbuf_linebegin = movie_screen + (startline * gif_width) + blitx;
 		scrbuf_lineend = scrbuf_linebegin + blitw;
 
 		//prewrite a table clear
@@ -696,7 +659,7 @@ static void GIF_framewrite(INT32 input_width, INT32 input_height, const UINT8 *i
 			if ((size_t)(p - gifframe_data) + gifbwr_bufsize + 1 >= gifframe_size)
 			{
 				INT32 temppos = p - gifframe_data;
-				gifframe_data = Z_Realloc(gifframe_data, (gifframe_size *= 2), PU_STATIC, NULL);
+				gifframe_data = realloc(gifframe_data, (gifframe_size *= 2));
 				p = gifframe_data + temppos; // realloc moves gifframe_data, so p is now invalid
 			}
 
@@ -712,7 +675,11 @@ static void GIF_framewrite(INT32 input_width, INT32 input_height, const UINT8 *i
 	}
 	fwrite(gifframe_data, 1, (p - gifframe_data), gif_out);
 	++gif_frames;
-	gif_prevframetime = I_GetPreciseTime();
+	gif_prevframetime = frametime;
+
+	// This frame is what the next one gets compared against
+	gif_screen = gif_prevscreen;
+	gif_prevscreen = movie_screen;
 }
 
 
@@ -736,7 +703,12 @@ INT32 GIF_open(const char *filename)
 	gif_dynamicdelay = (UINT8)cv_gif_dynamicdelay.value;
 	gif_localcolortable = (!!cv_gif_localcolortable.value);
 	gif_colorprofile = (!!cv_screenshot_colorprofile.value);
-	gif_headerpalette = GIF_getpalette(0);
+	memcpy(gif_headerpalette, GIF_getpalette(0), sizeof(RGBA_t) * 256);
+
+	gif_width = vid.width;
+	gif_height = vid.height;
+	gif_screen = calloc(gif_width, gif_height);
+	gif_prevscreen = calloc(gif_width, gif_height);
 
 	GIF_headwrite();
 	gif_frames = 0;
@@ -746,22 +718,22 @@ INT32 GIF_open(const char *filename)
 }
 
 //
-// GIF_frame
-// writes a frame into the output gif
+// GIF_framepalette
+// copies the palette the frame being captured right now was drawn with
 //
-void GIF_frame(void)
+void GIF_framepalette(RGBA_t *palette)
 {
-	// there's not much actually needed here, is there.
-	GIF_framewrite(vid.width, vid.height, NULL);
+	memcpy(palette, GIF_getpalette(max(st_palette, 0)), sizeof(RGBA_t) * 256);
 }
 
 //
 // GIF_frame_rgb24
 // writes a frame into the output gif, with existing image data
+// and the palette and time it was captured with
 //
-void GIF_frame_rgb24(INT32 width, INT32 height, const UINT8 *buffer)
+void GIF_frame_rgb24(INT32 width, INT32 height, const UINT8 *buffer, const RGBA_t *palette, precise_t frametime)
 {
-	GIF_framewrite(width, height, buffer);
+	GIF_framewrite(width, height, buffer, palette, frametime);
 }
 
 //
@@ -778,18 +750,19 @@ INT32 GIF_close(void)
 	fclose(gif_out);
 	gif_out = NULL;
 
-	if (gifbwr_buf)
-		Z_Free(gifbwr_buf);
+	free(gifbwr_buf);
 	gifbwr_buf = gifbwr_cur = NULL;
 
-	if (gifframe_data)
-		Z_Free(gifframe_data);
+	free(gifframe_data);
 	gifframe_data = NULL;
 
-	if (giflzw_hashTable)
-		Z_Free(giflzw_hashTable);
+	free(giflzw_hashTable);
 	giflzw_hashTable = NULL;
 
+	free(gif_screen);
+	free(gif_prevscreen);
+	gif_screen = gif_prevscreen = NULL;
+
 	CONS_Printf(M_GetText("Animated gif closed; wrote %d frames\n"), gif_frames);
 	return 1;
 }
@@ -27,9 +27,12 @@ extern "C" {
 #endif
 
 #ifdef HAVE_ANIGIF
+// GIF_open and GIF_close run on the main thread. GIF_frame_rgb24 only
+// touches the encoder's own state, so it may run on another thread in
+// between, as long as frames are written one at a time and in order.
 INT32 GIF_open(const char *filename);
-void GIF_frame(void);
-void GIF_frame_rgb24(INT32 width, INT32 height, const UINT8 *buffer);
+void GIF_framepalette(RGBA_t *palette);
+void GIF_frame_rgb24(INT32 width, INT32 height, const UINT8 *buffer, const RGBA_t *palette, precise_t frametime);
 INT32 GIF_close(void);
 #endif
 
@@ -0,0 +1,495 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_bench.cpp
+/// \brief Headless multi-demo benchmark runner built on G_TimeDemo
+///
+/// -benchmark <manifest.json> plays every demo in the manifest back to back
+/// through G_TimeDemo and accumulates the m_perfstats phase timings per tic
+/// and per frame. Combine with -nodraw (no rendering), -software, -nullrhi
+/// (no GPU; also counts draw calls and upload bytes per frame), or
+/// -width/-height to pick the rendering setup. Results are written as JSON
+/// (-benchout, default benchmark.json in the home folder) and compared
+/// against an earlier result file given with -benchbaseline. A demo that
+/// doesn't start playing (missing file, wrong version, ...) is recorded with
+/// an error instead of timings, and fails the run.
+///
+/// Manifest format:
+///   { "demos": ["replay1.lmp", "replay2.lmp"], "threshold": 10 }
+/// "threshold" is the allowed slowdown in percent before a demo's mean tic
+/// or frame cost counts as a regression; -benchthreshold overrides it.
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include "m_bench.h"
+#include "doomdef.h"
+#include "doomstat.h"
+#include "command.h"
+#include "d_main.h" // srb2home
+#include "d_netcmd.h" // timedemo_name
+#include "g_demo.h"
+#include "g_game.h"
+#include "i_system.h"
+#include "i_video.h"
+#include "m_argv.h"
+#include "m_perfstats.h"
+#include "r_main.h"
+#include "rhi/null/null_rhi.hpp"
+
+using nlohmann::json;
+
+namespace
+{
+
+struct PhaseStat
+{
+	UINT64 total = 0;
+	UINT64 max = 0;
+
+	void add(precise_t t)
+	{
+		total += t;
+		max = std::max<UINT64>(max, t);
+	}
+};
+
+struct TicStats
+{
+	PhaseStat total;
+	PhaseStat playerthink;
+	PhaseStat thinkers;
+	PhaseStat bots;
+	PhaseStat lua;
+	PhaseStat acs;
+};
+
+struct FrameStats
+{
+	PhaseStat total;
+	PhaseStat render;
+	PhaseStat bsp;
+	PhaseStat spriteclip;
+	PhaseStat portals;
+	PhaseStat planes;
+	PhaseStat masked;
+	PhaseStat ui;
+	PhaseStat swap;
+};
+
+struct DemoResult
+{
+	std::string name;
+	double loadseconds = 0.0;
+	double wallseconds = 0.0;
+	UINT32 tics = 0;
+	UINT32 frames = 0;
+	TicStats tic;
+	FrameStats frame;
+	srb2::rhi::NullRhiStats rhi; // only counted by the null RHI backend
+	std::string error;
+};
+
+struct Benchmark
+{
+	std::vector<std::string> demos;
+	std::vector<DemoResult> results;
+	size_t current = 0;
+	bool started = false;
+	tic_t waited = 0;
+	double threshold = 10.0;
+	std::string outpath;
+	std::string baselinepath;
+	bool active = false;
+	bool nullrhi = false;
+};
+
+Benchmark g_bench;
+
+// How long a demo may take to start playing before it's given up on
+constexpr tic_t kStartTimeout = 10*TICRATE;
+
+double to_usec(UINT64 t)
+{
+	return static_cast<double>(t) * 1000000.0 / static_cast<double>(I_GetPrecisePrecision());
+}
+
+json phase_json(const PhaseStat& stat, UINT32 count)
+{
+	return json {
+		{"mean", count ? to_usec(stat.total) / count : 0.0},
+		{"max", to_usec(stat.max)},
+	};
+}
+
+json rhi_json(const srb2::rhi::NullRhiStats& stats, UINT32 count)
+{
+	auto mean = [count](UINT64 n) { return count ? static_cast<double>(n) / count : 0.0; };
+
+	return json {
+		{"drawcalls", mean(stats.draw_calls)},
+		{"vertices", mean(stats.vertices)},
+		{"renderpasses", mean(stats.render_passes)},
+		{"pipelinebinds", mean(stats.pipeline_binds)},
+		{"bufferuploads", mean(stats.buffer_uploads)},
+		{"textureuploads", mean(stats.texture_uploads)},
+		{"uploadbytes", mean(stats.buffer_upload_bytes + stats.texture_upload_bytes)},
+		{"bufferuploadbytes", mean(stats.buffer_upload_bytes)},
+		{"textureuploadbytes", mean(stats.texture_upload_bytes)},
+		{"readbackbytes", mean(stats.readback_bytes)},
+		{"resourcescreated", mean(stats.resources_created)},
+	};
+}
+
+json result_json(const DemoResult& r)
+{
+	if (!r.error.empty())
+		return json {{"name", r.name}, {"error", r.error}};
+
+	json out {
+		{"name", r.name},
+		{"loadseconds", r.loadseconds},
+		{"wallseconds", r.wallseconds},
+		{"tics", r.tics},
+		{"frames", r.frames},
+		{"tic", {
+			{"total", phase_json(r.tic.total, r.tics)},
+			{"playerthink", phase_json(r.tic.playerthink, r.tics)},
+			{"thinkers", phase_json(r.tic.thinkers, r.tics)},
+			{"bots", phase_json(r.tic.bots, r.tics)},
+			{"lua", phase_json(r.tic.lua, r.tics)},
+			{"acs", phase_json(r.tic.acs, r.tics)},
+		}},
+		{"frame", {
+			{"total", phase_json(r.frame.total, r.frames)},
+			{"render", phase_json(r.frame.render, r.frames)},
+			{"bsp", phase_json(r.frame.bsp, r.frames)},
+			{"spriteclip", phase_json(r.frame.spriteclip, r.frames)},
+			{"portals", phase_json(r.frame.portals, r.frames)},
+			{"planes", phase_json(r.frame.planes, r.frames)},
+			{"masked", phase_json(r.frame.masked, r.frames)},
+			{"ui", phase_json(r.frame.ui, r.frames)},
+			{"swap", phase_json(r.frame.swap, r.frames)},
+		}},
+	};
+
+	// Per-frame means of the work sent to the (null) RHI
+	if (g_bench.nullrhi)
+		out["rhi"] = rhi_json(r.rhi, r.frames);
+
+	return out;
+}
+
+const char* rendermode_name()
+{
+	if (nodrawers)
+		return "none";
+	switch (rendermode)
+	{
+		case render_soft:
+			return "software";
+		case render_opengl:
+			return "opengl";
+		default:
+			return "none";
+	}
+}
+
+// Compares the mean tic and frame cost of every demo against the baseline
+// result file. Demos missing from the baseline are not checked.
+json find_regressions(const json& results)
+{
+	json regressions = json::array();
+
+	if (g_bench.baselinepath.empty())
+		return regressions;
+
+	json baseline;
+	try
+	{
+		std::ifstream f(g_bench.baselinepath);
+		f >> baseline;
+	}
+	catch (const std::exception& ex)
+	{
+		CONS_Alert(CONS_WARNING, "Benchmark: can't read baseline %s: %s\n", g_bench.baselinepath.c_str(), ex.what());
+		return regressions;
+	}
+
+	const double limit = 1.0 + g_bench.threshold / 100.0;
+
+	for (const json& cur : results)
+	{
+		if (cur.contains("error"))
+			continue;
+
+		for (const json& base : baseline.value("demos", json::array()))
+		{
+			if (base.value("name", "") != cur["name"])
+				continue;
+
+			auto check = [&](const std::string& metric, double before, double after, const char* unit)
+			{
+				if (before > 0.0 && after > before * limit)
+				{
+					regressions.push_back({
+						{"name", cur["name"]},
+						{"metric", metric},
+						{"baseline", before},
+						{"current", after},
+						{"ratio", after / before},
+						{"unit", unit},
+					});
+				}
+			};
+
+			for (const char* metric : {"tic", "frame"})
+			{
+				check(fmt::format("{}.total.mean", metric), base[metric]["total"].value("mean", 0.0),
+					cur[metric]["total"]["mean"], "usec");
+			}
+
+			// Upload volume is only comparable between null RHI runs
+			if (cur.contains("rhi") && base.contains("rhi"))
+			{
+				check("rhi.uploadbytes", base["rhi"].value("uploadbytes", 0.0),
+					cur["rhi"]["uploadbytes"], "bytes");
+			}
+			break;
+		}
+	}
+
+	return regressions;
+}
+
+void write_results()
+{
+	json demos = json::array();
+	bool errors = false;
+	for (const DemoResult& r : g_bench.results)
+	{
+		demos.push_back(result_json(r));
+		errors = errors || !r.error.empty();
+	}
+
+	json regressions = find_regressions(demos);
+
+	json out {
+		{"version", 1},
+		{"rendermode", rendermode_name()},
+		{"rhi", g_bench.nullrhi ? "null" : "default"},
+		{"width", vid.width},
+		{"height", vid.height},
+		{"ticrate", TICRATE},
+		{"threshold", g_bench.threshold},
+		{"demos", demos},
+		{"regressions", regressions},
+		{"passed", regressions.empty() && !errors},
+	};
+
+	try
+	{
+		std::ofstream f(g_bench.outpath);
+		f << out.dump(1, '\t') << '\n';
+		CONS_Printf("Benchmark results saved to '%s'\n", g_bench.outpath.c_str());
+	}
+	catch (const std::exception& ex)
+	{
+		CONS_Alert(CONS_ERROR, "Benchmark: can't write %s: %s\n", g_bench.outpath.c_str(), ex.what());
+	}
+
+	for (const json& reg : regressions)
+	{
+		CONS_Alert(CONS_WARNING, "Benchmark regression: %s %s %.1f -> %.1f %s\n",
+			reg["name"].get<std::string>().c_str(), reg["metric"].get<std::string>().c_str(),
+			reg["baseline"].get<double>(), reg["current"].get<double>(),
+			reg["unit"].get<std::string>().c_str());
+	}
+}
+
+void start_current_demo()
+{
+	DemoResult result;
+	result.name = g_bench.demos[g_bench.current];
+	g_bench.results.push_back(std::move(result));
+	g_bench.started = false;
+	g_bench.waited = 0;
+
+	strlcpy(timedemo_name, g_bench.demos[g_bench.current].c_str(), sizeof timedemo_name);
+	CONS_Printf("Benchmark %s/%s: timing demo '%s'.\n",
+		sizeu1(g_bench.current + 1), sizeu2(g_bench.demos.size()), timedemo_name);
+	G_TimeDemo(timedemo_name);
+}
+
+void next_demo()
+{
+	g_bench.current++;
+	if (g_bench.current < g_bench.demos.size())
+	{
+		start_current_demo();
+		return;
+	}
+
+	write_results();
+	g_bench.active = false;
+	COM_ImmedExecute("quit");
+}
+
+} // namespace
+
+boolean M_BenchmarkStart(const char *manifest)
+{
+	json object;
+
+	try
+	{
+		std::ifstream f(manifest);
+		f >> object;
+
+		for (const json& demo : object.at("demos"))
+			g_bench.demos.push_back(demo.get<std::string>());
+
+		g_bench.threshold = object.value("threshold", g_bench.threshold);
+	}
+	catch (const std::exception& ex)
+	{
+		CONS_Alert(CONS_ERROR, "Benchmark: invalid manifest %s: %s\n", manifest, ex.what());
+		g_bench.demos.clear();
+		return false;
+	}
+
+	if (g_bench.demos.empty())
+	{
+		CONS_Alert(CONS_ERROR, "Benchmark: manifest %s lists no demos\n", manifest);
+		return false;
+	}
+
+	if (M_CheckParm("-benchthreshold") && M_IsNextParm())
+		g_bench.threshold = atof(M_GetNextParm());
+
+	if (M_CheckParm("-benchout") && M_IsNextParm())
+		g_bench.outpath = M_GetNextParm();
+	else
+		g_bench.outpath = fmt::format("{}" PATHSEP "{}", srb2home, "benchmark.json");
+
+	if (M_CheckParm("-benchbaseline") && M_IsNextParm())
+		g_bench.baselinepath = M_GetNextParm();
+
+	g_bench.active = true;
+	g_bench.current = 0;
+	timedemo_quit = false;
+	timedemo_csv = false;
+
+	start_current_demo();
+	return true;
+}
+
+boolean M_BenchmarkActive(void)
+{
+	return g_bench.active;
+}
+
+void M_BenchmarkTic(void)
+{
+	if (!g_bench.active)
+		return;
+
+	// A demo that fails to load stops at a menu prompt and never finishes
+	if (!g_bench.started)
+	{
+		if (++g_bench.waited > kStartTimeout)
+		{
+			CONS_Alert(CONS_ERROR, "Benchmark: demo '%s' failed to start\n", g_bench.results.back().name.c_str());
+			g_bench.results.back().error = "demo failed to start";
+			G_StopDemo();
+			next_demo();
+		}
+		return;
+	}
+
+	if (!demo.timing || gamestate != GS_LEVEL)
+		return;
+
+	TicStats& tic = g_bench.results.back().tic;
+
+	g_bench.results.back().tics++;
+	tic.total.add(ps_tictime);
+	tic.playerthink.add(ps_playerthink_time);
+	tic.thinkers.add(ps_thinkertime);
+	tic.bots.add(ps_botticcmd_time);
+	tic.lua.add(ps_lua_thinkframe_time);
+	tic.acs.add(ps_acs_time);
+}
+
+void M_BenchmarkFrame(void)
+{
+	if (!g_bench.active || !demo.timing || gamestate != GS_LEVEL)
+		return;
+
+	FrameStats& frame = g_bench.results.back().frame;
+
+	g_bench.results.back().frames++;
+	frame.total.add(ps_rendercalltime + ps_uitime + ps_swaptime);
+	frame.render.add(ps_rendercalltime);
+	frame.bsp.add(ps_bsptime);
+	if (rendermode == render_soft)
+	{
+		frame.spriteclip.add(ps_sw_spritecliptime);
+		frame.portals.add(ps_sw_portaltime);
+		frame.planes.add(ps_sw_planetime);
+		frame.masked.add(ps_sw_maskedtime);
+	}
+	frame.ui.add(ps_uitime);
+	frame.swap.add(ps_swaptime);
+
+	// The frame was just presented, so the backend's last frame is this one
+	srb2::rhi::Rhi* rhi = srb2::sys::get_rhi(srb2::sys::g_current_rhi);
+	if (auto* null = dynamic_cast<srb2::rhi::NullRhi*>(rhi))
+	{
+		g_bench.nullrhi = true;
+		g_bench.results.back().rhi += null->last_frame_stats();
+	}
+}
+
+void M_BenchmarkLevelLoaded(tic_t loadtics)
+{
+	if (!g_bench.active)
+		return;
+
+	DemoResult& result = g_bench.results.back();
+	g_bench.started = true;
+
+	// Only the playback itself is measured, not the level load
+	result.loadseconds = (double)loadtics / TICRATE;
+	result.tic = {};
+	result.frame = {};
+	result.rhi = {};
+	result.tics = 0;
+	result.frames = 0;
+}
+
+void M_BenchmarkDemoDone(tic_t gametics, INT32 realtics)
+{
+	if (!g_bench.active)
+		return;
+
+	DemoResult& result = g_bench.results.back();
+	result.wallseconds = (double)realtics / TICRATE;
+
+	CONS_Printf("Benchmark: '%s' ran %u gametics, mean tic %.1f usec, mean frame %.1f usec\n",
+		result.name.c_str(), gametics,
+		result.tics ? to_usec(result.tic.total.total) / result.tics : 0.0,
+		result.frames ? to_usec(result.frame.total.total) / result.frames : 0.0);
+
+	next_demo();
+}
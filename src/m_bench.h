@@ -0,0 +1,43 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_bench.h
+/// \brief Headless multi-demo benchmark runner built on G_TimeDemo
+
+#ifndef __M_BENCH_H__
+#define __M_BENCH_H__
+
+#include "doomtype.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Loads a JSON manifest of demos and starts timing the first one.
+// Returns false if the manifest could not be read.
+boolean M_BenchmarkStart(const char *manifest);
+
+boolean M_BenchmarkActive(void);
+
+// Accumulate ps_* timings after each game tic / displayed frame. The tic
+// hook also gives up on a demo that doesn't start playing in time.
+void M_BenchmarkTic(void);
+void M_BenchmarkFrame(void);
+
+// Level finished loading; the timings for this demo start now.
+void M_BenchmarkLevelLoaded(tic_t loadtics);
+
+// The current demo finished. Starts the next one, or writes the results
+// and quits after the last.
+void M_BenchmarkDemoDone(tic_t gametics, INT32 realtics);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __M_BENCH_H__
@@ -27,6 +27,15 @@
 #endif
 
 #include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <errno.h>
 
 // Extended map support.
@@ -769,6 +778,150 @@ void M_SaveConfig(const char *filename)
 	}
 }
 
+// ==========================================================================
+//                              CAPTURE QUEUE
+// ==========================================================================
+
+// Screenshots and movie frames are compressed and written on their own
+// thread, so encoding never holds up a frame. Each job carries a copy of the
+// pixels and of any game state the encoder needs. Anything that has to
+// happen on the main thread afterwards (console messages, stopping the movie)
+// is posted back and run from M_ScreenshotTicker.
+namespace
+{
+
+// Set on the capture thread, where errors can't go through I_Error.
+thread_local bool g_on_capture_thread = false;
+
+class CaptureQueue
+{
+public:
+	// Movie frames queued beyond this are dropped instead of stalling the game
+	static constexpr size_t kMaxPendingFrames = 8;
+
+	~CaptureQueue()
+	{
+		{
+			std::lock_guard lock(mutex_);
+			stop_ = true;
+		}
+		work_cond_.notify_all();
+		if (thread_.joinable())
+			thread_.join();
+	}
+
+	// Screenshots are never dropped.
+	void push(std::function<void()> job) { enqueue(std::move(job), false); }
+
+	// Returns false if the frame was dropped because the encoder is behind.
+	bool push_frame(std::function<void()> job)
+	{
+		{
+			std::lock_guard lock(mutex_);
+			if (pending_frames_ >= kMaxPendingFrames)
+			{
+				dropped_frames_++;
+				return false;
+			}
+		}
+		enqueue(std::move(job), true);
+		return true;
+	}
+
+	// Blocks until every queued job has finished.
+	void flush()
+	{
+		std::unique_lock lock(mutex_);
+		idle_cond_.wait(lock, [this] { return jobs_.empty() && !busy_; });
+	}
+
+	size_t take_dropped_frames()
+	{
+		std::lock_guard lock(mutex_);
+		return std::exchange(dropped_frames_, 0);
+	}
+
+	// Called from jobs; fn runs on the main thread.
+	void post_main(std::function<void()> fn)
+	{
+		std::lock_guard lock(mutex_);
+		completions_.push_back(std::move(fn));
+	}
+
+	void run_completions()
+	{
+		std::vector<std::function<void()>> completions;
+		{
+			std::lock_guard lock(mutex_);
+			completions.swap(completions_);
+		}
+		for (auto& fn : completions)
+			fn();
+	}
+
+private:
+	struct Job
+	{
+		std::function<void()> fn;
+		bool frame;
+	};
+
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable work_cond_;
+	std::condition_variable idle_cond_;
+	std::deque<Job> jobs_;
+	std::vector<std::function<void()>> completions_;
+	size_t pending_frames_ = 0;
+	size_t dropped_frames_ = 0;
+	bool busy_ = false;
+	bool stop_ = false;
+
+	void enqueue(std::function<void()> fn, bool frame)
+	{
+		{
+			std::lock_guard lock(mutex_);
+			jobs_.push_back({std::move(fn), frame});
+			if (frame)
+				pending_frames_++;
+			if (!thread_.joinable())
+				thread_ = std::thread([this] { run(); });
+		}
+		work_cond_.notify_one();
+	}
+
+	void run()
+	{
+		g_on_capture_thread = true;
+
+		std::unique_lock lock(mutex_);
+		for (;;)
+		{
+			work_cond_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+			if (jobs_.empty())
+				return; // stopping, and everything was written
+
+			Job job = std::move(jobs_.front());
+			jobs_.pop_front();
+			busy_ = true;
+
+			lock.unlock();
+			job.fn();
+			lock.lock();
+
+			if (job.frame)
+				pending_frames_--;
+			busy_ = false;
+			if (jobs_.empty())
+				idle_cond_.notify_all();
+		}
+	}
+};
+
+CaptureQueue g_capture;
+
+} // namespace
+
 // ==========================================================================
 //                              SCREENSHOTS
 // ==========================================================================
@@ -847,7 +1000,16 @@ static const char *Newsnapshotfile(const char *pathname, const char *ext)
 FUNCNORETURN static void PNG_error(png_structp PNG, png_const_charp pngtext)
 {
 	//CONS_Debug(DBG_RENDER, "libpng error at %p: %s", PNG, pngtext);
-	I_Error("libpng error at %p: %s", (void*)PNG, pngtext);
+	if (!g_on_capture_thread)
+		I_Error("libpng error at %p: %s", (void*)PNG, pngtext);
+
+	// Every writer on the capture thread sets a jump buffer; report the
+	// error from the main thread and unwind back to it.
+	{
+		std::string text = pngtext;
+		g_capture.post_main([text] { CONS_Alert(CONS_ERROR, "libpng error: %s\n", text.c_str()); });
+	}
+	longjmp(png_jmpbuf(PNG), 1);
 }
 
 static void PNG_warn(png_structp PNG, png_const_charp pngtext)
@@ -889,53 +1051,38 @@ static void M_PNGhdr(png_structp png_ptr, png_infop png_info_ptr, PNG_CONST png_
 	}
 }
 
-static void M_PNGText(png_structp png_ptr, png_infop png_info_ptr, PNG_CONST png_byte movie)
+// Game state and settings a PNG is written with. Captured when the picture
+// is taken, since the file itself may be written later by the capture queue.
+struct PNGInfo
 {
-#ifdef PNG_TEXT_SUPPORTED
-#define SRB2PNGTXT 11 //PNG_KEYWORD_MAX_LENGTH(79) is the max
-	png_text png_infotext[SRB2PNGTXT];
-	char keytxt[SRB2PNGTXT][12] = {
-	"Title", "Description", "Playername", "Mapnum", "Mapname",
-	"Location", "Interface", "Render Mode", "Revision", "Build Date", "Build Time"};
-	char titletxt[] = "Dr. Robotnik's Ring Racers " VERSIONSTRING;
-	png_charp playertxt =  cv_playername[0].zstring;
-	char desctxt[] = "Ring Racers Screenshot";
-	char Movietxt[] = "Ring Racers Movie";
-	size_t i;
-	char interfacetxt[] =
-#ifdef HAVE_SDL
-	 "SDL";
-#else
-	 "Unknown";
-#endif
-	char rendermodetxt[9];
-	char maptext[8];
+	std::string player;
+	std::string rendermode;
+	std::string lvlttl;
+	std::string location;
+	INT32 zlevel, zmemory, zstrategy, zwindowbits;
+};
+
+static PNGInfo M_GetPNGInfo(void)
+{
+	PNGInfo info;
 	char lvlttltext[48];
 	char locationtxt[40];
-	char ctrevision[40];
-	char ctdate[40];
-	char cttime[40];
+
+	info.player = cv_playername[0].zstring;
 
 	switch (rendermode)
 	{
 		case render_soft:
-			strcpy(rendermodetxt, "Software");
+			info.rendermode = "Software";
 			break;
 		case render_opengl:
-			strcpy(rendermodetxt, "OpenGL");
+			info.rendermode = "OpenGL";
 			break;
 		default: // Just in case
-			strcpy(rendermodetxt, "None");
+			info.rendermode = "None";
 			break;
 	}
 
-#if 0
-	if (gamestate == GS_LEVEL)
-		snprintf(maptext, 8, "%s", G_BuildMapName(gamemap));
-	else
-#endif
-		snprintf(maptext, 8, "Unknown");
-
 	if (gamestate == GS_LEVEL && mapheaderinfo[gamemap-1]->lvlttl[0] != '\0')
 		snprintf(lvlttltext, 48, "%s%s%s",
 			mapheaderinfo[gamemap-1]->lvlttl,
@@ -944,6 +1091,7 @@ static void M_PNGText(png_structp png_ptr, png_infop png_info_ptr, PNG_CONST png
 			(mapheaderinfo[gamemap-1]->actnum > 0) ? va(" %d",mapheaderinfo[gamemap-1]->actnum) : "");
 	else
 		snprintf(lvlttltext, 48, "Unknown");
+	info.lvlttl = lvlttltext;
 
 	if (gamestate == GS_LEVEL && players[g_localplayers[0]].mo)
 		snprintf(locationtxt, 40, "X:%d Y:%d Z:%d A:%d",
@@ -953,6 +1101,40 @@ static void M_PNGText(png_structp png_ptr, png_infop png_info_ptr, PNG_CONST png
 			FixedInt(AngleFixed(players[g_localplayers[0]].mo->angle)));
 	else
 		snprintf(locationtxt, 40, "Unknown");
+	info.location = locationtxt;
+
+	info.zlevel = cv_zlib_level.value;
+	info.zmemory = cv_zlib_memory.value;
+	info.zstrategy = cv_zlib_strategy.value;
+	info.zwindowbits = cv_zlib_window_bits.value;
+
+	return info;
+}
+
+static void M_PNGText(png_structp png_ptr, png_infop png_info_ptr, const PNGInfo &info, PNG_CONST png_byte movie)
+{
+#ifdef PNG_TEXT_SUPPORTED
+#define SRB2PNGTXT 11 //PNG_KEYWORD_MAX_LENGTH(79) is the max
+	png_text png_infotext[SRB2PNGTXT];
+	char keytxt[SRB2PNGTXT][12] = {
+	"Title", "Description", "Playername", "Mapnum", "Mapname",
+	"Location", "Interface", "Render Mode", "Revision", "Build Date", "Build Time"};
+	char titletxt[] = "Dr. Robotnik's Ring Racers " VERSIONSTRING;
+	char desctxt[] = "Ring Racers Screenshot";
+	char Movietxt[] = "Ring Racers Movie";
+	size_t i;
+	char interfacetxt[] =
+#ifdef HAVE_SDL
+	 "SDL";
+#else
+	 "Unknown";
+#endif
+	char maptext[8];
+	char ctrevision[40];
+	char ctdate[40];
+	char cttime[40];
+
+	snprintf(maptext, 8, "Unknown");
 
 	memset(png_infotext,0x00,sizeof (png_infotext));
 
@@ -964,18 +1146,21 @@ static void M_PNGText(png_structp png_ptr, png_infop png_info_ptr, PNG_CONST png
 		png_infotext[1].text = Movietxt;
 	else
 		png_infotext[1].text = desctxt;
-	png_infotext[2].text = playertxt;
+	png_infotext[2].text = const_cast<png_charp>(info.player.c_str());
 	png_infotext[3].text = maptext;
-	png_infotext[4].text = lvlttltext;
-	png_infotext[5].text = locationtxt;
+	png_infotext[4].text = const_cast<png_charp>(info.lvlttl.c_str());
+	png_infotext[5].text = const_cast<png_charp>(info.location.c_str());
 	png_infotext[6].text = interfacetxt;
-	png_infotext[7].text = rendermodetxt;
+	png_infotext[7].text = const_cast<png_charp>(info.rendermode.c_str());
 	png_infotext[8].text = strncpy(ctrevision, comprevision, sizeof(ctrevision)-1);
 	png_infotext[9].text = strncpy(ctdate, compdate, sizeof(ctdate)-1);
 	png_infotext[10].text = strncpy(cttime, comptime, sizeof(cttime)-1);
 
 	png_set_text(png_ptr, png_info_ptr, png_infotext, SRB2PNGTXT);
 #undef SRB2PNGTXT
+#else
+	(void)info;
+	(void)movie;
 #endif
 }
 
@@ -999,6 +1184,13 @@ static png_infop   apng_info_ptr = NULL;
 static apng_infop  apng_ainfo_ptr = NULL;
 static png_FILE_p  apng_FILE = NULL;
 static png_uint_32 apng_frames = 0;
+static png_uint_32 apng_queued = 0; // frames handed to the capture queue
+static boolean apng_failed = false; // libpng gave up on a frame; written on the capture queue
+
+// Captured when the movie starts, since frames are written on the capture queue
+static png_uint_32 apng_width, apng_height;
+static png_uint_16 apng_downscaleamt = 1;
+static png_uint_16 apng_delay;
 #ifdef PNG_STATIC // Win32 build have static libpng
 #define aPNG_set_acTL png_set_acTL
 #define aPNG_write_frame_head png_write_frame_head
@@ -1096,14 +1288,29 @@ static inline boolean M_PNGLib(void)
 
 static void M_PNGFrame(png_structp png_ptr, png_infop png_info_ptr, png_bytep png_buf)
 {
-	png_uint_16 downscale = apng_downscale ? vid.dupx : 1;
+	png_uint_16 downscale = apng_downscaleamt;
 
 	png_uint_32 pitch = png_get_rowbytes(png_ptr, png_info_ptr);
-	PNG_CONST png_uint_32 width = vid.width / downscale;
-	PNG_CONST png_uint_32 height = vid.height / downscale;
-	png_bytepp row_pointers = (png_bytepp) png_malloc(png_ptr, height * sizeof (png_bytep));
+	PNG_CONST png_uint_32 width = apng_width / downscale;
+	PNG_CONST png_uint_32 height = apng_height / downscale;
+	png_bytepp row_pointers;
 	png_uint_32 x, y;
-	png_uint_16 framedelay = (png_uint_16)cv_apng_delay.value;
+	png_uint_16 framedelay = apng_delay;
+
+	// After an error the write struct can't be used again
+	if (apng_failed)
+		return;
+
+#ifdef PNG_SETJMP_SUPPORTED
+	if (setjmp(png_jmpbuf(png_ptr)))
+	{
+		apng_failed = true;
+		g_capture.post_main([] { if (moviemode == MM_APNG) M_StopMovie(); });
+		return;
+	}
+#endif
+
+	row_pointers = (png_bytepp) png_malloc(png_ptr, height * sizeof (png_bytep));
 
 	apng_frames++;
 
@@ -1163,6 +1370,10 @@ static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 	apng_downscale = (!!cv_apng_downscale.value);
 
 	downscale = apng_downscale ? vid.dupx : 1;
+	apng_downscaleamt = downscale;
+	apng_width = vid.width;
+	apng_height = vid.height;
+	apng_delay = (png_uint_16)cv_apng_delay.value;
 
 	apng_FILE = fopen(filename,"wb+"); // + mode for reading
 	if (!apng_FILE)
@@ -1216,7 +1427,7 @@ static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 
 	M_PNGhdr(apng_ptr, apng_info_ptr, vid.width / downscale, vid.height / downscale, pal);
 
-	M_PNGText(apng_ptr, apng_info_ptr, true);
+	M_PNGText(apng_ptr, apng_info_ptr, M_GetPNGInfo(), true);
 
 	apng_set_set_acTL_fn(apng_ptr, apng_ainfo_ptr, aPNG_set_acTL);
 
@@ -1225,6 +1436,8 @@ static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 	apng_write_info(apng_ptr, apng_info_ptr, apng_ainfo_ptr);
 
 	apng_frames = 0;
+	apng_queued = 0;
+	apng_failed = false;
 
 	return true;
 }
@@ -1390,6 +1603,7 @@ void M_StartMovie(moviemode_t mode)
 #endif
 }
 
+static void M_SaveFrame_GIF(uint32_t width, uint32_t height, tcb::span<const std::byte> data);
 static void M_SaveFrame_AVRecorder(uint32_t width, uint32_t height, tcb::span<const std::byte> data);
 
 void M_LegacySaveFrame(void)
@@ -1430,12 +1644,19 @@ void M_LegacySaveFrame(void)
 			takescreenshot = true;
 			return;
 		case MM_GIF:
-			GIF_frame();
+#ifdef HWRENDER
+			{
+				UINT8 *linear = HWR_GetScreenshot();
+				if (linear)
+					M_SaveFrame_GIF(vid.width, vid.height, tcb::as_bytes(tcb::span(linear, 3 * vid.width * vid.height)));
+				free(linear);
+			}
+#endif
 			return;
 		case MM_APNG:
 #ifdef USE_APNG
 			{
-				UINT8 *linear = NULL;
+				std::vector<UINT8> frame;
 				if (!apng_FILE) // should not happen!!
 				{
 					moviemode = MM_OFF;
@@ -1445,20 +1666,30 @@ void M_LegacySaveFrame(void)
 				if (rendermode == render_soft)
 				{
 					// munge planar buffer to linear
-					linear = screens[2];
-					I_ReadScreen(linear);
+					frame.resize(vid.width * vid.height);
+					I_ReadScreen(frame.data());
 				}
 #ifdef HWRENDER
 				else
-					linear = HWR_GetScreenshot();
-#endif
-				M_PNGFrame(apng_ptr, apng_info_ptr, (png_bytep)linear);
-#ifdef HWRENDER
-				if (rendermode != render_soft && linear)
+				{
+					UINT8 *linear = HWR_GetScreenshot();
+					if (linear)
+						frame.assign(linear, linear + 3 * vid.width * vid.height);
 					free(linear);
+				}
 #endif
+				if (frame.empty())
+					return;
+
+				if (g_capture.push_frame([frame = std::move(frame)]() mutable
+					{
+						M_PNGFrame(apng_ptr, apng_info_ptr, (png_bytep)frame.data());
+					}))
+				{
+					apng_queued++;
+				}
 
-				if (apng_frames == PNG_UINT_31_MAX)
+				if (apng_queued == PNG_UINT_31_MAX)
 				{
 					CONS_Alert(CONS_NOTICE, M_GetText("Max movie size reached\n"));
 					M_StopMovie();
@@ -1500,7 +1731,18 @@ static void M_SaveFrame_GIF(uint32_t width, uint32_t height, tcb::span<const std
 
 	oldtic = I_GetTime();
 
-	GIF_frame_rgb24(width, height, reinterpret_cast<const uint8_t*>(data.data()));
+	// Everything the encoder needs is copied now; it runs after this frame is gone
+	auto begin = reinterpret_cast<const UINT8*>(data.data());
+	std::vector<UINT8> frame(begin, begin + data.size_bytes());
+	std::array<RGBA_t, 256> palette;
+	precise_t frametime = I_GetPreciseTime();
+
+	GIF_framepalette(palette.data());
+
+	g_capture.push_frame([=, frame = std::move(frame)]
+		{
+			GIF_frame_rgb24(width, height, frame.data(), palette.data(), frametime);
+		});
 }
 
 static void M_SaveFrame_AVRecorder(uint32_t width, uint32_t height, tcb::span<const std::byte> data)
@@ -1544,7 +1786,21 @@ void M_SaveFrame(uint32_t width, uint32_t height, tcb::span<const std::byte> dat
 void M_StopMovie(void)
 {
 #if NUMSCREENS > 2
-	switch (moviemode)
+	const moviemode_t mode = moviemode;
+	size_t dropped;
+
+	if (mode == MM_OFF)
+		return;
+
+	// Off before running completions, since those can stop the movie too
+	moviemode = MM_OFF;
+
+	// Finish writing every frame that was captured before closing the file
+	g_capture.flush();
+	g_capture.run_completions();
+	dropped = g_capture.take_dropped_frames();
+
+	switch (mode)
 	{
 		case MM_GIF:
 			if (!GIF_close())
@@ -1555,7 +1811,7 @@ void M_StopMovie(void)
 			if (!apng_FILE)
 				return;
 
-			if (apng_frames)
+			if (apng_frames && !apng_failed)
 			{
 				M_PNGfix_acTL(apng_ptr, apng_info_ptr, apng_ainfo_ptr);
 				apng_write_end(apng_ptr, apng_info_ptr, apng_ainfo_ptr);
@@ -1581,8 +1837,10 @@ void M_StopMovie(void)
 		default:
 			return;
 	}
-	moviemode = MM_OFF;
 	CONS_Printf(M_GetText("Movie mode disabled.\n"));
+
+	if (dropped)
+		CONS_Alert(CONS_WARNING, M_GetText("%s frames were dropped because encoding couldn't keep up.\n"), sizeu1(dropped));
 #endif
 }
 
@@ -1590,16 +1848,10 @@ void M_StopMovie(void)
 //                            SCREEN SHOTS
 // ==========================================================================
 #ifdef USE_PNG
-/** Writes a PNG file to disk.
-  *
-  * \param filename Filename to write to.
-  * \param data     The image data.
-  * \param width    Width of the picture.
-  * \param height   Height of the picture.
-  * \param palette  Palette of image data.
-  *  \note if palette is NULL, BGR888 format
+/** Writes a PNG file to disk with game state captured earlier. Safe to call
+  * from the capture queue.
   */
-boolean M_SavePNG(const char *filename, const void *data, int width, int height, const UINT8 *palette)
+static boolean M_WritePNG(const char *filename, const void *data, int width, int height, const UINT8 *palette, const PNGInfo &info)
 {
 	png_structp png_ptr;
 	png_infop png_info_ptr;
@@ -1613,14 +1865,14 @@ boolean M_SavePNG(const char *filename, const void *data, int width, int height,
 	png_FILE = fopen(filename,"wb");
 	if (!png_FILE)
 	{
-		CONS_Debug(DBG_RENDER, "M_SavePNG: Error on opening %s for write\n", filename);
+		CONS_Debug(DBG_RENDER, "M_WritePNG: Error on opening %s for write\n", filename);
 		return false;
 	}
 
 	png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, PNG_error, PNG_warn);
 	if (!png_ptr)
 	{
-		CONS_Debug(DBG_RENDER, "M_SavePNG: Error on initialize libpng\n");
+		CONS_Debug(DBG_RENDER, "M_WritePNG: Error on initialize libpng\n");
 		fclose(png_FILE);
 		remove(filename);
 		return false;
@@ -1629,7 +1881,7 @@ boolean M_SavePNG(const char *filename, const void *data, int width, int height,
 	png_info_ptr = png_create_info_struct(png_ptr);
 	if (!png_info_ptr)
 	{
-		CONS_Debug(DBG_RENDER, "M_SavePNG: Error on allocate for libpng\n");
+		CONS_Debug(DBG_RENDER, "M_WritePNG: Error on allocate for libpng\n");
 		png_destroy_write_struct(&png_ptr,  NULL);
 		fclose(png_FILE);
 		remove(filename);
@@ -1659,14 +1911,14 @@ boolean M_SavePNG(const char *filename, const void *data, int width, int height,
 
 	//png_set_filter(png_ptr, 0, PNG_ALL_FILTERS);
 
-	png_set_compression_level(png_ptr, cv_zlib_level.value);
-	png_set_compression_mem_level(png_ptr, cv_zlib_memory.value);
-	png_set_compression_strategy(png_ptr, cv_zlib_strategy.value);
-	png_set_compression_window_bits(png_ptr, cv_zlib_window_bits.value);
+	png_set_compression_level(png_ptr, info.zlevel);
+	png_set_compression_mem_level(png_ptr, info.zmemory);
+	png_set_compression_strategy(png_ptr, info.zstrategy);
+	png_set_compression_window_bits(png_ptr, info.zwindowbits);
 
 	M_PNGhdr(png_ptr, png_info_ptr, width, height, palette);
 
-	M_PNGText(png_ptr, png_info_ptr, false);
+	M_PNGText(png_ptr, png_info_ptr, info, false);
 
 	png_write_info(png_ptr, png_info_ptr);
 
@@ -1678,6 +1930,20 @@ boolean M_SavePNG(const char *filename, const void *data, int width, int height,
 	fclose(png_FILE);
 	return true;
 }
+
+/** Writes a PNG file to disk.
+  *
+  * \param filename Filename to write to.
+  * \param data     The image data.
+  * \param width    Width of the picture.
+  * \param height   Height of the picture.
+  * \param palette  Palette of image data.
+  *  \note if palette is NULL, BGR888 format
+  */
+boolean M_SavePNG(const char *filename, const void *data, int width, int height, const UINT8 *palette)
+{
+	return M_WritePNG(filename, data, width, height, palette, M_GetPNGInfo());
+}
 #else
 /** PCX file structure.
   */
@@ -1827,9 +2093,53 @@ void M_DoScreenShot(UINT32 width, UINT32 height, tcb::span<const std::byte> data
 	else
 #endif
 	{
-		const void* pixel_data = static_cast<const void*>(data.data());
 #ifdef USE_PNG
-		ret = M_SavePNG(va(pandf,pathname,freename), pixel_data, width, height, NULL);
+		// Compress and write it on the capture queue. The file is created
+		// now so the next screenshot doesn't pick the same name.
+		std::string filepath = va(pandf,pathname,freename);
+		FILE *reserve = fopen(filepath.c_str(), "wb");
+		if (!reserve)
+			goto failure;
+		fclose(reserve);
+
+		auto begin = reinterpret_cast<const UINT8*>(data.data());
+		std::vector<UINT8> pixels(begin, begin + data.size_bytes());
+		std::string name = freename;
+		std::string dir = pathname;
+		boolean movie = (moviemode == MM_SCREENSHOT);
+
+		auto job = [=, pixels = std::move(pixels), info = M_GetPNGInfo()]
+		{
+			boolean ok = M_WritePNG(filepath.c_str(), pixels.data(), width, height, NULL, info);
+
+			if (!ok)
+				remove(filepath.c_str());
+
+			g_capture.post_main([=]
+				{
+					if (ok)
+					{
+						if (!movie)
+							CONS_Printf(M_GetText("Screen shot %s saved in %s\n"), name.c_str(), dir.c_str());
+						return;
+					}
+
+					CONS_Alert(CONS_ERROR, M_GetText("Couldn't create screen shot %s in %s\n"), name.c_str(), dir.c_str());
+
+					if (movie && moviemode == MM_SCREENSHOT)
+						M_StopMovie();
+				});
+		};
+
+		// Screenshot movie mode takes one every tic; drop those like any movie frame
+		if (movie)
+		{
+			if (!g_capture.push_frame(std::move(job)))
+				remove(filepath.c_str());
+		}
+		else
+			g_capture.push(std::move(job));
+		return;
 #else
 		ret = WritePCXfile(va(pandf,pathname,freename), linear, vid.width, vid.height, screenshot_palette);
 #endif
@@ -1858,6 +2168,9 @@ void M_ScreenshotTicker(void)
 {
 	const UINT8 pid = 0; // TODO: should splitscreen players be allowed to use this too?
 
+	// Report screenshots the capture queue finished writing
+	g_capture.run_completions();
+
 	if (M_MenuButtonPressed(pid, MBT_SCREENSHOT))
 	{
 		M_ScreenShot();
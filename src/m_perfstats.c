@@ -231,6 +231,13 @@ static void M_DrawRenderStats(void)
 		{0}
 	};
 
+	perfstatrow_t twodee_row[] = {
+		{"2d cmds", "2D commands:", &ps_2d_numcmds},
+		{"2d drws", "2D batches: ", &ps_2d_numbatches},
+		{"2d sort", "2D reorders:", &ps_2d_numreordered},
+		{0}
+	};
+
 	perfstatrow_t batchcalls_row[] = {
 		{"drwcall", "Draw calls:", &ps_hw_numcalls},
 		{"shaders", "Shaders:   ", &ps_hw_numshaders},
@@ -256,6 +263,8 @@ static void M_DrawRenderStats(void)
 	perfstatcol_t     batchcount_col = {155, 200, V_PURPLEMAP,     batchcount_row};
 	perfstatcol_t     batchcalls_col = {220, 200, V_PURPLEMAP,     batchcalls_row};
 
+	perfstatcol_t         twodee_col = {155, 200, V_PURPLEMAP,         twodee_row};
+
 
 	boolean rendering = G_GamestateUsesLevel();
 
@@ -329,6 +338,13 @@ static void M_DrawRenderStats(void)
 		}
 #endif
 	}
+
+	if (rendermode == render_soft)
+	{
+		// Software frames reach the screen through the 2D batcher
+		draw_row = 10;
+		M_DrawPerfCount(&twodee_col);
+	}
 }
 
 static void M_DrawTickStats(void)
@@ -67,10 +67,22 @@ public:
 		uint32_t width, height;
 		int pts;
 
+		// Set by push_staging_video_frame
+		std::chrono::steady_clock::time_point queued;
+
 		StagingVideoFrame(uint32_t width_, uint32_t height_, int pts_) :
 			screen(width_ * height_ * 3), width(width_), height(height_), pts(pts_)
 		{
 		}
+
+		// Reuses the screen allocation if it is big enough.
+		void reset(uint32_t width_, uint32_t height_, int pts_)
+		{
+			screen.resize(width_ * height_ * 3);
+			width = width_;
+			height = height_;
+			pts = pts_;
+		}
 	};
 
 	// Returns the canonical file extension minus the dot.
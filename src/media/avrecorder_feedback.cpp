@@ -100,11 +100,11 @@ void AVRecorder::draw_statistics() const
 {
 	SRB2_ASSERT(impl_->video_encoder_ != nullptr);
 
-	auto draw = [](int x, std::string text, int32_t flags = 0)
+	auto draw = [](int x, int y, std::string text, int32_t flags = 0)
 	{
 		V_DrawThinString(
 			x,
-			190,
+			y,
 			(V_SNAPTOBOTTOM | V_SNAPTORIGHT) | flags,
 			text.c_str()
 		);
@@ -144,7 +144,30 @@ void AVRecorder::draw_statistics() const
 		return 0;
 	}();
 
-	draw(200, fmt::format("{:.0f}", fps), fps_color);
-	draw(230, fmt::format("{:.1f}s", impl_->container_->duration().count()));
-	draw(260, fmt::format("{:.1f} MB", size / kMb), mb_color);
+	const float wait_ms = impl_->video_wait_ms_avg_;
+	const float convert_ms = impl_->video_convert_ms_avg_;
+	const float encode_ms = impl_->video_encode_ms_avg_;
+
+	const int32_t encode_color = [&]
+	{
+		const float budget = 1000.f / impl_->video_encoder_->frame_rate();
+
+		// red when the worker spends longer than a frame on
+		// each frame, since the queue can only fall behind
+		if (convert_ms + encode_ms > budget)
+		{
+			return V_REDMAP;
+		}
+
+		return 0;
+	}();
+
+	draw(200, 190, fmt::format("{:.0f}", fps), fps_color);
+	draw(230, 190, fmt::format("{:.1f}s", impl_->container_->duration().count()));
+	draw(260, 190, fmt::format("{:.1f} MB", size / kMb), mb_color);
+
+	// Per-stage latency: queue wait, YUV conversion, encode
+	draw(200, 180, fmt::format("q {:.1f}", wait_ms), encode_color);
+	draw(230, 180, fmt::format("yuv {:.1f}", convert_ms), encode_color);
+	draw(260, 180, fmt::format("enc {:.1f}ms", encode_ms), encode_color);
 }
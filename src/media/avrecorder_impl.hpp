@@ -114,6 +114,19 @@ public:
 	// Average number of frames actually encoded per second.
 	std::atomic<float> video_frame_rate_avg_ = 0.f;
 
+	// Rolling averages, in milliseconds, of how long each
+	// video frame waited in the queue, took to convert to
+	// YUV and took to encode.
+	std::atomic<float> video_wait_ms_avg_ = 0.f;
+	std::atomic<float> video_convert_ms_avg_ = 0.f;
+	std::atomic<float> video_encode_ms_avg_ = 0.f;
+
+	// Staging frames that were already encoded, handed out
+	// again by new_staging_video_frame so their screen
+	// buffers aren't reallocated every frame. Guarded by
+	// queue_mutex_.
+	std::vector<StagingVideoFrame::instance_t> staging_pool_;
+
 	Impl(Config config);
 	~Impl();
 
@@ -147,12 +160,18 @@ private:
 
 	QueueState encode_queues();
 	void update_video_frame_rate_avg();
+	void update_video_latency_avg(
+		std::chrono::steady_clock::duration wait,
+		std::chrono::steady_clock::duration convert,
+		std::chrono::steady_clock::duration encode
+	);
 
 	void worker();
 
 	void container_dtor_handler(const MediaContainer& container) const;
 
 	VideoFrame::instance_t convert_staging_video_frame(const StagingVideoFrame& indexed);
+	void recycle_staging_video_frames(std::vector<StagingVideoFrame::instance_t> frames);
 };
 
 template <>
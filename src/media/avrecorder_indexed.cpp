@@ -10,10 +10,13 @@
 
 // TODO: remove this file once hwr2 twodee is finished
 
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "../cxxutil.hpp"
 #include "avrecorder_impl.hpp"
@@ -22,12 +25,29 @@ using namespace srb2::media;
 
 using Impl = AVRecorder::Impl;
 
+namespace
+{
+
+// Enough to cover a full queue (see advance_video_pts)
+// plus the frame being drawn.
+constexpr std::size_t kStagingPoolSize = 4;
+
+}; // namespace
+
 VideoFrame::instance_t Impl::convert_staging_video_frame(const StagingVideoFrame& staging)
 {
 	VideoFrame::instance_t frame = video_encoder_->new_frame(staging.width, staging.height, staging.pts);
 
 	SRB2_ASSERT(frame != nullptr);
 
+	// Let the encoder read the staging buffer directly if
+	// it can. The staging frame stays alive until after
+	// encoding (see encode_queues).
+	if (frame->borrow_rgb8(staging.screen, staging.width * 3))
+	{
+		return frame;
+	}
+
 	const VideoFrame::Buffer& buffer = frame->rgba_buffer();
 
 	const uint8_t* s = staging.screen.data();
@@ -51,6 +71,21 @@ VideoFrame::instance_t Impl::convert_staging_video_frame(const StagingVideoFrame
 	return frame;
 }
 
+void Impl::recycle_staging_video_frames(std::vector<StagingVideoFrame::instance_t> frames)
+{
+	auto _ = queue_guard();
+
+	for (auto& p : frames)
+	{
+		if (staging_pool_.size() >= kStagingPoolSize)
+		{
+			break;
+		}
+
+		staging_pool_.emplace_back(std::move(p));
+	}
+}
+
 AVRecorder::StagingVideoFrame::instance_t AVRecorder::new_staging_video_frame(uint32_t width, uint32_t height)
 {
 	std::optional<int> pts = impl_->advance_video_pts();
@@ -60,11 +95,29 @@ AVRecorder::StagingVideoFrame::instance_t AVRecorder::new_staging_video_frame(ui
 		return nullptr;
 	}
 
+	{
+		auto _ = impl_->queue_guard();
+
+		auto& pool = impl_->staging_pool_;
+
+		if (!pool.empty())
+		{
+			StagingVideoFrame::instance_t frame = std::move(pool.back());
+
+			pool.pop_back();
+			frame->reset(width, height, *pts);
+
+			return frame;
+		}
+	}
+
 	return std::make_unique<StagingVideoFrame>(width, height, *pts);
 }
 
 void AVRecorder::push_staging_video_frame(StagingVideoFrame::instance_t frame)
 {
+	frame->queued = std::chrono::steady_clock::now();
+
 	auto _ = impl_->queue_guard();
 
 	impl_->video_queue_.vec_.emplace_back(std::move(frame));
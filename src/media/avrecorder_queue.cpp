@@ -124,14 +124,25 @@ Impl::QueueState Impl::encode_queues()
 	auto encode_audio = [this](auto copy) { audio_encoder_->encode(copy); };
 	auto encode_video = [this](auto copy)
 	{
+		using clock = std::chrono::steady_clock;
+
 		for (auto& p : copy)
 		{
+			const auto t_convert = clock::now();
+
 			auto frame = convert_staging_video_frame(*p);
 
+			const auto t_encode = clock::now();
+
 			video_encoder_->encode(std::move(frame));
+
+			update_video_latency_avg(t_convert - p->queued, t_encode - t_convert, clock::now() - t_encode);
 		}
 
 		update_video_frame_rate_avg();
+
+		// The encoder is done reading these now.
+		recycle_staging_video_frames(std::move(copy));
 	};
 
 	check(audio_queue_, encode_audio);
@@ -166,5 +177,29 @@ void Impl::update_video_frame_rate_avg()
 	}
 }
 
+void Impl::update_video_latency_avg(
+	std::chrono::steady_clock::duration wait,
+	std::chrono::steady_clock::duration convert,
+	std::chrono::steady_clock::duration encode
+)
+{
+	// Weight of the newest frame. Low enough that the
+	// numbers don't flicker on screen.
+	constexpr float kWeight = 0.05f;
+
+	// Only the worker thread writes these.
+	auto blend = [](std::atomic<float>& avg, std::chrono::steady_clock::duration t)
+	{
+		const float ms = std::chrono::duration<float, std::milli>(t).count();
+		const float old = avg;
+
+		avg = old + (ms - old) * kWeight;
+	};
+
+	blend(video_wait_ms_avg_, wait);
+	blend(video_convert_ms_avg_, convert);
+	blend(video_encode_ms_avg_, encode);
+}
+
 template class Impl::Queue<AudioEncoder>;
 template class Impl::Queue<VideoEncoder>;
@@ -52,6 +52,13 @@ public:
 	// BufferMethod::kEncoderAllocatedRGBA8888.
 	virtual const Buffer& rgba_buffer() const = 0;
 
+	// Reads packed RGB8 pixels in place of rgba_buffer(),
+	// skipping the copy. The pixels must stay valid until
+	// the frame has been encoded. Returns false if this
+	// frame does not support it; rgba_buffer() must be
+	// filled instead.
+	virtual bool borrow_rgb8(tcb::span<const uint8_t>, std::size_t) { return false; }
+
 protected:
 	VideoFrame(int pts) : pts_(pts) {}
 
@@ -8,12 +8,14 @@
 // See the 'LICENSE' file for more details.
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
 
 #include <fmt/format.h>
 #include <tcb/span.hpp>
@@ -32,7 +34,7 @@ const vpx_codec_enc_cfg_t VP8Encoder::configure(const Config user)
 	vpx_codec_enc_cfg_t cfg;
 	vpx_codec_enc_config_default(kCodec, &cfg, 0);
 
-	cfg.g_threads = options_.get<int>("threads");
+	cfg.g_threads = threads();
 
 	cfg.g_w = user.width;
 	cfg.g_h = user.height;
@@ -68,6 +70,21 @@ const vpx_codec_enc_cfg_t VP8Encoder::configure(const Config user)
 	return cfg;
 }
 
+int VP8Encoder::threads()
+{
+	int n = options_.get<int>("threads");
+
+	if (n == static_cast<int>(ThreadsOption::kAuto))
+	{
+		// libvpx splits a VP8 frame by macroblock rows, which
+		// stops scaling well past 8 threads. Leave one core
+		// for the game.
+		n = std::clamp(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1, 8);
+	}
+
+	return n;
+}
+
 VP8Encoder::VP8Encoder(Config config) : ctx_(config), img_(config.width, config.height), frame_rate_(config.frame_rate)
 {
 	SRB2_ASSERT(config.buffer_method == VideoFrame::BufferMethod::kEncoderAllocatedRGBA8888);
@@ -75,7 +92,22 @@ VP8Encoder::VP8Encoder(Config config) : ctx_(config), img_(config.width, config.
 	control<int>(VP8E_SET_CPUUSED, "cpu_used");
 	control<int>(VP8E_SET_CQ_LEVEL, "cq_level");
 	control<int>(VP8E_SET_SHARPNESS, "sharpness");
-	control<int>(VP8E_SET_TOKEN_PARTITIONS, "token_parts");
+
+	int token_parts = options_.get<int>("token_parts");
+
+	if (token_parts == static_cast<int>(TokenPartitionsOption::kAuto))
+	{
+		// One partition per thread, so rows can be packed
+		// independently. The value is log2, up to 8 partitions.
+		token_parts = 0;
+
+		while (token_parts < 3 && (2 << token_parts) <= thread_count_)
+		{
+			token_parts++;
+		}
+	}
+
+	control<int>(VP8E_SET_TOKEN_PARTITIONS, "token_parts", token_parts);
 
 	auto plane = [this](int k, int ycs = 0)
 	{
@@ -159,6 +191,7 @@ void VP8Encoder::encode(VideoFrame::instance_t frame)
 	if (frame_->width() != width() || frame_->height() != height())
 	{
 		rgba_scaled_buffer_.resize(width(), height());
+		frame_->unpack_rgb8();
 		frame_->scale(rgba_scaled_buffer_);
 	}
 	else
@@ -226,8 +259,12 @@ bool VP8Encoder::process()
 template <typename T>
 void VP8Encoder::control(vp8e_enc_control_id id, const char* option)
 {
-	auto value = options_.get<T>(option);
+	control<T>(id, option, options_.get<T>(option));
+}
 
+template <typename T>
+void VP8Encoder::control(vp8e_enc_control_id id, const char* option, T value)
+{
 	if (vpx_codec_control_(ctx_, id, value) != VPX_CODEC_OK)
 	{
 		throw std::invalid_argument(fmt::format("vpx_codec_control: {}, {}={}", VpxError(ctx_), option, value));
@@ -80,15 +80,28 @@ private:
 	    kInfinite = 0,
 	};
 
+	enum class TokenPartitionsOption : int
+	{
+	    kAuto = -1,
+	};
+
+	enum class ThreadsOption : int
+	{
+	    kAuto = 0,
+	};
+
 	static vpx_codec_iface_t* kCodec;
 
 	static const vpx_codec_enc_cfg_t configure(const Config config);
 
+	// Resolves the "threads" option.
+	static int threads();
+
 	CtxWrapper ctx_;
 	ImgWrapper img_;
 
 	const int frame_rate_;
-	const int thread_count_ = options_.get<int>("threads");
+	const int thread_count_ = threads();
 	const int deadline_ = options_.get<int>("deadline");
 
 	mutable std::recursive_mutex frame_count_mutex_;
@@ -106,6 +119,9 @@ private:
 
 	template <typename T> // T = option type
 	void control(vp8e_enc_control_id id, const char* option);
+
+	template <typename T>
+	void control(vp8e_enc_control_id id, const char* option, T value);
 };
 
 }; // namespace srb2::media
@@ -13,6 +13,7 @@
 #include <memory>
 
 #include <libyuv/convert.h>
+#include <libyuv/convert_argb.h>
 #include <libyuv/scale_argb.h>
 #include <tcb/span.hpp>
 
@@ -80,8 +81,58 @@ const VideoFrame::Buffer& YUV420pFrame::rgba_buffer() const
 	return *rgba_;
 }
 
+bool YUV420pFrame::borrow_rgb8(tcb::span<const uint8_t> plane, std::size_t row_stride)
+{
+	SRB2_ASSERT(plane.size() >= row_stride * height());
+
+	rgb8_ = plane.data();
+	rgb8_stride_ = row_stride;
+
+	return true;
+}
+
+void YUV420pFrame::unpack_rgb8()
+{
+	if (rgb8_ == nullptr)
+	{
+		return;
+	}
+
+	// libyuv RGB24 is BGR in memory, so the bytes come out
+	// as RGBA, same as the copy rgba_buffer() would hold.
+	libyuv::RGB24ToARGB(
+		rgb8_,
+		rgb8_stride_,
+		rgba_->plane.data(),
+		rgba_->row_stride,
+		width(),
+		height()
+	);
+
+	rgb8_ = nullptr;
+}
+
 void YUV420pFrame::convert() const
 {
+	if (rgb8_ != nullptr)
+	{
+		// RAW = RGB in memory
+		libyuv::RAWToI420(
+			rgb8_,
+			rgb8_stride_,
+			y_.plane.data(),
+			y_.row_stride,
+			u_.plane.data(),
+			u_.row_stride,
+			v_.plane.data(),
+			v_.row_stride,
+			width(),
+			height()
+		);
+
+		return;
+	}
+
 	// ABGR = RGBA in memory
 	libyuv::ABGRToI420(
 		rgba_->plane.data(),
@@ -99,6 +150,8 @@ void YUV420pFrame::convert() const
 
 void YUV420pFrame::scale(const BufferRGBA& scaled_rgba)
 {
+	SRB2_ASSERT(rgb8_ == nullptr); // unpack_rgb8 first
+
 	int vw = scaled_rgba.width();
 	int vh = scaled_rgba.height();
 
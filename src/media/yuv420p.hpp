@@ -51,9 +51,15 @@ public:
 	// buffers intact.
 	void reset(int pts, const BufferRGBA& rgba) { *this = YUV420pFrame(pts, y_, u_, v_, rgba); }
 
-	// Converts RGBA buffer to YUV planes.
+	// Converts RGBA buffer (or borrowed RGB8 pixels) to YUV
+	// planes.
 	void convert() const;
 
+	// Expands borrowed RGB8 pixels into the RGBA buffer, so
+	// it may be scaled. Does nothing if nothing was
+	// borrowed.
+	void unpack_rgb8();
+
 	// Scales the existing buffer into a new one. This new
 	// buffer replaces the existing one.
 	void scale(const BufferRGBA& rgba);
@@ -63,9 +69,14 @@ public:
 
 	virtual const Buffer& rgba_buffer() const override;
 
+	virtual bool borrow_rgb8(tcb::span<const uint8_t> plane, std::size_t row_stride) override;
+
 private:
 	Buffer y_, u_, v_;
 	const BufferRGBA* rgba_;
+
+	const uint8_t* rgb8_ = nullptr;
+	std::size_t rgb8_stride_ = 0;
 };
 
 }; // namespace srb2::media
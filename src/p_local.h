@@ -484,6 +484,7 @@ fixed_t P_VeryBottomOfFOF (ffloor_t *rover);
 // P_SETUP
 //
 extern UINT8 *rejectmatrix; // for fast sight rejection
+extern size_t *sectorsightgroups; // sectors that may see each other share a group
 extern INT32 *blockmaplump; // offsets in blockmap are from here
 extern INT32 *blockmap; // Big blockmap
 extern INT32 bmapwidth;
@@ -0,0 +1,413 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_mapcache.cpp
+/// \brief Binary cache of parsed level data
+
+#include "p_mapcache.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#include <fmt/format.h>
+
+using namespace srb2;
+
+namespace
+{
+
+constexpr uint32_t kMapCacheMagic = 0x434D5252; // "RRMC"
+
+// Bump when the layout changes, when TEXTMAP_KEY_LIST changes, or when
+// P_CreateBlockMap would now build a different blockmap.
+constexpr uint32_t kMapCacheVersion = 3;
+
+constexpr uint32_t kFieldIsString = 0x80000000;
+
+class CacheReader
+{
+	const std::vector<std::byte>& data_;
+	size_t pos_ = 0;
+
+public:
+	explicit CacheReader(const std::vector<std::byte>& data) : data_(data) {}
+
+	void read(void* out, size_t size)
+	{
+		if (size > data_.size() - pos_)
+		{
+			throw std::runtime_error("map cache is truncated");
+		}
+
+		std::memcpy(out, data_.data() + pos_, size);
+		pos_ += size;
+	}
+
+	uint32_t u32()
+	{
+		uint8_t b[4];
+		read(b, sizeof b);
+		return b[0] | (b[1] << 8) | (b[2] << 16) | (static_cast<uint32_t>(b[3]) << 24);
+	}
+
+	int32_t i32() { return static_cast<int32_t>(u32()); }
+
+	// Refuses counts the rest of the file can't hold before allocating.
+	size_t count(size_t element_size)
+	{
+		uint32_t n = u32();
+		if (n > (data_.size() - pos_) / element_size)
+		{
+			throw std::runtime_error("map cache count is too large");
+		}
+		return n;
+	}
+};
+
+std::vector<std::byte> read_whole_file(const std::string& path)
+{
+	io::FileStream file {path, io::FileStreamMode::kRead};
+	std::vector<std::byte> data;
+	std::byte buffer[16384];
+
+	for (;;)
+	{
+		io::StreamSize got = file.read(tcb::make_span(buffer));
+		if (got == 0)
+		{
+			break;
+		}
+		data.insert(data.end(), buffer, buffer + got);
+	}
+
+	return data;
+}
+
+void write_u32(io::FileStream& file, uint32_t value)
+{
+	io::write(value, file);
+}
+
+// Same checks the game would need to walk a BLOCKMAP lump safely: every
+// block points at a list past the offset table, starting with the 0 header
+// word and ending in -1 before the end of the lump, and naming only lines
+// that exist.
+bool valid_blockmap(const MapCache& cache)
+{
+	const std::vector<int32_t>& bmap = cache.blockmap;
+
+	if (cache.bmapwidth <= 0 || cache.bmapheight <= 0 || bmap.size() < 4)
+	{
+		return false;
+	}
+
+	const size_t blocks = static_cast<size_t>(cache.bmapwidth) * static_cast<size_t>(cache.bmapheight);
+	if (blocks > bmap.size() - 4)
+	{
+		return false;
+	}
+
+	for (size_t i = 4; i < 4 + blocks; i++)
+	{
+		const int32_t offset = bmap[i];
+		if (offset < 0 || static_cast<size_t>(offset) < 4 + blocks || static_cast<size_t>(offset) >= bmap.size())
+		{
+			return false;
+		}
+
+		size_t j = static_cast<size_t>(offset);
+		if (bmap[j++] != 0)
+		{
+			return false;
+		}
+
+		for (;;)
+		{
+			if (j >= bmap.size())
+			{
+				return false;
+			}
+
+			const int32_t line = bmap[j++];
+			if (line == -1)
+			{
+				break;
+			}
+			if (line < 0 || static_cast<uint32_t>(line) >= cache.blockmap_lines)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// The number after a numbered key's prefix, as the parsers used to atol it.
+uint32_t key_index(const char* digits)
+{
+	long n = std::atol(digits);
+	if (n < 0 || static_cast<unsigned long>(n) >= UINT32_MAX)
+	{
+		return UINT32_MAX;
+	}
+	return static_cast<uint32_t>(n);
+}
+
+} // namespace
+
+TextmapParam srb2::resolve_textmap_param(const char* name)
+{
+	static const std::unordered_map<std::string_view, TextmapKey> names = {
+#define X(key) {#key, TextmapKey::key},
+		TEXTMAP_KEY_LIST(X)
+#undef X
+	};
+
+	// None of the numbered prefixes is a prefix of another, nor of a plain key.
+	static const struct
+	{
+		std::string_view prefix;
+		TextmapKey key;
+	} numbered[] = {
+		{"arg", TextmapKey::arg},
+		{"stringarg", TextmapKey::stringarg},
+		{"thingarg", TextmapKey::thingarg},
+		{"thingstringarg", TextmapKey::thingstringarg},
+	};
+
+	const std::string_view view {name};
+
+	if (auto it = names.find(view); it != names.end())
+	{
+		return {it->second, 0};
+	}
+
+	for (const auto& [prefix, key] : numbered)
+	{
+		if (view.size() > prefix.size() && view.compare(0, prefix.size(), prefix) == 0)
+		{
+			return {key, key_index(name + prefix.size())};
+		}
+	}
+
+	return {TextmapKey::other, 0};
+}
+
+uint32_t MapCache::add_key(const char* key)
+{
+	auto [it, inserted] = key_index_.try_emplace(key, static_cast<uint32_t>(keys.size()));
+	if (inserted)
+	{
+		keys.emplace_back(key);
+		params.push_back(resolve_textmap_param(key));
+	}
+	return it->second;
+}
+
+uint32_t MapCache::add_string(const char* str)
+{
+	uint32_t offset = static_cast<uint32_t>(strings.size());
+	strings.insert(strings.end(), str, str + std::strlen(str) + 1);
+	return offset;
+}
+
+std::string srb2::map_cache_path(const std::string& directory, const std::array<uint8_t, 16>& md5)
+{
+	std::string name;
+	for (uint8_t c : md5)
+	{
+		name += fmt::format("{:02x}", c);
+	}
+	return fmt::format("{}/{}.rmc", directory, name);
+}
+
+std::optional<MapCache> srb2::read_map_cache(const std::string& path, const std::array<uint8_t, 16>& md5)
+{
+	try
+	{
+		std::vector<std::byte> data = read_whole_file(path);
+		CacheReader in {data};
+		MapCache cache;
+
+		if (in.u32() != kMapCacheMagic || in.u32() != kMapCacheVersion)
+		{
+			return std::nullopt;
+		}
+
+		in.read(cache.md5.data(), cache.md5.size());
+		if (cache.md5 != md5)
+		{
+			return std::nullopt;
+		}
+
+		cache.has_textmap = in.u32() != 0;
+		if (cache.has_textmap)
+		{
+			size_t blocks = 0;
+
+			cache.udmf_version = in.i32();
+			for (uint32_t& count : cache.counts)
+			{
+				count = in.u32();
+				blocks += count;
+			}
+
+			cache.block_fields.resize(in.count(4));
+			for (uint32_t& index : cache.block_fields)
+			{
+				index = in.u32();
+			}
+
+			cache.fields.resize(in.count(8));
+			for (TextmapField& field : cache.fields)
+			{
+				uint32_t value = in.u32();
+				field.param = in.u32();
+				field.value = value & ~kFieldIsString;
+				field.is_string = (value & kFieldIsString) != 0;
+			}
+
+			cache.keys.resize(in.count(12));
+			cache.params.resize(cache.keys.size());
+			for (size_t i = 0; i < cache.keys.size(); i++)
+			{
+				std::string& key = cache.keys[i];
+				key.resize(in.count(1));
+				in.read(key.data(), key.size());
+
+				uint32_t id = in.u32();
+				if (id >= static_cast<uint32_t>(TextmapKey::count))
+				{
+					return std::nullopt;
+				}
+				cache.params[i].key = static_cast<TextmapKey>(id);
+				cache.params[i].index = in.u32();
+			}
+
+			cache.strings.resize(in.count(1));
+			in.read(cache.strings.data(), cache.strings.size());
+
+			// Everything the loader will index has to be in range.
+			if (cache.block_fields.size() != blocks + 1 || cache.block_fields.front() != 0 ||
+				cache.block_fields.back() != cache.fields.size() || cache.strings.empty() ||
+				cache.strings.back() != '\0')
+			{
+				return std::nullopt;
+			}
+
+			for (size_t i = 1; i < cache.block_fields.size(); i++)
+			{
+				if (cache.block_fields[i] < cache.block_fields[i - 1])
+				{
+					return std::nullopt;
+				}
+			}
+
+			for (const TextmapField& field : cache.fields)
+			{
+				if (field.param >= cache.keys.size() || field.value >= cache.strings.size())
+				{
+					return std::nullopt;
+				}
+			}
+		}
+
+		cache.has_blockmap = in.u32() != 0;
+		if (cache.has_blockmap)
+		{
+			cache.blockmap_vertexes = in.u32();
+			cache.blockmap_lines = in.u32();
+			cache.bmaporgx = in.i32();
+			cache.bmaporgy = in.i32();
+			cache.bmapwidth = in.i32();
+			cache.bmapheight = in.i32();
+
+			cache.blockmap.resize(in.count(4));
+			for (int32_t& word : cache.blockmap)
+			{
+				word = in.i32();
+			}
+
+			// The loader trusts the offsets in here as much as its own.
+			if (!valid_blockmap(cache))
+			{
+				return std::nullopt;
+			}
+		}
+
+		return cache;
+	}
+	catch (...)
+	{
+		// Missing or unreadable; the map just gets parsed.
+		return std::nullopt;
+	}
+}
+
+void srb2::write_map_cache(io::FileStream& file, const MapCache& cache)
+{
+	write_u32(file, kMapCacheMagic);
+	write_u32(file, kMapCacheVersion);
+	io::write_exact(file, tcb::as_bytes(tcb::make_span(cache.md5)));
+
+	write_u32(file, cache.has_textmap);
+	if (cache.has_textmap)
+	{
+		write_u32(file, static_cast<uint32_t>(cache.udmf_version));
+		for (uint32_t count : cache.counts)
+		{
+			write_u32(file, count);
+		}
+
+		write_u32(file, static_cast<uint32_t>(cache.block_fields.size()));
+		for (uint32_t index : cache.block_fields)
+		{
+			write_u32(file, index);
+		}
+
+		write_u32(file, static_cast<uint32_t>(cache.fields.size()));
+		for (const TextmapField& field : cache.fields)
+		{
+			write_u32(file, field.value | (field.is_string ? kFieldIsString : 0));
+			write_u32(file, field.param);
+		}
+
+		write_u32(file, static_cast<uint32_t>(cache.keys.size()));
+		for (size_t i = 0; i < cache.keys.size(); i++)
+		{
+			const std::string& key = cache.keys[i];
+			write_u32(file, static_cast<uint32_t>(key.size()));
+			io::write_exact(file, tcb::as_bytes(tcb::span<const char>(key.data(), key.size())));
+			write_u32(file, static_cast<uint32_t>(cache.params[i].key));
+			write_u32(file, cache.params[i].index);
+		}
+
+		write_u32(file, static_cast<uint32_t>(cache.strings.size()));
+		io::write_exact(file, tcb::as_bytes(tcb::make_span(cache.strings)));
+	}
+
+	write_u32(file, cache.has_blockmap);
+	if (cache.has_blockmap)
+	{
+		write_u32(file, cache.blockmap_vertexes);
+		write_u32(file, cache.blockmap_lines);
+		write_u32(file, static_cast<uint32_t>(cache.bmaporgx));
+		write_u32(file, static_cast<uint32_t>(cache.bmaporgy));
+		write_u32(file, static_cast<uint32_t>(cache.bmapwidth));
+		write_u32(file, static_cast<uint32_t>(cache.bmapheight));
+
+		write_u32(file, static_cast<uint32_t>(cache.blockmap.size()));
+		for (int32_t word : cache.blockmap)
+		{
+			write_u32(file, static_cast<uint32_t>(word));
+		}
+	}
+}
@@ -0,0 +1,138 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_mapcache.hpp
+/// \brief Binary cache of parsed level data
+
+#ifndef __P_MAPCACHE_HPP__
+#define __P_MAPCACHE_HPP__
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "io/streams.hpp"
+
+namespace srb2
+{
+
+// What P_LoadMapFromFile works out from a map's lumps that doesn't depend
+// on anything else loaded, saved per MD5 of all of those lumps (not just
+// the ones that go into the map's own MD5) so loading the same map again
+// can skip that work. TEXTMAP is kept as the fields of each block rather
+// than the finished structures, since parsing them also registers flats,
+// colormaps and slopes; those are redone from the fields.
+
+// Every TEXTMAP field name the P_LoadTextmap parsers act on. Caches store
+// the resolved keys as numbers, so bump kMapCacheVersion in p_mapcache.cpp
+// whenever this list changes.
+#define TEXTMAP_KEY_LIST(X) \
+	X(x) X(y) X(zfloor) X(zceiling) \
+	X(heightfloor) X(heightceiling) X(texturefloor) X(textureceiling) \
+	X(lightlevel) X(lightfloor) X(lightfloorabsolute) X(lightceiling) X(lightceilingabsolute) \
+	X(id) X(moreids) \
+	X(xpanningfloor) X(ypanningfloor) X(xpanningceiling) X(ypanningceiling) \
+	X(rotationfloor) X(rotationceiling) \
+	X(floorplane_a) X(floorplane_b) X(floorplane_c) X(floorplane_d) \
+	X(ceilingplane_a) X(ceilingplane_b) X(ceilingplane_c) X(ceilingplane_d) \
+	X(lightcolor) X(lightalpha) X(fadecolor) X(fadealpha) X(fadestart) X(fadeend) \
+	X(colormapfog) X(colormapfadesprites) X(colormapprotected) \
+	X(flipspecial_nofloor) X(flipspecial_ceiling) X(triggerspecial_touch) X(triggerspecial_headbump) \
+	X(invertprecip) X(gravityflip) X(heatwave) X(noclipcamera) X(ripple_floor) X(ripple_ceiling) \
+	X(invertencore) X(flatlighting) X(forcedirectionallighting) \
+	X(nostepup) X(doublestepup) X(nostepdown) X(cheatcheckactivator) X(starpostactivator) \
+	X(exit) X(deleteitems) X(fan) X(zoomtubestart) X(zoomtubeend) \
+	X(friction) X(gravity) X(damagetype) X(action) \
+	X(repeatspecial) X(continuousspecial) \
+	X(playerenter) X(playerfloor) X(playerceiling) \
+	X(monsterenter) X(monsterfloor) X(monsterceiling) \
+	X(missileenter) X(missilefloor) X(missileceiling) \
+	X(offsetx) X(offsety) X(texturetop) X(texturebottom) X(texturemiddle) X(sector) X(repeatcnt) \
+	X(special) X(v1) X(v2) X(sidefront) X(sideback) X(alpha) X(blendmode) X(renderstyle) \
+	X(blocking) X(blockplayers) X(twosided) X(dontpegtop) X(dontpegbottom) X(skewtd) \
+	X(noclimb) X(noskew) X(midpeg) X(midsolid) X(wrapmidtex) X(blockmonsters) \
+	X(nonet) X(netonly) X(notbouncy) X(transfer) \
+	X(playercross) X(monstercross) X(missilecross) X(playerpush) X(monsterpush) X(impact) \
+	X(height) X(angle) X(pitch) X(roll) X(type) X(scale) X(scalex) X(scaley) X(mobjscale) \
+	X(flip) X(foflayer)
+
+enum class TextmapKey : uint32_t
+{
+	other, // user_ properties and anything the parsers ignore
+#define X(name) name,
+	TEXTMAP_KEY_LIST(X)
+#undef X
+	arg, // argN
+	stringarg, // stringargN
+	thingarg, // thingargN
+	thingstringarg, // thingstringargN
+	count
+};
+
+struct TextmapParam
+{
+	TextmapKey key;
+	uint32_t index; // N of the numbered keys, UINT32_MAX if out of range
+};
+
+/// @brief What a TEXTMAP field name means to the parsers.
+TextmapParam resolve_textmap_param(const char* name);
+
+struct TextmapField
+{
+	uint32_t param; // index into MapCache::keys and MapCache::params
+	uint32_t value; // offset into MapCache::strings
+	bool is_string; // value was quoted
+};
+
+struct MapCache
+{
+	std::array<uint8_t, 16> md5 {};
+
+	bool has_textmap = false;
+	int32_t udmf_version = 0;
+	std::array<uint32_t, 5> counts {}; // vertexes, sectors, linedefs, sidedefs, things
+
+	// Blocks in the order P_LoadTextmap parses them. Block i has the fields
+	// from block_fields[i] up to block_fields[i + 1].
+	std::vector<uint32_t> block_fields;
+	std::vector<TextmapField> fields;
+	std::vector<std::string> keys; // each field name once
+	std::vector<TextmapParam> params; // keys, resolved
+	std::vector<char> strings; // NUL-terminated values
+
+	// Only maps without a BLOCKMAP lump have one generated.
+	bool has_blockmap = false;
+	uint32_t blockmap_vertexes = 0; // to tell whether the nodes changed
+	uint32_t blockmap_lines = 0;
+	int32_t bmaporgx = 0;
+	int32_t bmaporgy = 0;
+	int32_t bmapwidth = 0;
+	int32_t bmapheight = 0;
+	std::vector<int32_t> blockmap; // the whole lump, header words included
+
+	uint32_t add_key(const char* key);
+	uint32_t add_string(const char* str);
+
+private:
+	std::unordered_map<std::string, uint32_t> key_index_; // only while recording
+};
+
+std::string map_cache_path(const std::string& directory, const std::array<uint8_t, 16>& md5);
+
+/// @brief The cache for a map, if there is a valid one.
+std::optional<MapCache> read_map_cache(const std::string& path, const std::array<uint8_t, 16>& md5);
+
+void write_map_cache(io::FileStream& file, const MapCache& cache);
+
+} // namespace srb2
+
+#endif // __P_MAPCACHE_HPP__
@@ -49,6 +49,7 @@
 #include "k_vote.h"
 #include "k_zvote.h"
 #include "k_endcam.h"
+#include "core/thread_pool.h"
 
 #include <tracy/tracy/TracyC.h>
 
@@ -1680,11 +1681,17 @@ static UINT32 num_ffloors = 0; // for loading
 
 // Copypasta from r_data.c AddColormapToList
 // But also check for equality and return the matching index
+// Set while sections are being archived on other threads. Every colormap is
+// in the list by then, so lookups must not append to it.
+static boolean net_colormaps_frozen = false;
+
 static UINT32 CheckAddNetColormapToList(extracolormap_t *extra_colormap)
 {
 	extracolormap_t *exc, *exc_prev = NULL;
 	UINT32 i = 0;
 
+	I_Assert(!net_colormaps_frozen || net_colormaps != NULL);
+
 	if (!net_colormaps)
 	{
 		net_colormaps = R_CopyColormap(extra_colormap, false);
@@ -1701,6 +1708,8 @@ static UINT32 CheckAddNetColormapToList(extracolormap_t *extra_colormap)
 		i++;
 	}
 
+	I_Assert(!net_colormaps_frozen);
+
 	exc_prev->next = R_CopyColormap(extra_colormap, false);
 	extra_colormap->prev = exc_prev;
 	extra_colormap->next = 0;
@@ -2715,8 +2724,7 @@ static void P_NetArchiveWorld(savebuffer_t *save)
 {
 	TracyCZone(__zone, true);
 
-	// initialize colormap vars because paranoia
-	ClearNetColormaps();
+	// net_colormaps was set up by P_RegisterNetColormaps
 
 	WRITEUINT32(save->p, ARCHIVEBLOCK_WORLD);
 
@@ -4336,6 +4344,68 @@ static void P_NetUnArchiveTubeWaypoints(savebuffer_t *save)
 	TracyCZoneEnd(__zone);
 }
 
+// mobjnum -> mobj, filled in once all thinkers have been loaded so relinking
+// doesn't have to walk the mobj list for every pointer. mobjnums are handed
+// out densely from 1 when archiving, so a flat array does. Only valid while
+// loading a net game; mobjtablesize is 0 the rest of the time.
+static mobj_t **mobjtable = NULL;
+static UINT32 mobjtablesize = 0;
+static UINT32 mobjtablecapacity = 0;
+
+static void P_BuildMobjTable(void)
+{
+	thinker_t *th;
+	mobj_t *mobj;
+	UINT32 count = 0;
+	UINT32 size;
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
+			continue;
+
+		count++;
+	}
+
+	// The save's own mobjnums can't go past how many mobjs it held, so
+	// anything larger is bad data and is left out rather than sizing the
+	// table from it.
+	size = count + 1;
+
+	if (size > mobjtablecapacity)
+	{
+		mobjtable = Z_Realloc(mobjtable, size * sizeof (*mobjtable), PU_STATIC, NULL);
+		mobjtablecapacity = size;
+	}
+	memset(mobjtable, 0, size * sizeof (*mobjtable));
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
+			continue;
+
+		// Keep the first match, same as the list search would
+		mobj = (mobj_t *)th;
+		if (mobj->mobjnum >= size)
+		{
+			CONS_Debug(DBG_GAMELOGIC, "mobj %u out of range (%u read)\n", mobj->mobjnum, count);
+			continue;
+		}
+		if (mobjtable[mobj->mobjnum] == NULL)
+			mobjtable[mobj->mobjnum] = mobj;
+	}
+
+	// 0 means no mobj
+	mobjtable[0] = NULL;
+
+	mobjtablesize = size;
+}
+
+static void P_ClearMobjTable(void)
+{
+	mobjtablesize = 0;
+}
+
 // Now save the pointers, tracer and target, but at load time we must
 // relink to this; the savegame contains the old position in the pointer
 // field copyed in the info field temporarily, but finally we just search
@@ -4345,6 +4415,18 @@ mobj_t *P_FindNewPosition(UINT32 oldposition)
 	thinker_t *th;
 	mobj_t *mobj;
 
+	if (mobjtablesize)
+	{
+		mobj = oldposition < mobjtablesize ? mobjtable[oldposition] : NULL;
+
+		// Mobjs removed since the table was built are still in it
+		if (mobj && mobj->thinker.function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
+			return mobj;
+
+		CONS_Debug(DBG_GAMELOGIC, "mobj %d not found\n", oldposition);
+		return NULL;
+	}
+
 	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 	{
 		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
@@ -5660,6 +5742,8 @@ static void P_NetUnArchiveThinkers(savebuffer_t *save)
 		CONS_Debug(DBG_NETPLAY, "%u thinkers loaded in list %d\n", numloaded, i);
 	}
 
+	P_BuildMobjTable();
+
 	if (restoreNum)
 	{
 		executor_t *delay = NULL;
@@ -6977,6 +7061,45 @@ void P_SaveGame(savebuffer_t *save)
 	P_ArchiveLuabanksAndConsistency(save);
 }
 
+// Fills net_colormaps with every colormap the World and Thinkers blocks will
+// reference, in the order they would have added them, so both blocks can be
+// archived at the same time without touching the list.
+static void P_RegisterNetColormaps(void)
+{
+	const thinker_t *th;
+	size_t i;
+
+	// initialize colormap vars because paranoia
+	ClearNetColormaps();
+
+	for (i = 0; i < numsectors; i++)
+	{
+		if (sectors[i].extra_colormap != spawnsectors[i].extra_colormap)
+			CheckAddNetColormapToList(sectors[i].extra_colormap);
+	}
+
+	for (i = 0; i < NUM_THINKERLISTS; i++)
+	{
+		for (th = thlist[i].next; th != &thlist[i]; th = th->next)
+		{
+			if (th->function.acp1 == (actionf_p1)T_Fade)
+			{
+				CheckAddNetColormapToList(((const fade_t *)th)->dest_exc);
+			}
+			else if (th->function.acp1 == (actionf_p1)T_FadeColormap)
+			{
+				CheckAddNetColormapToList(((const fadecolormap_t *)th)->source_exc);
+				CheckAddNetColormapToList(((const fadecolormap_t *)th)->dest_exc);
+			}
+		}
+	}
+}
+
+static void P_NetArchiveThinkersTask(void *save)
+{
+	P_NetArchiveThinkers((savebuffer_t *)save);
+}
+
 void P_SaveNetGame(savebuffer_t *save, boolean resending)
 {
 	TracyCZone(__zone, true);
@@ -7015,9 +7138,36 @@ void P_SaveNetGame(savebuffer_t *save, boolean resending)
 
 	if (gamestate == GS_LEVEL)
 	{
+		savebuffer_t thinkers = {0};
+		srb2ctask_t *task;
+		size_t length;
+
+		// World and Thinkers are by far the largest blocks. Archive the
+		// thinkers on the thread pool into a buffer of their own while
+		// this thread does the world, then splice them in.
+		if (P_SaveBufferAlloc(&thinkers, NETSAVEGAMESIZE) == false)
+			I_Error("No more free memory for savegame");
+
+		P_RegisterNetColormaps();
+		net_colormaps_frozen = true;
+
+		current_savebuffer = &thinkers; // WriteMobjPointer
+		task = I_ThreadPoolSubmitTask(P_NetArchiveThinkersTask, &thinkers);
+
 		P_NetArchiveWorld(save);
 		P_ArchivePolyObjects(save);
-		P_NetArchiveThinkers(save);
+
+		// Only returns once the task has finished, even if a worker has it.
+		I_ThreadPoolWaitTask(task);
+		current_savebuffer = save;
+		net_colormaps_frozen = false;
+
+		length = thinkers.p - thinkers.buffer;
+		if (length > NETSAVEGAMESIZE || (size_t)(save->end - save->p) < length)
+			I_Error("Savegame buffer overrun");
+		WRITEMEM(save->p, thinkers.buffer, length);
+		P_SaveBufferFree(&thinkers);
+
 		P_NetArchiveSpecials(save);
 		P_NetArchiveColormaps(save);
 		P_NetArchiveTubeWaypoints(save);
@@ -7096,6 +7246,9 @@ boolean P_LoadNetGame(savebuffer_t *save, boolean reloading)
 	ACS_UnArchive(save);
 	LUA_UnArchive(save, true);
 
+	// Every saved mobj pointer has been resolved by now
+	P_ClearMobjTable();
+
 	P_NetUnArchiveRNG(save);
 
 	// The precipitation would normally be spawned in P_SetupLevel, which is called by
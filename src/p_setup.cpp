@@ -13,12 +13,20 @@
 /// \brief Do all the WAD I/O, get map description, set up initial state and misc. LUTs
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <optional>
 #include <string>
+#include <system_error>
 #include <vector>
 
 #include <fmt/format.h>
 
 #include "cxxutil.hpp"
+#include "io/save_queue.hpp"
+#include "p_mapcache.hpp"
 
 #include "doomdef.h"
 #include "d_main.h"
@@ -194,6 +202,17 @@ precipmobj_t **precipblocklinks;
 //
 UINT8 *rejectmatrix;
 
+// Sectors in different groups have no path of two-sided lines between
+// them, so sight can never pass from one to the other. Built on load,
+// since most maps ship without a useful REJECT.
+size_t *sectorsightgroups;
+
+// GL nodes only: the seg on the other side of each seg (UINT32_MAX if
+// none) and the subsector each seg was read into. Kept until the sight
+// groups are built, since minisegs have no line to join sectors across.
+static UINT32 *segpartners;
+static UINT32 *segsubsectors;
+
 // Maintain single and multi player starting spots.
 INT32 numdmstarts, numcoopstarts, numredctfstarts, numbluectfstarts;
 INT32 numfaultstarts;
@@ -1438,6 +1457,97 @@ UINT32 sidesPos[UINT16_MAX];
 UINT32 vertexesPos[UINT16_MAX];
 UINT32 sectorsPos[UINT16_MAX];
 
+// -mapcache: the cache for the map being loaded. If it was read from disk,
+// TEXTMAP is replayed from it instead of tokenized; otherwise it's filled
+// in as the map loads and saved afterwards.
+static std::optional<srb2::MapCache> mapcache;
+static boolean mapcachehit;
+static size_t textmapblock; // next block to replay
+
+using srb2::TextmapKey;
+
+// M_TokenizerJustReadString, for either source of fields.
+static boolean textmapValIsString;
+
+static std::string P_MapCachePath(const std::array<uint8_t, 16> &key)
+{
+	return srb2::map_cache_path(fmt::format("{}" PATHSEP "mapcache", srb2home), key);
+}
+
+// mapmd5 leaves out VERTEXES and the node lumps, which the generated
+// blockmap and the loaded geometry depend on, so the cache is keyed on
+// every lump of the map instead.
+static boolean P_MakeMapCacheKey(const virtres_t *virt, std::array<uint8_t, 16> &key)
+{
+#ifdef NOMD5
+	(void)virt;
+	(void)key;
+	return false;
+#else
+	// Only md5_buffer is built, so hash each lump and then the list of them.
+	std::vector<UINT8> digests;
+	size_t i;
+
+	for (i = 0; i < virt->numlumps; i++)
+	{
+		const virtlump_t *lump = &virt->vlumps[i];
+		const UINT32 size = static_cast<UINT32>(lump->size);
+		UINT8 lumpmd5[16];
+
+		md5_buffer(reinterpret_cast<const char*>(lump->data), lump->size, lumpmd5);
+		digests.insert(digests.end(), lump->name, lump->name + strlen(lump->name) + 1);
+		digests.insert(digests.end(), reinterpret_cast<const UINT8*>(&size), reinterpret_cast<const UINT8*>(&size) + sizeof size);
+		digests.insert(digests.end(), lumpmd5, lumpmd5 + sizeof lumpmd5);
+	}
+
+	md5_buffer(reinterpret_cast<const char*>(digests.data()), digests.size(), key.data());
+	return true;
+#endif
+}
+
+static void P_OpenMapCache(const virtres_t *virt)
+{
+	std::array<uint8_t, 16> key;
+
+	mapcache.reset();
+	mapcachehit = false;
+
+	if (!M_CheckParm("-mapcache") || !P_MakeMapCacheKey(virt, key))
+		return;
+
+	mapcache = srb2::read_map_cache(P_MapCachePath(key), key);
+
+	if (mapcache)
+	{
+		mapcachehit = true;
+		return;
+	}
+
+	mapcache.emplace();
+	mapcache->md5 = key;
+}
+
+static void P_CloseMapCache(boolean loaded)
+{
+	if (loaded && mapcache && !mapcachehit && (mapcache->has_textmap || mapcache->has_blockmap))
+	{
+		auto cache = std::make_shared<srb2::MapCache>(std::move(*mapcache));
+		srb2::io::SaveRequest request;
+		std::error_code ec;
+
+		std::filesystem::create_directories(fmt::format("{}" PATHSEP "mapcache", srb2home), ec);
+
+		request.path = P_MapCachePath(cache->md5);
+		request.write = [cache](srb2::io::FileStream& file) { srb2::write_map_cache(file, *cache); };
+		request.on_failure = [](const char *what) { CONS_Alert(CONS_WARNING, "Couldn't save map cache: %s\n", what); };
+
+		srb2::io::queue_save(std::move(request));
+	}
+
+	mapcache.reset();
+	mapcachehit = false;
+}
+
 // Determine total amount of map data in TEXTMAP.
 static boolean TextmapCount(size_t size)
 {
@@ -1519,7 +1629,7 @@ static void ParseUserProperty(mapUserProperties_t *user, const char *param, cons
 {
 	if (fastncmp(param, "user_", 5) && strlen(param) > 5)
 	{
-		const boolean valIsString = M_TokenizerJustReadString();
+		const boolean valIsString = textmapValIsString;
 		const char *key = param + 5;
 		const size_t valLen = strlen(val);
 		UINT8 numberType = PROP_NUM_TYPE_INT;
@@ -1584,21 +1694,28 @@ static void ParseUserProperty(mapUserProperties_t *user, const char *param, cons
 	}
 }
 
-static void ParseTextmapVertexParameter(UINT32 i, const char *param, const char *val)
+static void ParseTextmapVertexParameter(UINT32 i, srb2::TextmapParam key, const char *param, const char *val)
 {
-	if (fastcmp(param, "x"))
-		vertexes[i].x = FLOAT_TO_FIXED(atof(val));
-	else if (fastcmp(param, "y"))
-		vertexes[i].y = FLOAT_TO_FIXED(atof(val));
-	else if (fastcmp(param, "zfloor"))
-	{
-		vertexes[i].floorz = FLOAT_TO_FIXED(atof(val));
-		vertexes[i].floorzset = true;
-	}
-	else if (fastcmp(param, "zceiling"))
+	(void)param;
+
+	switch (key.key)
 	{
-		vertexes[i].ceilingz = FLOAT_TO_FIXED(atof(val));
-		vertexes[i].ceilingzset = true;
+		case TextmapKey::x:
+			vertexes[i].x = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::y:
+			vertexes[i].y = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::zfloor:
+			vertexes[i].floorz = FLOAT_TO_FIXED(atof(val));
+			vertexes[i].floorzset = true;
+			break;
+		case TextmapKey::zceiling:
+			vertexes[i].ceilingz = FLOAT_TO_FIXED(atof(val));
+			vertexes[i].ceilingzset = true;
+			break;
+		default:
+			break;
 	}
 }
 
@@ -1631,502 +1748,673 @@ typedef struct textmap_plane_s {
 textmap_plane_t textmap_planefloor = {0, 0, 0, 0, 0};
 textmap_plane_t textmap_planeceiling = {0, 0, 0, 0, 0};
 
-static void ParseTextmapSectorParameter(UINT32 i, const char *param, const char *val)
+static void ParseTextmapSectorParameter(UINT32 i, srb2::TextmapParam key, const char *param, const char *val)
 {
-	if (fastcmp(param, "heightfloor"))
-		sectors[i].floorheight = atol(val) << FRACBITS;
-	else if (fastcmp(param, "heightceiling"))
-		sectors[i].ceilingheight = atol(val) << FRACBITS;
-	if (fastcmp(param, "texturefloor"))
-		sectors[i].floorpic = P_AddLevelFlat(val, foundflats);
-	else if (fastcmp(param, "textureceiling"))
-		sectors[i].ceilingpic = P_AddLevelFlat(val, foundflats);
-	else if (fastcmp(param, "lightlevel"))
-		sectors[i].lightlevel = atol(val);
-	else if (fastcmp(param, "lightfloor"))
-		sectors[i].floorlightlevel = atol(val);
-	else if (fastcmp(param, "lightfloorabsolute") && fastcmp("true", val))
-		sectors[i].floorlightabsolute = true;
-	else if (fastcmp(param, "lightceiling"))
-		sectors[i].ceilinglightlevel = atol(val);
-	else if (fastcmp(param, "lightceilingabsolute") && fastcmp("true", val))
-		sectors[i].ceilinglightabsolute = true;
-	else if (fastcmp(param, "id"))
-		Tag_FSet(&sectors[i].tags, atol(val));
-	else if (fastcmp(param, "moreids"))
+	switch (key.key)
 	{
-		const char* id = val;
-		while (id)
+		case TextmapKey::heightfloor:
+			sectors[i].floorheight = atol(val) << FRACBITS;
+			break;
+		case TextmapKey::heightceiling:
+			sectors[i].ceilingheight = atol(val) << FRACBITS;
+			break;
+		case TextmapKey::texturefloor:
+			sectors[i].floorpic = P_AddLevelFlat(val, foundflats);
+			break;
+		case TextmapKey::textureceiling:
+			sectors[i].ceilingpic = P_AddLevelFlat(val, foundflats);
+			break;
+		case TextmapKey::lightlevel:
+			sectors[i].lightlevel = atol(val);
+			break;
+		case TextmapKey::lightfloor:
+			sectors[i].floorlightlevel = atol(val);
+			break;
+		case TextmapKey::lightfloorabsolute:
+			if (fastcmp("true", val))
+				sectors[i].floorlightabsolute = true;
+			break;
+		case TextmapKey::lightceiling:
+			sectors[i].ceilinglightlevel = atol(val);
+			break;
+		case TextmapKey::lightceilingabsolute:
+			if (fastcmp("true", val))
+				sectors[i].ceilinglightabsolute = true;
+			break;
+		case TextmapKey::id:
+			Tag_FSet(&sectors[i].tags, atol(val));
+			break;
+		case TextmapKey::moreids:
 		{
-			Tag_Add(&sectors[i].tags, atol(id));
-			if ((id = strchr(id, ' ')))
-				id++;
+			const char* id = val;
+			while (id)
+			{
+				Tag_Add(&sectors[i].tags, atol(id));
+				if ((id = strchr(id, ' ')))
+					id++;
+			}
+			break;
 		}
+		case TextmapKey::xpanningfloor:
+			sectors[i].floor_xoffs = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::ypanningfloor:
+			sectors[i].floor_yoffs = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::xpanningceiling:
+			sectors[i].ceiling_xoffs = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::ypanningceiling:
+			sectors[i].ceiling_yoffs = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::rotationfloor:
+			sectors[i].floorpic_angle = FixedAngle(FLOAT_TO_FIXED(atof(val)));
+			break;
+		case TextmapKey::rotationceiling:
+			sectors[i].ceilingpic_angle = FixedAngle(FLOAT_TO_FIXED(atof(val)));
+			break;
+		case TextmapKey::floorplane_a:
+			textmap_planefloor.defined |= PD_A;
+			textmap_planefloor.a = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::floorplane_b:
+			textmap_planefloor.defined |= PD_B;
+			textmap_planefloor.b = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::floorplane_c:
+			textmap_planefloor.defined |= PD_C;
+			textmap_planefloor.c = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::floorplane_d:
+			textmap_planefloor.defined |= PD_D;
+			textmap_planefloor.d = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::ceilingplane_a:
+			textmap_planeceiling.defined |= PD_A;
+			textmap_planeceiling.a = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::ceilingplane_b:
+			textmap_planeceiling.defined |= PD_B;
+			textmap_planeceiling.b = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::ceilingplane_c:
+			textmap_planeceiling.defined |= PD_C;
+			textmap_planeceiling.c = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::ceilingplane_d:
+			textmap_planeceiling.defined |= PD_D;
+			textmap_planeceiling.d = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::lightcolor:
+			textmap_colormap.used = true;
+			textmap_colormap.lightcolor = atol(val);
+			break;
+		case TextmapKey::lightalpha:
+			textmap_colormap.used = true;
+			textmap_colormap.lightalpha = atol(val);
+			break;
+		case TextmapKey::fadecolor:
+			textmap_colormap.used = true;
+			textmap_colormap.fadecolor = atol(val);
+			break;
+		case TextmapKey::fadealpha:
+			textmap_colormap.used = true;
+			textmap_colormap.fadealpha = atol(val);
+			break;
+		case TextmapKey::fadestart:
+			textmap_colormap.used = true;
+			textmap_colormap.fadestart = atol(val);
+			break;
+		case TextmapKey::fadeend:
+			textmap_colormap.used = true;
+			textmap_colormap.fadeend = atol(val);
+			break;
+		case TextmapKey::colormapfog:
+			if (fastcmp("true", val))
+			{
+				textmap_colormap.used = true;
+				textmap_colormap.flags |= CMF_FOG;
+			}
+			break;
+		case TextmapKey::colormapfadesprites:
+			if (fastcmp("true", val))
+			{
+				textmap_colormap.used = true;
+				textmap_colormap.flags |= CMF_FADEFULLBRIGHTSPRITES;
+			}
+			break;
+		case TextmapKey::colormapprotected:
+			if (fastcmp("true", val))
+				sectors[i].colormap_protected = true;
+			break;
+		case TextmapKey::flipspecial_nofloor:
+			if (fastcmp("true", val))
+				sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags & ~MSF_FLIPSPECIAL_FLOOR);
+			break;
+		case TextmapKey::flipspecial_ceiling:
+			if (fastcmp("true", val))
+				sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_FLIPSPECIAL_CEILING);
+			break;
+		case TextmapKey::triggerspecial_touch:
+			if (fastcmp("true", val))
+				sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_TRIGGERSPECIAL_TOUCH);
+			break;
+		case TextmapKey::triggerspecial_headbump:
+			if (fastcmp("true", val))
+				sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_TRIGGERSPECIAL_HEADBUMP);
+			break;
+		case TextmapKey::invertprecip:
+			if (fastcmp("true", val))
+				sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_INVERTPRECIP);
+			break;
+		case TextmapKey::gravityflip:
+			if (fastcmp("true", val))
+				sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_GRAVITYFLIP);
+			break;
+		case TextmapKey::heatwave:
+			if (fastcmp("true", val))
+				sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_HEATWAVE);
+			break;
+		case TextmapKey::noclipcamera:
+			if (fastcmp("true", val))
+				sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_NOCLIPCAMERA);
+			break;
+		case TextmapKey::ripple_floor:
+			if (fastcmp("true", val))
+				sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_RIPPLE_FLOOR);
+			break;
+		case TextmapKey::ripple_ceiling:
+			if (fastcmp("true", val))
+				sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_RIPPLE_CEILING);
+			break;
+		case TextmapKey::invertencore:
+			if (fastcmp("true", val))
+				sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_INVERTENCORE);
+			break;
+		case TextmapKey::flatlighting:
+			if (fastcmp("true", val))
+				sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_FLATLIGHTING);
+			break;
+		case TextmapKey::forcedirectionallighting:
+			if (fastcmp("true", val))
+				sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_DIRECTIONLIGHTING);
+			break;
+		case TextmapKey::nostepup:
+			if (fastcmp("true", val))
+				sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_NOSTEPUP);
+			break;
+		case TextmapKey::doublestepup:
+			if (fastcmp("true", val))
+				sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_DOUBLESTEPUP);
+			break;
+		case TextmapKey::nostepdown:
+			if (fastcmp("true", val))
+				sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_NOSTEPDOWN);
+			break;
+		case TextmapKey::cheatcheckactivator:
+		case TextmapKey::starpostactivator:
+			if (fastcmp("true", val))
+				sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_CHEATCHECKACTIVATOR);
+			break;
+		case TextmapKey::exit:
+			if (fastcmp("true", val))
+				sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_EXIT);
+			break;
+		case TextmapKey::deleteitems:
+			if (fastcmp("true", val))
+				sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_DELETEITEMS);
+			break;
+		case TextmapKey::fan:
+			if (fastcmp("true", val))
+				sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_FAN);
+			break;
+		case TextmapKey::zoomtubestart:
+			if (fastcmp("true", val))
+				sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_ZOOMTUBESTART);
+			break;
+		case TextmapKey::zoomtubeend:
+			if (fastcmp("true", val))
+				sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_ZOOMTUBEEND);
+			break;
+		case TextmapKey::friction:
+			sectors[i].friction = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::gravity:
+			sectors[i].gravity = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::damagetype:
+			if (fastcmp(val, "Generic"))
+				sectors[i].damagetype = SD_GENERIC;
+			if (fastcmp(val, "Lava"))
+				sectors[i].damagetype = SD_LAVA;
+			if (fastcmp(val, "DeathPit"))
+				sectors[i].damagetype = SD_DEATHPIT;
+			if (fastcmp(val, "Instakill"))
+				sectors[i].damagetype = SD_INSTAKILL;
+			if (fastcmp(val, "Stumble"))
+				sectors[i].damagetype = SD_STUMBLE;
+			break;
+		case TextmapKey::action:
+			sectors[i].action = atol(val);
+			break;
+		case TextmapKey::stringarg:
+			if (key.index >= NUM_SCRIPT_STRINGARGS)
+				break;
+			sectors[i].stringargs[key.index] = static_cast<char*>(Z_Malloc(strlen(val) + 1, PU_LEVEL, NULL));
+			M_Memcpy(sectors[i].stringargs[key.index], val, strlen(val) + 1);
+			break;
+		case TextmapKey::arg:
+			if (key.index >= NUM_SCRIPT_ARGS)
+				break;
+			sectors[i].args[key.index] = atol(val);
+			break;
+		case TextmapKey::repeatspecial:
+			if (fastcmp("true", val))
+				sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | ((sectors[i].activation & ~SECSPAC_TRIGGERMASK) | SECSPAC_REPEATSPECIAL));
+			break;
+		case TextmapKey::continuousspecial:
+			if (fastcmp("true", val))
+				sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | ((sectors[i].activation & ~SECSPAC_TRIGGERMASK) | SECSPAC_CONTINUOUSSPECIAL));
+			break;
+		case TextmapKey::playerenter:
+			if (fastcmp("true", val))
+				sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_ENTER);
+			break;
+		case TextmapKey::playerfloor:
+			if (fastcmp("true", val))
+				sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_FLOOR);
+			break;
+		case TextmapKey::playerceiling:
+			if (fastcmp("true", val))
+				sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_CEILING);
+			break;
+		case TextmapKey::monsterenter:
+			if (fastcmp("true", val))
+				sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_ENTERMONSTER);
+			break;
+		case TextmapKey::monsterfloor:
+			if (fastcmp("true", val))
+				sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_FLOORMONSTER);
+			break;
+		case TextmapKey::monsterceiling:
+			if (fastcmp("true", val))
+				sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_CEILINGMONSTER);
+			break;
+		case TextmapKey::missileenter:
+			if (fastcmp("true", val))
+				sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_ENTERMISSILE);
+			break;
+		case TextmapKey::missilefloor:
+			if (fastcmp("true", val))
+				sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_FLOORMISSILE);
+			break;
+		case TextmapKey::missileceiling:
+			if (fastcmp("true", val))
+				sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_CEILINGMISSILE);
+			break;
+		default:
+			ParseUserProperty(&sectors[i].user, param, val);
+			break;
 	}
-	else if (fastcmp(param, "xpanningfloor"))
-		sectors[i].floor_xoffs = FLOAT_TO_FIXED(atof(val));
-	else if (fastcmp(param, "ypanningfloor"))
-		sectors[i].floor_yoffs = FLOAT_TO_FIXED(atof(val));
-	else if (fastcmp(param, "xpanningceiling"))
-		sectors[i].ceiling_xoffs = FLOAT_TO_FIXED(atof(val));
-	else if (fastcmp(param, "ypanningceiling"))
-		sectors[i].ceiling_yoffs = FLOAT_TO_FIXED(atof(val));
-	else if (fastcmp(param, "rotationfloor"))
-		sectors[i].floorpic_angle = FixedAngle(FLOAT_TO_FIXED(atof(val)));
-	else if (fastcmp(param, "rotationceiling"))
-		sectors[i].ceilingpic_angle = FixedAngle(FLOAT_TO_FIXED(atof(val)));
-	else if (fastcmp(param, "floorplane_a"))
-	{
-		textmap_planefloor.defined |= PD_A;
-		textmap_planefloor.a = FLOAT_TO_FIXED(atof(val));
-	}
-	else if (fastcmp(param, "floorplane_b"))
-	{
-		textmap_planefloor.defined |= PD_B;
-		textmap_planefloor.b = FLOAT_TO_FIXED(atof(val));
-	}
-	else if (fastcmp(param, "floorplane_c"))
-	{
-		textmap_planefloor.defined |= PD_C;
-		textmap_planefloor.c = FLOAT_TO_FIXED(atof(val));
-	}
-	else if (fastcmp(param, "floorplane_d"))
-	{
-		textmap_planefloor.defined |= PD_D;
-		textmap_planefloor.d = FLOAT_TO_FIXED(atof(val));
-	}
-	else if (fastcmp(param, "ceilingplane_a"))
-	{
-		textmap_planeceiling.defined |= PD_A;
-		textmap_planeceiling.a = FLOAT_TO_FIXED(atof(val));
-	}
-	else if (fastcmp(param, "ceilingplane_b"))
-	{
-		textmap_planeceiling.defined |= PD_B;
-		textmap_planeceiling.b = FLOAT_TO_FIXED(atof(val));
-	}
-	else if (fastcmp(param, "ceilingplane_c"))
-	{
-		textmap_planeceiling.defined |= PD_C;
-		textmap_planeceiling.c = FLOAT_TO_FIXED(atof(val));
-	}
-	else if (fastcmp(param, "ceilingplane_d"))
-	{
-		textmap_planeceiling.defined |= PD_D;
-		textmap_planeceiling.d = FLOAT_TO_FIXED(atof(val));
-	}
-	else if (fastcmp(param, "lightcolor"))
-	{
-		textmap_colormap.used = true;
-		textmap_colormap.lightcolor = atol(val);
-	}
-	else if (fastcmp(param, "lightalpha"))
-	{
-		textmap_colormap.used = true;
-		textmap_colormap.lightalpha = atol(val);
-	}
-	else if (fastcmp(param, "fadecolor"))
-	{
-		textmap_colormap.used = true;
-		textmap_colormap.fadecolor = atol(val);
-	}
-	else if (fastcmp(param, "fadealpha"))
-	{
-		textmap_colormap.used = true;
-		textmap_colormap.fadealpha = atol(val);
-	}
-	else if (fastcmp(param, "fadestart"))
-	{
-		textmap_colormap.used = true;
-		textmap_colormap.fadestart = atol(val);
-	}
-	else if (fastcmp(param, "fadeend"))
-	{
-		textmap_colormap.used = true;
-		textmap_colormap.fadeend = atol(val);
-	}
-	else if (fastcmp(param, "colormapfog") && fastcmp("true", val))
-	{
-		textmap_colormap.used = true;
-		textmap_colormap.flags |= CMF_FOG;
-	}
-	else if (fastcmp(param, "colormapfadesprites") && fastcmp("true", val))
-	{
-		textmap_colormap.used = true;
-		textmap_colormap.flags |= CMF_FADEFULLBRIGHTSPRITES;
-	}
-	else if (fastcmp(param, "colormapprotected") && fastcmp("true", val))
-		sectors[i].colormap_protected = true;
-	else if (fastcmp(param, "flipspecial_nofloor") && fastcmp("true", val))
-		sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags & ~MSF_FLIPSPECIAL_FLOOR);
-	else if (fastcmp(param, "flipspecial_ceiling") && fastcmp("true", val))
-		sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_FLIPSPECIAL_CEILING);
-	else if (fastcmp(param, "triggerspecial_touch") && fastcmp("true", val))
-		sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_TRIGGERSPECIAL_TOUCH);
-	else if (fastcmp(param, "triggerspecial_headbump") && fastcmp("true", val))
-		sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_TRIGGERSPECIAL_HEADBUMP);
-	else if (fastcmp(param, "invertprecip") && fastcmp("true", val))
-		sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_INVERTPRECIP);
-	else if (fastcmp(param, "gravityflip") && fastcmp("true", val))
-		sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_GRAVITYFLIP);
-	else if (fastcmp(param, "heatwave") && fastcmp("true", val))
-		sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_HEATWAVE);
-	else if (fastcmp(param, "noclipcamera") && fastcmp("true", val))
-		sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_NOCLIPCAMERA);
-	else if (fastcmp(param, "ripple_floor") && fastcmp("true", val))
-		sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_RIPPLE_FLOOR);
-	else if (fastcmp(param, "ripple_ceiling") && fastcmp("true", val))
-		sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_RIPPLE_CEILING);
-	else if (fastcmp(param, "invertencore") && fastcmp("true", val))
-		sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_INVERTENCORE);
-	else if (fastcmp(param, "flatlighting") && fastcmp("true", val))
-		sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_FLATLIGHTING);
-	else if (fastcmp(param, "forcedirectionallighting") && fastcmp("true", val))
-		sectors[i].flags = static_cast<sectorflags_t>(sectors[i].flags | MSF_DIRECTIONLIGHTING);
-	else if (fastcmp(param, "nostepup") && fastcmp("true", val))
-		sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_NOSTEPUP);
-	else if (fastcmp(param, "doublestepup") && fastcmp("true", val))
-		sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_DOUBLESTEPUP);
-	else if (fastcmp(param, "nostepdown") && fastcmp("true", val))
-		sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_NOSTEPDOWN);
-	else if ((fastcmp(param, "cheatcheckactivator") || fastcmp(param, "starpostactivator")) && fastcmp("true", val))
-		sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_CHEATCHECKACTIVATOR);
-	else if (fastcmp(param, "exit") && fastcmp("true", val))
-		sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_EXIT);
-	else if (fastcmp(param, "deleteitems") && fastcmp("true", val))
-		sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_DELETEITEMS);
-	else if (fastcmp(param, "fan") && fastcmp("true", val))
-		sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_FAN);
-	else if (fastcmp(param, "zoomtubestart") && fastcmp("true", val))
-		sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_ZOOMTUBESTART);
-	else if (fastcmp(param, "zoomtubeend") && fastcmp("true", val))
-		sectors[i].specialflags = static_cast<sectorspecialflags_t>(sectors[i].specialflags | SSF_ZOOMTUBEEND);
-	else if (fastcmp(param, "friction"))
-		sectors[i].friction = FLOAT_TO_FIXED(atof(val));
-	else if (fastcmp(param, "gravity"))
-		sectors[i].gravity = FLOAT_TO_FIXED(atof(val));
-	else if (fastcmp(param, "damagetype"))
-	{
-		if (fastcmp(val, "Generic"))
-			sectors[i].damagetype = SD_GENERIC;
-		if (fastcmp(val, "Lava"))
-			sectors[i].damagetype = SD_LAVA;
-		if (fastcmp(val, "DeathPit"))
-			sectors[i].damagetype = SD_DEATHPIT;
-		if (fastcmp(val, "Instakill"))
-			sectors[i].damagetype = SD_INSTAKILL;
-		if (fastcmp(val, "Stumble"))
-			sectors[i].damagetype = SD_STUMBLE;
-	}
-	else if (fastcmp(param, "action"))
-		sectors[i].action = atol(val);
-	else if (fastncmp(param, "stringarg", 9) && strlen(param) > 9)
-	{
-		size_t argnum = atol(param + 9);
-		if (argnum >= NUM_SCRIPT_STRINGARGS)
-			return;
-		sectors[i].stringargs[argnum] = static_cast<char*>(Z_Malloc(strlen(val) + 1, PU_LEVEL, NULL));
-		M_Memcpy(sectors[i].stringargs[argnum], val, strlen(val) + 1);
-	}
-	else if (fastncmp(param, "arg", 3) && strlen(param) > 3)
-	{
-		size_t argnum = atol(param + 3);
-		if (argnum >= NUM_SCRIPT_ARGS)
-			return;
-		sectors[i].args[argnum] = atol(val);
-	}
-	else if (fastcmp(param, "repeatspecial") && fastcmp("true", val))
-		sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | ((sectors[i].activation & ~SECSPAC_TRIGGERMASK) | SECSPAC_REPEATSPECIAL));
-	else if (fastcmp(param, "continuousspecial") && fastcmp("true", val))
-		sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | ((sectors[i].activation & ~SECSPAC_TRIGGERMASK) | SECSPAC_CONTINUOUSSPECIAL));
-	else if (fastcmp(param, "playerenter") && fastcmp("true", val))
-		sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_ENTER);
-	else if (fastcmp(param, "playerfloor") && fastcmp("true", val))
-		sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_FLOOR);
-	else if (fastcmp(param, "playerceiling") && fastcmp("true", val))
-		sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_CEILING);
-	else if (fastcmp(param, "monsterenter") && fastcmp("true", val))
-		sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_ENTERMONSTER);
-	else if (fastcmp(param, "monsterfloor") && fastcmp("true", val))
-		sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_FLOORMONSTER);
-	else if (fastcmp(param, "monsterceiling") && fastcmp("true", val))
-		sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_CEILINGMONSTER);
-	else if (fastcmp(param, "missileenter") && fastcmp("true", val))
-		sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_ENTERMISSILE);
-	else if (fastcmp(param, "missilefloor") && fastcmp("true", val))
-		sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_FLOORMISSILE);
-	else if (fastcmp(param, "missileceiling") && fastcmp("true", val))
-		sectors[i].activation = static_cast<sectoractionflags_t>(sectors[i].activation | SECSPAC_CEILINGMISSILE);
-	else
-		ParseUserProperty(&sectors[i].user, param, val);
-}
-
-static void ParseTextmapSidedefParameter(UINT32 i, const char *param, const char *val)
-{
-	if (fastcmp(param, "offsetx"))
-		sides[i].textureoffset = atol(val)<<FRACBITS;
-	else if (fastcmp(param, "offsety"))
-		sides[i].rowoffset = atol(val)<<FRACBITS;
-	else if (fastcmp(param, "texturetop"))
-		sides[i].toptexture = R_TextureNumForName(val);
-	else if (fastcmp(param, "texturebottom"))
-		sides[i].bottomtexture = R_TextureNumForName(val);
-	else if (fastcmp(param, "texturemiddle"))
-		sides[i].midtexture = R_TextureNumForName(val);
-	else if (fastcmp(param, "sector"))
-		P_SetSidedefSector(i, atol(val));
-	else if (fastcmp(param, "repeatcnt"))
-		sides[i].repeatcnt = atol(val);
-	else
-		ParseUserProperty(&sides[i].user, param, val);
 }
 
-static void ParseTextmapLinedefParameter(UINT32 i, const char *param, const char *val)
+static void ParseTextmapSidedefParameter(UINT32 i, srb2::TextmapParam key, const char *param, const char *val)
 {
-	if (fastcmp(param, "id"))
-		Tag_FSet(&lines[i].tags, atol(val));
-	else if (fastcmp(param, "moreids"))
-	{
-		const char* id = val;
-		while (id)
-		{
-			Tag_Add(&lines[i].tags, atol(id));
-			if ((id = strchr(id, ' ')))
-				id++;
-		}
-	}
-	else if (fastcmp(param, "special"))
-		lines[i].special = atol(val);
-	else if (fastcmp(param, "v1"))
-		P_SetLinedefV1(i, atol(val));
-	else if (fastcmp(param, "v2"))
-		P_SetLinedefV2(i, atol(val));
-	else if (fastncmp(param, "stringarg", 9) && strlen(param) > 9)
-	{
-		size_t argnum = atol(param + 9);
-		if (argnum >= NUM_SCRIPT_STRINGARGS)
-			return;
-		lines[i].stringargs[argnum] = static_cast<char*>(Z_Malloc(strlen(val) + 1, PU_LEVEL, NULL));
-		M_Memcpy(lines[i].stringargs[argnum], val, strlen(val) + 1);
-	}
-	else if (fastncmp(param, "arg", 3) && strlen(param) > 3)
+	switch (key.key)
 	{
-		size_t argnum = atol(param + 3);
-		if (argnum >= NUM_SCRIPT_ARGS)
-			return;
-		lines[i].args[argnum] = atol(val);
-	}
-	else if (fastcmp(param, "sidefront"))
-		lines[i].sidenum[0] = atol(val);
-	else if (fastcmp(param, "sideback"))
-		lines[i].sidenum[1] = atol(val);
-	else if (fastcmp(param, "alpha"))
-		lines[i].alpha = FLOAT_TO_FIXED(atof(val));
-	else if (fastcmp(param, "blendmode") || fastcmp(param, "renderstyle"))
-	{
-		if (fastcmp(val, "translucent"))
-			lines[i].blendmode = AST_COPY;
-		else if (fastcmp(val, "add"))
-			lines[i].blendmode = AST_ADD;
-		else if (fastcmp(val, "subtract"))
-			lines[i].blendmode = AST_SUBTRACT;
-		else if (fastcmp(val, "reversesubtract"))
-			lines[i].blendmode = AST_REVERSESUBTRACT;
-		else if (fastcmp(val, "modulate"))
-			lines[i].blendmode = AST_MODULATE;
-		if (fastcmp(val, "fog"))
-			lines[i].blendmode = AST_FOG;
+		case TextmapKey::offsetx:
+			sides[i].textureoffset = atol(val)<<FRACBITS;
+			break;
+		case TextmapKey::offsety:
+			sides[i].rowoffset = atol(val)<<FRACBITS;
+			break;
+		case TextmapKey::texturetop:
+			sides[i].toptexture = R_TextureNumForName(val);
+			break;
+		case TextmapKey::texturebottom:
+			sides[i].bottomtexture = R_TextureNumForName(val);
+			break;
+		case TextmapKey::texturemiddle:
+			sides[i].midtexture = R_TextureNumForName(val);
+			break;
+		case TextmapKey::sector:
+			P_SetSidedefSector(i, atol(val));
+			break;
+		case TextmapKey::repeatcnt:
+			sides[i].repeatcnt = atol(val);
+			break;
+		default:
+			ParseUserProperty(&sides[i].user, param, val);
+			break;
 	}
+}
 
-	// Flags
-	else if (fastcmp(param, "blocking") && fastcmp("true", val))
-		lines[i].flags |= ML_IMPASSABLE;
-	else if (fastcmp(param, "blockplayers") && fastcmp("true", val))
-		lines[i].flags |= ML_BLOCKPLAYERS;
-	else if (fastcmp(param, "twosided") && fastcmp("true", val))
-		lines[i].flags |= ML_TWOSIDED;
-	else if (fastcmp(param, "dontpegtop") && fastcmp("true", val))
-		lines[i].flags |= ML_DONTPEGTOP;
-	else if (fastcmp(param, "dontpegbottom") && fastcmp("true", val))
-		lines[i].flags |= ML_DONTPEGBOTTOM;
-	else if (fastcmp(param, "skewtd") && fastcmp("true", val))
-		lines[i].flags |= ML_SKEWTD;
-	else if (fastcmp(param, "noclimb") && fastcmp("true", val))
-		lines[i].flags |= ML_NOCLIMB;
-	else if (fastcmp(param, "noskew") && fastcmp("true", val))
-		lines[i].flags |= ML_NOSKEW;
-	else if (fastcmp(param, "midpeg") && fastcmp("true", val))
-		lines[i].flags |= ML_MIDPEG;
-	else if (fastcmp(param, "midsolid") && fastcmp("true", val))
-		lines[i].flags |= ML_MIDSOLID;
-	else if (fastcmp(param, "wrapmidtex") && fastcmp("true", val))
-		lines[i].flags |= ML_WRAPMIDTEX;
-	else if (fastcmp(param, "blockmonsters") && fastcmp("true", val))
-		lines[i].flags |= ML_BLOCKMONSTERS;
-	else if (fastcmp(param, "nonet") && fastcmp("true", val))
-		lines[i].flags |= ML_NONET;
-	else if (fastcmp(param, "netonly") && fastcmp("true", val))
-		lines[i].flags |= ML_NETONLY;
-	else if (fastcmp(param, "notbouncy") && fastcmp("true", val))
-		lines[i].flags |= ML_NOTBOUNCY;
-	else if (fastcmp(param, "transfer") && fastcmp("true", val))
-		lines[i].flags |= ML_TFERLINE;
-	// Activation flags
-	else if (fastcmp(param, "repeatspecial") && fastcmp("true", val))
-		lines[i].activation |= SPAC_REPEATSPECIAL;
-	else if (fastcmp(param, "playercross") && fastcmp("true", val))
-		lines[i].activation |= SPAC_CROSS;
-	else if (fastcmp(param, "monstercross") && fastcmp("true", val))
-		lines[i].activation |= SPAC_CROSSMONSTER;
-	else if (fastcmp(param, "missilecross") && fastcmp("true", val))
-		lines[i].activation |= SPAC_CROSSMISSILE;
-	else if (fastcmp(param, "playerpush") && fastcmp("true", val))
-		lines[i].activation |= SPAC_PUSH;
-	else if (fastcmp(param, "monsterpush") && fastcmp("true", val))
-		lines[i].activation |= SPAC_PUSHMONSTER;
-	else if (fastcmp(param, "impact") && fastcmp("true", val))
-		lines[i].activation |= SPAC_IMPACT;
-	else
-		ParseUserProperty(&lines[i].user, param, val);
-}
-
-static void ParseTextmapThingParameter(UINT32 i, const char *param, const char *val)
-{
-	if (fastcmp(param, "id"))
-		mapthings[i].tid = atol(val);
-	else if (fastcmp(param, "x"))
-		mapthings[i].x = atol(val);
-	else if (fastcmp(param, "y"))
-		mapthings[i].y = atol(val);
-	else if (fastcmp(param, "height"))
-		mapthings[i].z = atol(val);
-	else if (fastcmp(param, "angle"))
-		mapthings[i].angle = atol(val);
-	else if (fastcmp(param, "pitch"))
-		mapthings[i].pitch = atol(val);
-	else if (fastcmp(param, "roll"))
-		mapthings[i].roll = atol(val);
-	else if (fastcmp(param, "type"))
-		mapthings[i].type = atol(val);
-	else if (fastcmp(param, "scale"))
-	{
-		if (udmf_version < 1)
-		{
-			mapthings[i].scale = FLOAT_TO_FIXED(atof(val));
-		}
-		else
-		{
-			mapthings[i].spritexscale = mapthings[i].spriteyscale = FLOAT_TO_FIXED(atof(val));
-		}
-	}
-	else if (fastcmp(param, "scalex"))
+static void ParseTextmapLinedefParameter(UINT32 i, srb2::TextmapParam key, const char *param, const char *val)
+{
+	switch (key.key)
 	{
-		if (udmf_version < 1)
-		{
-			mapthings[i].scale = FLOAT_TO_FIXED(atof(val));
-		}
-		else
+		case TextmapKey::id:
+			Tag_FSet(&lines[i].tags, atol(val));
+			break;
+		case TextmapKey::moreids:
 		{
-			mapthings[i].spritexscale = FLOAT_TO_FIXED(atof(val));
+			const char* id = val;
+			while (id)
+			{
+				Tag_Add(&lines[i].tags, atol(id));
+				if ((id = strchr(id, ' ')))
+					id++;
+			}
+			break;
 		}
+		case TextmapKey::special:
+			lines[i].special = atol(val);
+			break;
+		case TextmapKey::v1:
+			P_SetLinedefV1(i, atol(val));
+			break;
+		case TextmapKey::v2:
+			P_SetLinedefV2(i, atol(val));
+			break;
+		case TextmapKey::stringarg:
+			if (key.index >= NUM_SCRIPT_STRINGARGS)
+				break;
+			lines[i].stringargs[key.index] = static_cast<char*>(Z_Malloc(strlen(val) + 1, PU_LEVEL, NULL));
+			M_Memcpy(lines[i].stringargs[key.index], val, strlen(val) + 1);
+			break;
+		case TextmapKey::arg:
+			if (key.index >= NUM_SCRIPT_ARGS)
+				break;
+			lines[i].args[key.index] = atol(val);
+			break;
+		case TextmapKey::sidefront:
+			lines[i].sidenum[0] = atol(val);
+			break;
+		case TextmapKey::sideback:
+			lines[i].sidenum[1] = atol(val);
+			break;
+		case TextmapKey::alpha:
+			lines[i].alpha = FLOAT_TO_FIXED(atof(val));
+			break;
+		case TextmapKey::blendmode:
+		case TextmapKey::renderstyle:
+			if (fastcmp(val, "translucent"))
+				lines[i].blendmode = AST_COPY;
+			else if (fastcmp(val, "add"))
+				lines[i].blendmode = AST_ADD;
+			else if (fastcmp(val, "subtract"))
+				lines[i].blendmode = AST_SUBTRACT;
+			else if (fastcmp(val, "reversesubtract"))
+				lines[i].blendmode = AST_REVERSESUBTRACT;
+			else if (fastcmp(val, "modulate"))
+				lines[i].blendmode = AST_MODULATE;
+			if (fastcmp(val, "fog"))
+				lines[i].blendmode = AST_FOG;
+			break;
+
+		// Flags
+		case TextmapKey::blocking:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_IMPASSABLE;
+			break;
+		case TextmapKey::blockplayers:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_BLOCKPLAYERS;
+			break;
+		case TextmapKey::twosided:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_TWOSIDED;
+			break;
+		case TextmapKey::dontpegtop:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_DONTPEGTOP;
+			break;
+		case TextmapKey::dontpegbottom:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_DONTPEGBOTTOM;
+			break;
+		case TextmapKey::skewtd:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_SKEWTD;
+			break;
+		case TextmapKey::noclimb:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_NOCLIMB;
+			break;
+		case TextmapKey::noskew:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_NOSKEW;
+			break;
+		case TextmapKey::midpeg:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_MIDPEG;
+			break;
+		case TextmapKey::midsolid:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_MIDSOLID;
+			break;
+		case TextmapKey::wrapmidtex:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_WRAPMIDTEX;
+			break;
+		case TextmapKey::blockmonsters:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_BLOCKMONSTERS;
+			break;
+		case TextmapKey::nonet:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_NONET;
+			break;
+		case TextmapKey::netonly:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_NETONLY;
+			break;
+		case TextmapKey::notbouncy:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_NOTBOUNCY;
+			break;
+		case TextmapKey::transfer:
+			if (fastcmp("true", val))
+				lines[i].flags |= ML_TFERLINE;
+			break;
+		// Activation flags
+		case TextmapKey::repeatspecial:
+			if (fastcmp("true", val))
+				lines[i].activation |= SPAC_REPEATSPECIAL;
+			break;
+		case TextmapKey::playercross:
+			if (fastcmp("true", val))
+				lines[i].activation |= SPAC_CROSS;
+			break;
+		case TextmapKey::monstercross:
+			if (fastcmp("true", val))
+				lines[i].activation |= SPAC_CROSSMONSTER;
+			break;
+		case TextmapKey::missilecross:
+			if (fastcmp("true", val))
+				lines[i].activation |= SPAC_CROSSMISSILE;
+			break;
+		case TextmapKey::playerpush:
+			if (fastcmp("true", val))
+				lines[i].activation |= SPAC_PUSH;
+			break;
+		case TextmapKey::monsterpush:
+			if (fastcmp("true", val))
+				lines[i].activation |= SPAC_PUSHMONSTER;
+			break;
+		case TextmapKey::impact:
+			if (fastcmp("true", val))
+				lines[i].activation |= SPAC_IMPACT;
+			break;
+		default:
+			ParseUserProperty(&lines[i].user, param, val);
+			break;
 	}
-	else if (fastcmp(param, "scaley"))
+}
+
+static void ParseTextmapThingParameter(UINT32 i, srb2::TextmapParam key, const char *param, const char *val)
+{
+	switch (key.key)
 	{
-		if (udmf_version < 1)
-		{
+		case TextmapKey::id:
+			mapthings[i].tid = atol(val);
+			break;
+		case TextmapKey::x:
+			mapthings[i].x = atol(val);
+			break;
+		case TextmapKey::y:
+			mapthings[i].y = atol(val);
+			break;
+		case TextmapKey::height:
+			mapthings[i].z = atol(val);
+			break;
+		case TextmapKey::angle:
+			mapthings[i].angle = atol(val);
+			break;
+		case TextmapKey::pitch:
+			mapthings[i].pitch = atol(val);
+			break;
+		case TextmapKey::roll:
+			mapthings[i].roll = atol(val);
+			break;
+		case TextmapKey::type:
+			mapthings[i].type = atol(val);
+			break;
+		case TextmapKey::scale:
+			if (udmf_version < 1)
+			{
+				mapthings[i].scale = FLOAT_TO_FIXED(atof(val));
+			}
+			else
+			{
+				mapthings[i].spritexscale = mapthings[i].spriteyscale = FLOAT_TO_FIXED(atof(val));
+			}
+			break;
+		case TextmapKey::scalex:
+			if (udmf_version < 1)
+			{
+				mapthings[i].scale = FLOAT_TO_FIXED(atof(val));
+			}
+			else
+			{
+				mapthings[i].spritexscale = FLOAT_TO_FIXED(atof(val));
+			}
+			break;
+		case TextmapKey::scaley:
+			if (udmf_version < 1)
+			{
+				mapthings[i].scale = FLOAT_TO_FIXED(atof(val));
+			}
+			else
+			{
+				mapthings[i].spriteyscale = FLOAT_TO_FIXED(atof(val));
+			}
+			break;
+		case TextmapKey::mobjscale:
 			mapthings[i].scale = FLOAT_TO_FIXED(atof(val));
-		}
-		else
-		{
-			mapthings[i].spriteyscale = FLOAT_TO_FIXED(atof(val));
-		}
-	}
-	else if (fastcmp(param, "mobjscale"))
-		mapthings[i].scale = FLOAT_TO_FIXED(atof(val));
-	// Flags
-	else if (fastcmp(param, "flip") && fastcmp("true", val))
-		mapthings[i].options |= MTF_OBJECTFLIP;
+			break;
+		// Flags
+		case TextmapKey::flip:
+			if (fastcmp("true", val))
+				mapthings[i].options |= MTF_OBJECTFLIP;
+			break;
 
-	else if (fastcmp(param, "special"))
-		mapthings[i].special = atol(val);
-	else if (fastcmp(param, "foflayer"))
-		mapthings[i].layer = atol(val);
-	else if (fastncmp(param, "stringarg", 9) && strlen(param) > 9)
-	{
-		if (udmf_version < 1)
-		{
-			size_t argnum = atol(param + 9);
-			if (argnum >= NUM_MAPTHING_STRINGARGS)
-				return;
-			size_t len = strlen(val);
-			mapthings[i].thing_stringargs[argnum] = static_cast<char*>(Z_Malloc(len + 1, PU_LEVEL, NULL));
-			M_Memcpy(mapthings[i].thing_stringargs[argnum], val, len);
-			mapthings[i].thing_stringargs[argnum][len] = '\0';
-		}
-		else
+		case TextmapKey::special:
+			mapthings[i].special = atol(val);
+			break;
+		case TextmapKey::foflayer:
+			mapthings[i].layer = atol(val);
+			break;
+		case TextmapKey::stringarg:
+			if (udmf_version < 1)
+			{
+				if (key.index >= NUM_MAPTHING_STRINGARGS)
+					break;
+				size_t len = strlen(val);
+				mapthings[i].thing_stringargs[key.index] = static_cast<char*>(Z_Malloc(len + 1, PU_LEVEL, NULL));
+				M_Memcpy(mapthings[i].thing_stringargs[key.index], val, len);
+				mapthings[i].thing_stringargs[key.index][len] = '\0';
+			}
+			else
+			{
+				if (key.index >= NUM_SCRIPT_STRINGARGS)
+					break;
+				size_t len = strlen(val);
+				mapthings[i].script_stringargs[key.index] = static_cast<char*>(Z_Malloc(len + 1, PU_LEVEL, NULL));
+				M_Memcpy(mapthings[i].script_stringargs[key.index], val, len);
+				mapthings[i].script_stringargs[key.index][len] = '\0';
+			}
+			break;
+		case TextmapKey::arg:
+			if (udmf_version < 1)
+			{
+				if (key.index >= NUM_MAPTHING_ARGS)
+					break;
+				mapthings[i].thing_args[key.index] = atol(val);
+			}
+			else
+			{
+				if (key.index >= NUM_SCRIPT_ARGS)
+					break;
+				mapthings[i].script_args[key.index] = atol(val);
+			}
+			break;
+		case TextmapKey::thingstringarg:
 		{
-			size_t argnum = atol(param + 9);
-			if (argnum >= NUM_SCRIPT_STRINGARGS)
-				return;
+			if (key.index >= NUM_MAPTHING_STRINGARGS)
+				break;
 			size_t len = strlen(val);
-			mapthings[i].script_stringargs[argnum] = static_cast<char*>(Z_Malloc(len + 1, PU_LEVEL, NULL));
-			M_Memcpy(mapthings[i].script_stringargs[argnum], val, len);
-			mapthings[i].script_stringargs[argnum][len] = '\0';
-		}
-	}
-	else if (fastncmp(param, "arg", 3) && strlen(param) > 3)
-	{
-		if (udmf_version < 1)
-		{
-			size_t argnum = atol(param + 3);
-			if (argnum >= NUM_MAPTHING_ARGS)
-				return;
-			mapthings[i].thing_args[argnum] = atol(val);
-		}
-		else
-		{
-			size_t argnum = atol(param + 3);
-			if (argnum >= NUM_SCRIPT_ARGS)
-				return;
-			mapthings[i].script_args[argnum] = atol(val);
+			mapthings[i].thing_stringargs[key.index] = static_cast<char*>(Z_Malloc(len + 1, PU_LEVEL, NULL));
+			M_Memcpy(mapthings[i].thing_stringargs[key.index], val, len);
+			mapthings[i].thing_stringargs[key.index][len] = '\0';
+			break;
 		}
+		case TextmapKey::thingarg:
+			if (key.index >= NUM_MAPTHING_ARGS)
+				break;
+			mapthings[i].thing_args[key.index] = atol(val);
+			break;
+		default:
+			ParseUserProperty(&mapthings[i].user, param, val);
+			break;
 	}
-	else if (fastncmp(param, "thingstringarg", 14) && strlen(param) > 14)
-	{
-		size_t argnum = atol(param + 14);
-		if (argnum >= NUM_MAPTHING_STRINGARGS)
-			return;
-		size_t len = strlen(val);
-		mapthings[i].thing_stringargs[argnum] = static_cast<char*>(Z_Malloc(len + 1, PU_LEVEL, NULL));
-		M_Memcpy(mapthings[i].thing_stringargs[argnum], val, len);
-		mapthings[i].thing_stringargs[argnum][len] = '\0';
-	}
-	else if (fastncmp(param, "thingarg", 8) && strlen(param) > 8)
-	{
-		size_t argnum = atol(param + 8);
-		if (argnum >= NUM_MAPTHING_ARGS)
-			return;
-		mapthings[i].thing_args[argnum] = atol(val);
-	}
-	else
-		ParseUserProperty(&mapthings[i].user, param, val);
 }
 
 /** From a given position table, run a specified parser function through a {}-encapsuled text.
   *
   * \param Position of the data to parse, in the textmap.
   * \param Structure number (mapthings, sectors, ...).
-  * \param Parser function pointer.
+  * \param Parser function pointer, given each field's resolved key as well as its name.
   */
-static void TextmapParse(UINT32 dataPos, size_t num, void (*parser)(UINT32, const char *, const char *))
+static void TextmapParse(UINT32 dataPos, size_t num, void (*parser)(UINT32, srb2::TextmapParam, const char *, const char *))
 {
 	const char *param, *val;
+	const boolean record = (mapcache && !mapcachehit);
+
+	if (mapcachehit)
+	{
+		// Same fields, same order, no tokenizing or key lookups.
+		const srb2::MapCache &cache = *mapcache;
+		size_t i;
+
+		for (i = cache.block_fields[textmapblock]; i < cache.block_fields[textmapblock + 1]; i++)
+		{
+			const srb2::TextmapField &field = cache.fields[i];
+			textmapValIsString = field.is_string;
+			parser(num, cache.params[field.param], cache.keys[field.param].c_str(), &cache.strings[field.value]);
+		}
+
+		textmapblock++;
+		return;
+	}
 
 	M_TokenizerSetEndPos(dataPos);
 	param = M_TokenizerRead(0);
 	if (!fastcmp(param, "{"))
 	{
 		CONS_Alert(CONS_WARNING, "Invalid UDMF data capsule!\n");
+		if (record)
+			mapcache->block_fields.push_back(static_cast<uint32_t>(mapcache->fields.size()));
 		return;
 	}
 
@@ -2136,8 +2424,23 @@ static void TextmapParse(UINT32 dataPos, size_t num, void (*parser)(UINT32, cons
 		if (fastcmp(param, "}"))
 			break;
 		val = M_TokenizerRead(1);
-		parser(num, param, val);
+		textmapValIsString = M_TokenizerJustReadString();
+
+		if (record)
+		{
+			srb2::TextmapField field;
+			field.param = mapcache->add_key(param);
+			field.value = mapcache->add_string(val);
+			field.is_string = textmapValIsString;
+			mapcache->fields.push_back(field);
+			parser(num, mapcache->params[field.param], param, val);
+		}
+		else
+			parser(num, srb2::resolve_textmap_param(param), param, val);
 	}
+
+	if (record)
+		mapcache->block_fields.push_back(static_cast<uint32_t>(mapcache->fields.size()));
 }
 
 /** Provides a fix to the flat alignment coordinate transform from standard Textmaps.
@@ -3483,9 +3786,28 @@ static boolean P_LoadMapData(const virtres_t *virt)
 	virtlump_t *virtvertexes = NULL, *virtsectors = NULL, *virtsidedefs = NULL, *virtlinedefs = NULL, *virtthings = NULL;
 
 	// Count map data.
-	if (udmf) // Count how many entries for each type we got in textmap.
+	if (udmf && mapcachehit && mapcache->has_textmap)
+	{
+		// Parsed before; the counts come with the fields.
+		udmf_version = mapcache->udmf_version;
+		numvertexes  = mapcache->counts[0];
+		numsectors   = mapcache->counts[1];
+		numlines     = mapcache->counts[2];
+		numsides     = mapcache->counts[3];
+		nummapthings = mapcache->counts[4];
+		textmapblock = 0;
+	}
+	else if (udmf) // Count how many entries for each type we got in textmap.
 	{
 		virtlump_t *textmap = vres_Find(virt, "TEXTMAP");
+
+		if (mapcachehit)
+		{
+			// Nothing to replay, so tokenize it like usual.
+			mapcache.reset();
+			mapcachehit = false;
+		}
+
 		M_TokenizerOpen((char *)textmap->data, textmap->size);
 		if (!TextmapCount(textmap->size))
 		{
@@ -3493,6 +3815,20 @@ static boolean P_LoadMapData(const virtres_t *virt)
 			TracyCZoneEnd(__zone);
 			return false;
 		}
+
+		if (mapcache)
+		{
+			mapcache->has_textmap = true;
+			mapcache->udmf_version = udmf_version;
+			mapcache->counts = {
+				static_cast<uint32_t>(numvertexes),
+				static_cast<uint32_t>(numsectors),
+				static_cast<uint32_t>(numlines),
+				static_cast<uint32_t>(numsides),
+				static_cast<uint32_t>(nummapthings)
+			};
+			mapcache->block_fields.assign(1, 0);
+		}
 	}
 	else
 	{
@@ -3552,7 +3888,8 @@ static boolean P_LoadMapData(const virtres_t *virt)
 	if (udmf)
 	{
 		P_LoadTextmap();
-		M_TokenizerClose();
+		if (!mapcachehit)
+			M_TokenizerClose();
 	}
 	else
 	{
@@ -3946,6 +4283,12 @@ static boolean P_LoadExtendedSubsectorsAndSegs(UINT8 **data, nodetype_t nodetype
 	numsegs = READUINT32((*data));
 	segs = static_cast<seg_t*>(Z_Calloc(numsegs*sizeof(*segs), PU_LEVEL, NULL));
 
+	if (nodetype == NT_XGLN || nodetype == NT_XGL3)
+	{
+		segpartners = static_cast<UINT32*>(Z_Malloc(numsegs*sizeof(*segpartners), PU_LEVEL, NULL));
+		segsubsectors = static_cast<UINT32*>(Z_Malloc(numsegs*sizeof(*segsubsectors), PU_LEVEL, NULL));
+	}
+
 	for (i = 0, k = 0; i < numsubsectors; i++)
 	{
 		subsectors[i].firstline = k;
@@ -3958,6 +4301,7 @@ static boolean P_LoadExtendedSubsectorsAndSegs(UINT8 **data, nodetype_t nodetype
 			for (m = 0; m < subsectors[i].numlines; m++, k++)
 			{
 				UINT32 vertexnum = READUINT32((*data));
+				UINT32 partner;
 				UINT16 linenum;
 
 				if (vertexnum >= numvertexes)
@@ -3965,7 +4309,9 @@ static boolean P_LoadExtendedSubsectorsAndSegs(UINT8 **data, nodetype_t nodetype
 
 				segs[k - 1 + ((m == 0) ? subsectors[i].numlines : 0)].v2 = segs[k].v1 = &vertexes[vertexnum];
 
-				*data += sizeof (UINT32); // partner, can be ignored by software renderer
+				partner = READUINT32((*data)); // only needed for sight groups
+				segpartners[k] = partner < numsegs ? partner : UINT32_MAX;
+				segsubsectors[k] = static_cast<UINT32>(i);
 
 				linenum = (nodetype == NT_XGL3) ? READUINT32((*data)) : READUINT16((*data));
 				if (linenum != 0xFFFF && linenum >= numlines)
@@ -4069,6 +4415,8 @@ static void P_LoadMapBSP(const virtres_t *virt)
 	UINT8 *nodedata = NULL;
 	nodetype_t nodetype = P_GetNodetype(virt, &nodedata);
 
+	segpartners = segsubsectors = NULL;
+
 	switch (nodetype)
 	{
 	case NT_DOOM:
@@ -4137,6 +4485,24 @@ static void P_ReadBlockMapLump(INT16 *wadblockmaplump, size_t count)
 	}
 }
 
+// Allocates the per-block lists once the blockmap itself is set up.
+static void P_CreateBlockLinks(void)
+{
+	size_t count;
+
+	// clear out mobj chains
+	count = sizeof (*blocklinks)* bmapwidth*bmapheight;
+	blocklinks = static_cast<mobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+	blockmap = blockmaplump+4;
+
+	// haleyjd 2/22/06: setup polyobject blockmap
+	count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
+	polyblocklinks = static_cast<polymaplink_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+
+	count = sizeof (*precipblocklinks)* bmapwidth*bmapheight;
+	precipblocklinks = static_cast<precipmobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+}
+
 // This needs to be a separate function
 // because making both the WAD and PK3 loading code use
 // the same functions is trickier than it looks for blockmap
@@ -4157,17 +4523,28 @@ static boolean P_LoadBlockMap(UINT8 *data, size_t count)
 	bmapwidth = blockmaplump[2];
 	bmapheight = blockmaplump[3];
 
-	// clear out mobj chains
-	count = sizeof (*blocklinks)* bmapwidth*bmapheight;
-	blocklinks = static_cast<mobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
-	blockmap = blockmaplump+4;
+	P_CreateBlockLinks();
 
-	// haleyjd 2/22/06: setup polyobject blockmap
-	count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
-	polyblocklinks = static_cast<polymaplink_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+	return true;
+}
 
-	count = sizeof (*precipblocklinks)* bmapwidth*bmapheight;
-	precipblocklinks = static_cast<precipmobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+// Uses the blockmap P_CreateBlockMap made the last time this map was
+// loaded, if there is one and the nodes haven't changed since.
+static boolean P_LoadCachedBlockMap(void)
+{
+	if (!mapcachehit || !mapcache->has_blockmap
+		|| mapcache->blockmap_vertexes != numvertexes || mapcache->blockmap_lines != numlines)
+		return false;
+
+	blockmaplump = static_cast<INT32*>(Z_Malloc(mapcache->blockmap.size() * sizeof (*blockmaplump), PU_LEVEL, NULL));
+	memcpy(blockmaplump, mapcache->blockmap.data(), mapcache->blockmap.size() * sizeof (*blockmaplump));
+
+	bmaporgx = mapcache->bmaporgx;
+	bmaporgy = mapcache->bmaporgy;
+	bmapwidth = mapcache->bmapwidth;
+	bmapheight = mapcache->bmapheight;
+
+	P_CreateBlockLinks();
 
 	return true;
 }
@@ -4283,6 +4660,7 @@ static void P_CreateBlockMap(void)
 		} bmap_t; // blocklist structure
 
 		size_t tot = bmapwidth * bmapheight; // size of blockmap
+		size_t lumpsize;
 		bmap_t *bmap = static_cast<bmap_t*>(calloc(tot, sizeof (*bmap))); // array of blocklists
 		boolean straight;
 
@@ -4387,6 +4765,7 @@ static void P_CreateBlockMap(void)
 
 			// Allocate blockmap lump with computed count
 			blockmaplump = static_cast<INT32*>(Z_Calloc(sizeof (*blockmaplump) * count, PU_LEVEL, NULL));
+			lumpsize = count;
 		}
 
 		// Now compress the blockmap.
@@ -4412,20 +4791,21 @@ static void P_CreateBlockMap(void)
 
 			free(bmap); // Free uncompressed blockmap
 		}
-	}
-	{
-		size_t count = sizeof (*blocklinks) * bmapwidth * bmapheight;
-		// clear out mobj chains (copied from from P_LoadBlockMap)
-		blocklinks = static_cast<mobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
-		blockmap = blockmaplump + 4;
-
-		// haleyjd 2/22/06: setup polyobject blockmap
-		count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
-		polyblocklinks = static_cast<polymaplink_t**>(Z_Calloc(count, PU_LEVEL, NULL));
 
-		count = sizeof (*precipblocklinks)* bmapwidth*bmapheight;
-		precipblocklinks = static_cast<precipmobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+		if (mapcache && !mapcachehit)
+		{
+			mapcache->has_blockmap = true;
+			mapcache->blockmap_vertexes = static_cast<uint32_t>(numvertexes);
+			mapcache->blockmap_lines = static_cast<uint32_t>(numlines);
+			mapcache->bmaporgx = bmaporgx;
+			mapcache->bmaporgy = bmaporgy;
+			mapcache->bmapwidth = bmapwidth;
+			mapcache->bmapheight = bmapheight;
+			mapcache->blockmap.assign(blockmaplump, blockmaplump + lumpsize);
+		}
 	}
+
+	P_CreateBlockLinks();
 }
 
 // PK3 version
@@ -4455,10 +4835,126 @@ static void P_LoadMapLUT(const virtres_t *virt)
 	else
 		rejectmatrix = NULL;
 
-	if (!(virtblockmap && P_LoadBlockMap(virtblockmap->data, virtblockmap->size)))
+	if (!(virtblockmap && P_LoadBlockMap(virtblockmap->data, virtblockmap->size))
+		&& !P_LoadCachedBlockMap())
 		P_CreateBlockMap();
 }
 
+static size_t P_FindSightGroup(size_t *parent, size_t i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+
+	return i;
+}
+
+static void P_JoinSightGroups(size_t *parent, const sector_t *a, const sector_t *b)
+{
+	size_t ga, gb;
+
+	if (a == NULL || b == NULL)
+		return;
+
+	ga = P_FindSightGroup(parent, a - sectors);
+	gb = P_FindSightGroup(parent, b - sectors);
+
+	if (ga != gb)
+		parent[std::max(ga, gb)] = std::min(ga, gb);
+}
+
+// The sector on the far side of a miniseg. GL nodes name its partner seg;
+// otherwise look just past its midpoint, off the subsector's side.
+static sector_t *P_SectorAcrossMiniseg(size_t segnum)
+{
+	const seg_t *seg = &segs[segnum];
+	double dx, dy, len;
+	fixed_t x, y;
+
+	if (segpartners && segpartners[segnum] != UINT32_MAX)
+		return subsectors[segsubsectors[segpartners[segnum]]].sector;
+
+	dx = FixedToFloat(seg->v2->x - seg->v1->x);
+	dy = FixedToFloat(seg->v2->y - seg->v1->y);
+	len = std::hypot(dx, dy);
+
+	if (len == 0.0)
+		return NULL;
+
+	// Subsector segs run clockwise, so the far side is on the left.
+	x = seg->v1->x / 2 + seg->v2->x / 2 + FloatToFixed(-dy / len);
+	y = seg->v1->y / 2 + seg->v2->y / 2 + FloatToFixed(dx / len);
+
+	return R_PointInSubsector(x, y)->sector;
+}
+
+//
+// P_CreateSightGroups
+// Splits sectors into groups connected by two-sided lines, or by any seg
+// a sight trace can cross without hitting a line: segs of other sectors
+// left in a subsector by unclosed sectors, and minisegs.
+// Every sight trace stops at one-sided lines, so this is a conservative
+// reject table that costs one entry per sector. A full sector-to-sector
+// PVS would need numsectors^2 bits and a portal flow pass on every load
+// to also reject pairs that share a group; maps that want that can still
+// ship a REJECT lump, which is checked right after the groups.
+//
+static void P_CreateSightGroups(void)
+{
+	size_t i, j;
+
+	sectorsightgroups = static_cast<size_t*>(Z_Malloc(numsectors * sizeof (*sectorsightgroups), PU_LEVEL, NULL));
+
+	for (i = 0; i < numsectors; i++)
+		sectorsightgroups[i] = i;
+
+	for (i = 0; i < numlines; i++)
+	{
+		if (lines[i].flags & ML_TWOSIDED)
+			P_JoinSightGroups(sectorsightgroups, lines[i].frontsector, lines[i].backsector);
+	}
+
+	if (segsubsectors)
+	{
+		// GL nodes skip leading minisegs in firstline, so go by what was read.
+		for (i = 0; i < numsegs; i++)
+		{
+			sector_t *sector = subsectors[segsubsectors[i]].sector;
+
+			if (segs[i].glseg)
+				P_JoinSightGroups(sectorsightgroups, sector, P_SectorAcrossMiniseg(i));
+			else
+				P_JoinSightGroups(sectorsightgroups, sector, segs[i].frontsector);
+		}
+
+		Z_Free(segpartners);
+		Z_Free(segsubsectors);
+		segpartners = segsubsectors = NULL;
+	}
+	else
+	{
+		// Unclosed sectors can leave segs of another sector in a subsector,
+		// and traces walk subsectors without crossing a line there.
+		for (i = 0; i < numsubsectors; i++)
+		{
+			const size_t first = subsectors[i].firstline;
+
+			for (j = first; j < first + (size_t)subsectors[i].numlines && j < numsegs; j++)
+			{
+				if (segs[j].glseg)
+					P_JoinSightGroups(sectorsightgroups, subsectors[i].sector, P_SectorAcrossMiniseg(j));
+				else
+					P_JoinSightGroups(sectorsightgroups, subsectors[i].sector, segs[j].frontsector);
+			}
+		}
+	}
+
+	for (i = 0; i < numsectors; i++)
+		sectorsightgroups[i] = P_FindSightGroup(sectorsightgroups, i);
+}
+
 //
 // P_LinkMapData
 // Builds sector line lists and subsector sector numbers.
@@ -7542,16 +8038,33 @@ static boolean P_LoadMapFromFile(void)
 	udmf = textmap != NULL;
 	udmf_version = 0;
 
-	if (!P_LoadMapData(curmapvirt))
+	P_MakeMapMD5(curmapvirt, &mapmd5);
+	P_OpenMapCache(curmapvirt);
+
 	{
-		TracyCZoneEnd(__zone);
-		return false;
+		const boolean cached = mapcachehit;
+		const precise_t start = I_GetPreciseTime();
+
+		if (!P_LoadMapData(curmapvirt))
+		{
+			P_CloseMapCache(false);
+			TracyCZoneEnd(__zone);
+			return false;
+		}
+
+		P_LoadMapBSP(curmapvirt);
+		P_LoadMapLUT(curmapvirt);
+
+		// Compare against a run without -mapcache, or with a cold cache.
+		CONS_Debug(DBG_SETUP, "Map data took %f ms (%s)\n",
+			(double)(I_GetPreciseTime() - start) * 1000.0 / I_GetPrecisePrecision(),
+			cached ? "cached" : (mapcache ? "caching" : "no cache"));
 	}
 
-	P_LoadMapBSP(curmapvirt);
-	P_LoadMapLUT(curmapvirt);
+	P_CloseMapCache(true);
 
 	P_LinkMapData();
+	P_CreateSightGroups();
 
 	if (!udmf)
 		P_AddBinaryMapTags();
@@ -7577,8 +8090,6 @@ static boolean P_LoadMapFromFile(void)
 		if (sectors[i].tags.count)
 			spawnsectors[i].tags.tags = static_cast<mtag_t*>(memcpy(Z_Malloc(sectors[i].tags.count*sizeof(mtag_t), PU_LEVEL, NULL), sectors[i].tags.tags, sectors[i].tags.count*sizeof(mtag_t)));
 
-	P_MakeMapMD5(curmapvirt, &mapmd5);
-
 	TracyCZoneEnd(__zone);
 	return true;
 }
@@ -9448,6 +9959,11 @@ UINT16 P_PartialAddWadFile(const char *wadfilename)
 	//
 	R_LoadSpriteInfoLumps(wadnum, numlumps);
 
+	//
+	// decode new and replaced sounds now rather than mid-game
+	//
+	S_PrecacheSounds(wadnum);
+
 	// For anything that has to be done over every wadfile at once, see P_MultiSetupWadFiles.
 
 	refreshdirmenu &= ~REFRESHDIR_GAMEDATA; // Under usual circumstances we'd wait for REFRESHDIR_ flags to disappear the next frame, but this one's a bit too dangerous for that...
@@ -703,6 +703,13 @@ static boolean P_CompareMobjsAcrossLines(mobj_t *t1, mobj_t *t2, register los_fu
 	s2 = t2->subsector->sector;
 	pnum = (s1-sectors)*numsectors + (s2-sectors);
 
+	if (sectorsightgroups != NULL
+		&& sectorsightgroups[s1-sectors] != sectorsightgroups[s2-sectors])
+	{
+		// No two-sided lines lead from one to the other.
+		return false;
+	}
+
 	if (rejectmatrix != NULL)
 	{
 		// Check in REJECT table.
@@ -137,3 +137,15 @@ void Command_Debugrender_highlight(void)
 
 	detail::highlight_help(changes);
 }
+
+void Command_Debugrender_spancheck(void)
+{
+	if (R_CheckSpanDrawers())
+	{
+		CONS_Printf("Span drawers: vector and scalar output match.\n");
+	}
+	else
+	{
+		CONS_Alert(CONS_ERROR, "Span drawers: vector and scalar output differ!\n");
+	}
+}
@@ -17,6 +17,13 @@
 ///        The frame buffer is a linear one, and we need only the base address.
 
 #include <algorithm>
+#include <random>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define R_DRAW_AVX2
+#include <immintrin.h>
+#endif
 
 #include "doomdef.h"
 #include "doomstat.h"
@@ -31,6 +38,7 @@
 #include "k_color.h" // SRB2kart
 #include "i_threads.h"
 #include "libdivide.h" // used by NPO2 tilted span functions
+#include "m_argv.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -184,6 +184,12 @@ void R_InitViewBuffer(INT32 width, INT32 height);
 void R_InitViewBorder(void);
 void R_VideoErase(size_t ofs, INT32 count);
 
+// Picks the AVX2 span drawers if the CPU has them (and -nosimd wasn't given).
+void R_SelectSpanDrawers(void);
+
+// Compares the AVX2 span drawers against the scalar ones on random spans.
+boolean R_CheckSpanDrawers(void);
+
 // Rendering function.
 #if 0
 void R_FillBackScreen(void);
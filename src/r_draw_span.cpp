@@ -134,6 +134,101 @@ static constexpr UINT8 R_DrawSpanPixel(drawspandata_t* ds, UINT8 *dsrc, UINT8 *c
 	return R_GetSpanTranslucent<Type>(ds, dsrc, colormap, bit, col);
 }
 
+// Set by R_SelectSpanDrawers
+static boolean r_avx2spans = false;
+
+#ifdef R_DRAW_AVX2
+// Looks up a byte per lane. Each lane loads the 4 bytes at its index; near the end of the table the load is
+// moved back and the byte shifted down instead, so nothing past last + 3 is read.
+__attribute__((target("avx2")))
+static inline __m256i R_GatherBytesAVX2(const UINT8 *table, __m256i index, __m256i last)
+{
+	const __m256i base = _mm256_min_epu32(index, last);
+	const __m256i shift = _mm256_slli_epi32(_mm256_sub_epi32(index, base), 3);
+	const __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int *>(table), base, 1);
+	return _mm256_and_si256(_mm256_srlv_epi32(words, shift), _mm256_set1_epi32(0xFF));
+}
+
+/**	\brief Draws as much of a power of two span as fits in runs of 8 pixels, with the same
+	results as R_DrawSpanPixel. Positions and steps are already shifted up.
+	\return the number of pixels drawn
+*/
+template<DrawSpanType Type>
+__attribute__((target("avx2")))
+static size_t R_DrawSpanAVX2(drawspandata_t* ds, UINT8 *dest, UINT8 *dsrc, size_t count, UINT32 xposition, UINT32 yposition, UINT32 xstep, UINT32 ystep)
+{
+	static_assert(!(Type & DS_SPRITE), "floor sprites have 16-bit sources");
+
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i x = _mm256_add_epi32(_mm256_set1_epi32(xposition), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(xstep)));
+	__m256i y = _mm256_add_epi32(_mm256_set1_epi32(yposition), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(ystep)));
+	const __m256i xstep8 = _mm256_set1_epi32(xstep * 8);
+	const __m256i ystep8 = _mm256_set1_epi32(ystep * 8);
+	const __m128i xshift = _mm_cvtsi32_si128(ds->nflatxshift);
+	const __m128i yshift = _mm_cvtsi32_si128(ds->nflatyshift);
+	const __m256i mask = _mm256_set1_epi32(ds->nflatmask);
+
+	// Highest index the shifts and mask can produce, i.e. the flat's size - 1
+	const __m256i flatlast = _mm256_set1_epi32((ds->nflatmask | (0xFFFFFFFFu >> ds->nflatxshift)) - 3);
+	const __m256i maplast = _mm256_set1_epi32(256 - 4);
+	const __m256i translast = _mm256_set1_epi32(65536 - 4);
+	const __m256i pack = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+	size_t i;
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		const __m256i bit = _mm256_or_si256(_mm256_and_si256(_mm256_srl_epi32(y, yshift), mask), _mm256_srl_epi32(x, xshift));
+		__m256i col = R_GatherBytesAVX2(ds->source, bit, flatlast);
+		__m256i holes = _mm256_setzero_si256();
+		__m256i below = _mm256_setzero_si256();
+
+		if constexpr (Type & DS_HOLES)
+		{
+			holes = _mm256_cmpeq_epi32(col, _mm256_set1_epi32(TRANSPARENTPIXEL));
+		}
+
+		if constexpr (Type & DS_COLORMAP)
+		{
+			col = R_GatherBytesAVX2(ds->translation, col, maplast);
+		}
+
+		__m256i out = R_GatherBytesAVX2(ds->colormap, col, maplast);
+
+		if constexpr (Type & DS_BRIGHTMAP)
+		{
+			const __m256i bright = _mm256_cmpeq_epi32(R_GatherBytesAVX2(ds->brightmap, bit, flatlast), _mm256_set1_epi32(BRIGHTPIXEL));
+			out = _mm256_blendv_epi8(out, R_GatherBytesAVX2(ds->fullbright, col, maplast), bright);
+		}
+
+		if constexpr (Type & (DS_TRANSMAP|DS_HOLES))
+		{
+			below = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(dsrc + i)));
+		}
+
+		if constexpr (Type & DS_TRANSMAP)
+		{
+			out = R_GatherBytesAVX2(ds->transmap, _mm256_or_si256(_mm256_slli_epi32(out, 8), below), translast);
+		}
+
+		if constexpr (Type & DS_HOLES)
+		{
+			out = _mm256_blendv_epi8(out, below, holes);
+		}
+
+		// 8 x 32-bit -> 8 x 8-bit; the packs work per 128-bit half, so bring the halves together
+		out = _mm256_packus_epi32(out, out);
+		out = _mm256_packus_epi16(out, out);
+		out = _mm256_permutevar8x32_epi32(out, pack);
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(dest + i), _mm256_castsi256_si128(out));
+
+		x = _mm256_add_epi32(x, xstep8);
+		y = _mm256_add_epi32(y, ystep8);
+	}
+
+	return i;
+}
+#endif
+
 /**	\brief The R_DrawSpan_8 function
 	Draws the actual span.
 */
@@ -186,6 +281,22 @@ static void R_DrawSpanTemplate(drawspandata_t* ds)
 		return;
 	}
 
+#ifdef R_DRAW_AVX2
+	if constexpr (!(Type & DS_SPRITE))
+	{
+		if (r_avx2spans)
+		{
+			const size_t done = R_DrawSpanAVX2<Type>(ds, dest, dsrc, count, xposition, yposition, xstep, ystep);
+
+			dest += done;
+			dsrc += done;
+			count -= done;
+			xposition = (fixed_t)((UINT32)xposition + (UINT32)xstep * (UINT32)done);
+			yposition = (fixed_t)((UINT32)yposition + (UINT32)ystep * (UINT32)done);
+		}
+	}
+#endif
+
 	while (count >= 8)
 	{
 		// SoM: Why didn't I see this earlier? the spot variable is a waste now because we don't
@@ -866,3 +977,151 @@ void R_DrawTiltedSpan_Flat(drawspandata_t* ds)
 		ds->x1++;
 	}
 }
+
+// ==========================================================================
+// VECTOR SPAN SELECTION AND CHECK
+// ==========================================================================
+
+#ifdef R_DRAW_AVX2
+// Draws one span with R_DrawSpanPixel, and again with R_DrawSpanAVX2 followed by the same scalar tail as
+// R_DrawSpanTemplate. Both start from the same background.
+template<DrawSpanType Type>
+static boolean R_CompareSpanAVX2(drawspandata_t* ds, const std::vector<UINT8>& background, UINT8 *ripple, size_t count, UINT32 xposition, UINT32 yposition, UINT32 xstep, UINT32 ystep)
+{
+	std::vector<UINT8> scalar = background;
+	std::vector<UINT8> vector = background;
+
+	auto draw_scalar = [&](UINT8 *dest, UINT8 *dsrc, size_t i, UINT32 x, UINT32 y)
+	{
+		for (; i < count; i++)
+		{
+			const UINT32 bit = ((y >> ds->nflatyshift) & ds->nflatmask) | (x >> ds->nflatxshift);
+			dest[i] = R_DrawSpanPixel<Type>(ds, &dsrc[i], ds->colormap, bit);
+			x += xstep;
+			y += ystep;
+		}
+	};
+
+	draw_scalar(scalar.data(), (Type & DS_RIPPLE) ? ripple : scalar.data(), 0, xposition, yposition);
+
+	UINT8 *dsrc = (Type & DS_RIPPLE) ? ripple : vector.data();
+	const size_t done = R_DrawSpanAVX2<Type>(ds, vector.data(), dsrc, count, xposition, yposition, xstep, ystep);
+	draw_scalar(vector.data(), dsrc, done, xposition + xstep * done, yposition + ystep * done);
+
+	return scalar == vector;
+}
+
+template<int Flags>
+static boolean R_CompareSpanComboAVX2(drawspandata_t* ds, const std::vector<UINT8>& background, UINT8 *ripple, size_t count, UINT32 xposition, UINT32 yposition, UINT32 xstep, UINT32 ystep)
+{
+	constexpr DrawSpanType opt = static_cast<DrawSpanType>(Flags);
+	constexpr DrawSpanType bm = static_cast<DrawSpanType>(Flags|DS_BRIGHTMAP);
+
+	return R_CompareSpanAVX2<opt>(ds, background, ripple, count, xposition, yposition, xstep, ystep)
+		&& R_CompareSpanAVX2<bm>(ds, background, ripple, count, xposition, yposition, xstep, ystep);
+}
+#endif
+
+/**	\brief Draws random spans of every power of two span type with both the vector and the
+	scalar drawers, and compares the results.
+	\return true if they are identical, or if there are no vector drawers on this CPU
+*/
+boolean R_CheckSpanDrawers(void)
+{
+#ifdef R_DRAW_AVX2
+	if (!__builtin_cpu_supports("avx2"))
+	{
+		return true;
+	}
+
+	// Fixed seed, so a mismatch can be reproduced
+	std::mt19937 rng(1);
+	auto random_bytes = [&rng](size_t size)
+	{
+		std::vector<UINT8> out(size);
+		for (UINT8& b : out)
+		{
+			b = static_cast<UINT8>(rng());
+		}
+		return out;
+	};
+
+	std::vector<UINT8> colormap = random_bytes(256);
+	std::vector<UINT8> fullbright = random_bytes(256);
+	std::vector<UINT8> transmap = random_bytes(65536);
+	std::vector<UINT8> background = random_bytes(1024);
+	std::vector<UINT8> ripple = random_bytes(1024);
+
+	drawspandata_t ds {};
+	ds.colormap = colormap.data();
+	ds.fullbright = fullbright.data();
+	ds.transmap = transmap.data();
+
+	for (size_t flatsize : {8, 64, 256, 2048})
+	{
+		std::vector<UINT8> source = random_bytes(flatsize * flatsize);
+		std::vector<UINT8> brightmap = random_bytes(flatsize * flatsize);
+
+		// Plenty of holes and bright pixels, and the edges of the flat
+		for (UINT8& b : source)
+		{
+			if (rng() % 4 == 0)
+				b = TRANSPARENTPIXEL;
+		}
+		for (UINT8& b : brightmap)
+		{
+			if (rng() % 2 == 0)
+				b = BRIGHTPIXEL;
+		}
+
+		R_CheckFlatLength(&ds, flatsize * flatsize);
+		ds.source = source.data();
+		ds.brightmap = brightmap.data();
+
+		for (INT32 i = 0; i < 64; i++)
+		{
+			const size_t count = rng() % background.size();
+			const UINT32 x = rng();
+			const UINT32 y = rng();
+			UINT32 xstep = static_cast<UINT32>(rng()) >> (rng() % 24);
+			UINT32 ystep = static_cast<UINT32>(rng()) >> (rng() % 24);
+
+			if (rng() % 2)
+				xstep = -xstep;
+			if (rng() % 2)
+				ystep = -ystep;
+
+			if (!R_CompareSpanComboAVX2<DS_BASIC>(&ds, background, ripple.data(), count, x, y, xstep, ystep)
+				|| !R_CompareSpanComboAVX2<DS_TRANSMAP>(&ds, background, ripple.data(), count, x, y, xstep, ystep)
+				|| !R_CompareSpanComboAVX2<DS_HOLES>(&ds, background, ripple.data(), count, x, y, xstep, ystep)
+				|| !R_CompareSpanComboAVX2<DS_TRANSMAP|DS_HOLES>(&ds, background, ripple.data(), count, x, y, xstep, ystep)
+				|| !R_CompareSpanComboAVX2<DS_TRANSMAP|DS_RIPPLE>(&ds, background, ripple.data(), count, x, y, xstep, ystep))
+			{
+				return false;
+			}
+		}
+	}
+#endif
+
+	return true;
+}
+
+void R_SelectSpanDrawers(void)
+{
+	r_avx2spans = false;
+
+#ifdef R_DRAW_AVX2
+	if (__builtin_cpu_supports("avx2") && !M_CheckParm("-nosimd"))
+	{
+		r_avx2spans = true;
+
+#ifdef PARANOIA
+		if (!R_CheckSpanDrawers())
+		{
+			CONS_Alert(CONS_WARNING, "AVX2 span drawers don't match the scalar ones, not using them\n");
+			r_avx2spans = false;
+		}
+#endif
+	}
+#endif
+}
@@ -15,6 +15,7 @@
 ///        See tables.c, too.
 
 #include <algorithm>
+#include <vector>
 
 #include "doomdef.h"
 #include "g_game.h"
@@ -134,6 +135,10 @@ int ps_numsprites = 0;
 int ps_numdrawnodes = 0;
 int ps_numpolyobjects = 0;
 
+int ps_2d_numcmds = 0;
+int ps_2d_numbatches = 0;
+int ps_2d_numreordered = 0;
+
 struct RenderStats g_renderstats;
 
 void SplitScreen_OnChange(void)
@@ -865,52 +870,92 @@ void R_CheckViewMorph(int s)
 	v->use = true;
 }
 
-void R_ApplyViewMorph(int s)
+// Where viewport s starts on screens[0], and its size.
+static UINT8 *R_ViewMorphArea(int s, INT32 *width, INT32 *height)
 {
-	UINT8 *tmpscr = screens[4];
 	UINT8 *srcscr = screens[0];
-	INT32 width = vid.width;
-	INT32 height = vid.height;
-	INT32 p;
-	INT32 end;
 
-	if (!viewmorph[s].use)
-		return;
+	*width = vid.width;
+	*height = vid.height;
 
 	if (r_splitscreen == 1)
 	{
-		height /= 2;
+		*height /= 2;
 
 		if (s == 1)
 		{
-			srcscr += vid.width * height;
+			srcscr += vid.width * *height;
 		}
 	}
 	else if (r_splitscreen > 1)
 	{
-		width /= 2;
-		height /= 2;
+		*width /= 2;
+		*height /= 2;
 
 		if (s % 2)
 		{
-			srcscr += width;
+			srcscr += *width;
 		}
 
 		if (s > 1)
 		{
-			srcscr += vid.width * height;
+			srcscr += vid.width * *height;
 		}
 	}
 
-	end = width * height;
+	return srcscr;
+}
 
-	for (p = 0; p < end; p++)
+void R_ApplyViewMorphs(void)
+{
+	// Gather every morphed viewport into its own slice of screens[4] first.
+	// Viewports never overlap on screen and the gathers only read
+	// screens[0], so all of them can run at once; the copies back have to
+	// wait until every gather reading that viewport is done.
+	constexpr INT32 kMorphRowsPerTask = 32;
+	INT32 s;
+
+	srb2::g_main_threadpool->begin_sema();
+
+	for (s = 0; s <= r_splitscreen; s++)
 	{
-		tmpscr[p] = srcscr[viewmorph[s].scrmap[p]];
+		INT32 width, height;
+		const UINT8 *srcscr = R_ViewMorphArea(s, &width, &height);
+		UINT8 *tmpscr = screens[4] + s * width * height;
+		const INT32 *scrmap = viewmorph[s].scrmap;
+
+		if (!viewmorph[s].use)
+			continue;
+
+		for (INT32 row = 0; row < height; row += kMorphRowsPerTask)
+		{
+			INT32 begin = row * width;
+			INT32 end = std::min(row + kMorphRowsPerTask, height) * width;
+
+			srb2::g_main_threadpool->schedule([=]() {
+				for (INT32 p = begin; p < end; p++)
+				{
+					tmpscr[p] = srcscr[scrmap[p]];
+				}
+			});
+		}
 	}
 
-	VID_BlitLinearScreen(tmpscr, srcscr,
-			width*vid.bpp, height, width*vid.bpp, vid.width);
+	srb2::ThreadPool::Sema sema = srb2::g_main_threadpool->end_sema();
+	srb2::g_main_threadpool->notify_sema(sema);
+	srb2::g_main_threadpool->wait_sema(sema);
+
+	for (s = 0; s <= r_splitscreen; s++)
+	{
+		INT32 width, height;
+		UINT8 *srcscr = R_ViewMorphArea(s, &width, &height);
+
+		if (!viewmorph[s].use)
+			continue;
+
+		VID_BlitLinearScreen(screens[4] + s * width * height, srcscr,
+				width*vid.bpp, height, width*vid.bpp, vid.width);
+	}
 }
 
 angle_t R_ViewRollAngle(const player_t *player, UINT8 viewnum)
@@ -1499,11 +1544,21 @@ static void R_RenderViewpoint(maskcount_t* mask, INT32 cachenum)
 // I mean, there is a win16lock() or something that lasts all the rendering,
 // so maybe we should release screen lock before each netupdate below..?
 
+// Mask lists kept between frames, one per splitscreen view, so they are
+// only reallocated when a view's portal count grows.
+static std::vector<maskcount_t> viewmasks[MAXSPLITSCREENPLAYERS];
+
 void R_RenderPlayerView(void)
 {
 	player_t * player = &players[displayplayers[viewssnum]];
+	std::vector<maskcount_t> &maskvec = viewmasks[viewssnum];
 	INT32			nummasks	= 1;
-	maskcount_t*	masks		= static_cast<maskcount_t*>(malloc(sizeof(maskcount_t)));
+	maskcount_t*	masks;
+	drawnode_t*		maskheads;
+	precise_t		maskstart;
+
+	maskvec.resize(1);
+	masks = maskvec.data();
 
 	R_SetupFrame(viewssnum);
 	framecount++;
@@ -1594,7 +1649,8 @@ void R_RenderPlayerView(void)
 
 			validcount++;
 
-			masks = static_cast<maskcount_t*>(realloc(masks, (++nummasks)*sizeof(maskcount_t)));
+			maskvec.resize(++nummasks);
+			masks = maskvec.data();
 
 			portalskipprecipmobjs = portal->isskybox;
 
@@ -1621,14 +1677,21 @@ void R_RenderPlayerView(void)
 	R_DrawPlanes();
 	tp_sema = srb2::g_main_threadpool->end_sema();
 	srb2::g_main_threadpool->notify_sema(tp_sema);
+
+	// Sort sprites and masked segs into drawnodes while the plane jobs run.
+	// This only reads the BSP results and doesn't touch the screen.
+	maskstart = I_GetPreciseTime();
+	maskheads = R_CreateMaskedLists(masks, nummasks);
+	ps_sw_maskedtime = I_GetPreciseTime() - maskstart;
+
 	srb2::g_main_threadpool->wait_sema(tp_sema);
-	ps_sw_planetime = I_GetPreciseTime() - ps_sw_planetime;
+	ps_sw_planetime = I_GetPreciseTime() - ps_sw_planetime - ps_sw_maskedtime;
 
 	// draw mid texture and sprite
 	// And now 3D floors/sides!
-	ps_sw_maskedtime = I_GetPreciseTime();
-	R_DrawMasked(masks, nummasks);
-	ps_sw_maskedtime = I_GetPreciseTime() - ps_sw_maskedtime;
+	maskstart = I_GetPreciseTime();
+	R_DrawMaskedLists(maskheads, masks, nummasks);
+	ps_sw_maskedtime += I_GetPreciseTime() - maskstart;
 
 	if (cv_debugrender_visplanes.value)
 	{
@@ -1711,8 +1774,6 @@ void R_RenderPlayerView(void)
 			Portal_Remove(portal);
 		}
 	}
-
-	free(masks);
 }
 
 // =========================================================================
@@ -1728,4 +1789,5 @@ void R_RegisterEngineStuff(void)
 	// debugging
 
 	COM_AddDebugCommand("debugrender_highlight", Command_Debugrender_highlight);
+	COM_AddDebugCommand("debugrender_spancheck", Command_Debugrender_spancheck);
 }
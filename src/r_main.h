@@ -112,6 +112,10 @@ extern int ps_numsprites;
 extern int ps_numdrawnodes;
 extern int ps_numpolyobjects;
 
+extern int ps_2d_numcmds;
+extern int ps_2d_numbatches;
+extern int ps_2d_numreordered;
+
 struct RenderStats
 {
 	size_t visplanes;
@@ -159,6 +163,7 @@ INT32 R_AdjustLightLevel(INT32 light);
 UINT8 R_DebugLineColor(const line_t *ld);
 
 void Command_Debugrender_highlight(void);
+void Command_Debugrender_spancheck(void);
 
 extern consvar_t
 	cv_debugrender_contrast,
@@ -169,7 +174,7 @@ extern consvar_t
 void R_Init(void);
 
 void R_CheckViewMorph(int split);
-void R_ApplyViewMorph(int split);
+void R_ApplyViewMorphs(void); // every splitscreen view at once
 angle_t R_ViewRollAngle(const player_t *player, UINT8 viewnum);
 
 // just sets setsizeneeded true
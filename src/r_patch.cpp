@@ -30,6 +30,8 @@ patch_t *Patch_Create(softwarepatch_t *source, size_t srcsize, void *dest)
 {
 	patch_t *patch = (dest == NULL) ? static_cast<patch_t*>(Z_Calloc(sizeof(patch_t), PU_PATCH, NULL)) : (patch_t *)(dest);
 
+	Z_MarkPatch(patch);
+
 	if (source)
 	{
 		INT32 col, colsize;
@@ -65,6 +67,11 @@ patch_t *Patch_Create(softwarepatch_t *source, size_t srcsize, void *dest)
 
 static boolean g_patch_was_freed_this_frame = false;
 
+#define MAXFREEDPATCHES 1024
+
+static patch_t *g_freed_patches[MAXFREEDPATCHES];
+static size_t g_num_freed_patches = 0; // > MAXFREEDPATCHES once too many were freed
+
 //
 // Frees a patch from memory.
 //
@@ -101,8 +108,16 @@ static void Patch_FreeData(patch_t *patch)
 
 	Z_Free(patch->columnofs);
 	Z_Free(patch->columns);
+}
 
+void Patch_NoteFreed(patch_t *patch)
+{
 	g_patch_was_freed_this_frame = true;
+
+	if (g_num_freed_patches < MAXFREEDPATCHES)
+		g_freed_patches[g_num_freed_patches] = patch;
+	if (g_num_freed_patches <= MAXFREEDPATCHES)
+		g_num_freed_patches++;
 }
 
 void Patch_Free(patch_t *patch)
@@ -124,6 +139,22 @@ void Patch_ResetFreedThisFrame(void)
 	g_patch_was_freed_this_frame = false;
 }
 
+patch_t **Patch_TakeFreedPatches(size_t *count)
+{
+	size_t num = g_num_freed_patches;
+
+	g_num_freed_patches = 0;
+
+	if (num > MAXFREEDPATCHES)
+	{
+		*count = 0;
+		return NULL;
+	}
+
+	*count = num;
+	return g_freed_patches;
+}
+
 //
 // Frees patches with a tag range.
 //
@@ -29,6 +29,14 @@ void Patch_Free(patch_t *patch);
 boolean Patch_WasFreedThisFrame(void);
 void Patch_ResetFreedThisFrame(void);
 
+// Called by the zone for every patch it frees, however it was freed.
+void Patch_NoteFreed(patch_t *patch);
+
+// Patches freed since the last call, for caches keyed by patch pointer.
+// Returns NULL if too many were freed to keep track of; forget every
+// patch in that case.
+patch_t **Patch_TakeFreedPatches(size_t *count);
+
 #define Patch_FreeTag(tagnum) Patch_FreeTags(tagnum, tagnum)
 void Patch_FreeTags(INT32 lowtag, INT32 hightag);
 
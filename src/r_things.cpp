@@ -13,6 +13,8 @@
 /// \brief Refresh of things, i.e. objects represented by sprites
 
 #include <algorithm>
+#include <functional>
+#include <vector>
 
 #include "doomdef.h"
 #include "console.h"
@@ -2894,19 +2896,18 @@ void R_AddPrecipitationSprites(void)
 //
 static void R_SortVisSprites(vissprite_t* vsprsortedhead, UINT32 start, UINT32 end)
 {
-	UINT32       i, count = 0;
-	vissprite_t *ds, *dsprev, *dsnext, *dsfirst;
-	vissprite_t *best = NULL;
-	vissprite_t  unsorted;
-	fixed_t      bestscale;
-	INT32        bestdispoffset;
+	// Reused between frames so sorting doesn't allocate
+	static std::vector<vissprite_t*> sorted;
+	static std::vector<vissprite_t*> tracers;
 
-	dsfirst = &unsorted;
-	dsprev = dsfirst;
-	dsnext = dsfirst;
+	UINT32       i;
+	vissprite_t *ds, *dsfirst, *dsnext;
 
 	I_Assert(start <= end);
 
+	sorted.clear();
+	tracers.clear();
+
 	for (i = start; i < end; ++i)
 	{
 		ds = R_GetVisSprite(i);
@@ -2917,70 +2918,57 @@ static void R_SortVisSprites(vissprite_t* vsprsortedhead, UINT32 start, UINT32 e
 			continue;
 		}
 
-		dsnext = ds;
-		dsnext->linkdraw = NULL;
-
-		dsprev->next = dsnext;
-		dsnext->prev = dsprev;
-		dsprev = dsnext;
+		ds->linkdraw = NULL;
+		sorted.push_back(ds);
 
-		count++;
+		// don't connect to links, shadows or bounding boxes
+		if (!(ds->cut & (SC_LINKDRAW|SC_SHADOW|SC_BBOX)))
+			tracers.push_back(ds);
 	}
 
-	dsnext->next = dsfirst;
-	dsfirst->prev = dsnext;
+	// Group the sprites a linkdraw can attach to by mobj, keeping their order within each mobj
+	auto bymobj = [](const vissprite_t* a, const vissprite_t* b) { return std::less<mobj_t*>()(a->mobj, b->mobj); };
+	std::stable_sort(tracers.begin(), tracers.end(), bymobj);
 
 	// bundle linkdraw
-	for (ds = unsorted.prev; ds != &unsorted; ds = ds->prev)
+	for (size_t j = sorted.size(); j-- > 0;)
 	{
+		ds = sorted[j];
+
 		if (!(ds->cut & SC_LINKDRAW))
 			continue;
 
 		if (ds->cut & SC_SHADOW)
 			continue;
 
-		// reuse dsfirst...
-		for (dsfirst = unsorted.prev; dsfirst != &unsorted; dsfirst = dsfirst->prev)
+		// Search the tracer's sprites last to first
+		dsfirst = NULL;
+		auto [first, last] = std::equal_range(tracers.begin(), tracers.end(), ds, bymobj);
+		while (last != first)
 		{
-			// don't connect if it's also a link
-			if (dsfirst->cut & SC_LINKDRAW)
-				continue;
-
-			// don't connect to your shadow!
-			if (dsfirst->cut & SC_SHADOW)
-				continue;
-
-			// don't connect to your bounding box!
-			if (dsfirst->cut & SC_BBOX)
-				continue;
-
-			// don't connect if it's not the tracer
-			if (dsfirst->mobj != ds->mobj)
-				continue;
+			vissprite_t *tracer = *--last;
 
 			// don't connect if the tracer's top is cut off, but lower than the link's top
-			if ((dsfirst->cut & SC_TOP)
-			&& dsfirst->szt > ds->szt)
+			if ((tracer->cut & SC_TOP)
+			&& tracer->szt > ds->szt)
 				continue;
 
 			// don't connect if the tracer's bottom is cut off, but higher than the link's bottom
-			if ((dsfirst->cut & SC_BOTTOM)
-			&& dsfirst->sz < ds->sz)
+			if ((tracer->cut & SC_BOTTOM)
+			&& tracer->sz < ds->sz)
 				continue;
 
+			dsfirst = tracer;
 			break;
 		}
 
-		// remove from chain
-		ds->next->prev = ds->prev;
-		ds->prev->next = ds->next;
-		count--;
+		// remove from the draw order; attached or discarded
+		sorted[j] = NULL;
 
-		if (dsfirst != &unsorted)
+		if (dsfirst)
 		{
 			ds->extra_colormap = dsfirst->extra_colormap;
 
-			// reusing dsnext...
 			dsnext = dsfirst->linkdraw;
 
 			if (!dsnext || ds->dispoffset < dsnext->dispoffset)
@@ -2999,33 +2987,25 @@ static void R_SortVisSprites(vissprite_t* vsprsortedhead, UINT32 start, UINT32 e
 		}
 	}
 
-	// pull the vissprites out by scale
+	sorted.erase(std::remove(sorted.begin(), sorted.end(), nullptr), sorted.end());
+
+	// order the vissprites by scale, then by dispoffset, smallest first. Being a stable sort,
+	// sprites that tie on both keep the order they were projected in.
+	std::stable_sort(sorted.begin(), sorted.end(), [](const vissprite_t* a, const vissprite_t* b)
+	{
+		if (a->sortscale != b->sortscale)
+			return a->sortscale < b->sortscale;
+		return a->dispoffset < b->dispoffset;
+	});
+
 	vsprsortedhead->next = vsprsortedhead->prev = vsprsortedhead;
-	for (i = 0; i < count; i++)
+	for (vissprite_t* best : sorted)
 	{
-		bestscale = bestdispoffset = INT32_MAX;
-		for (ds = unsorted.next; ds != &unsorted; ds = ds->next)
-		{
 #ifdef PARANOIA
-			if (ds->cut & SC_LINKDRAW)
-				I_Error("R_SortVisSprites: no link or discardal made for linkdraw!");
+		if (best->cut & SC_LINKDRAW)
+			I_Error("R_SortVisSprites: no link or discardal made for linkdraw!");
 #endif
 
-			if (ds->sortscale < bestscale)
-			{
-				bestscale = ds->sortscale;
-				bestdispoffset = ds->dispoffset;
-				best = ds;
-			}
-			// order visprites of same scale by dispoffset, smallest first
-			else if (ds->sortscale == bestscale && ds->dispoffset < bestdispoffset)
-			{
-				bestdispoffset = ds->dispoffset;
-				best = ds;
-			}
-		}
-		best->next->prev = best->prev;
-		best->prev->next = best->next;
 		best->next = vsprsortedhead;
 		best->prev = vsprsortedhead->prev;
 		vsprsortedhead->prev->next = best;
@@ -3966,7 +3946,7 @@ static void R_DrawMaskedList (drawnode_t* head)
 	}
 }
 
-void R_DrawMasked(maskcount_t* masks, INT32 nummasks)
+drawnode_t *R_CreateMaskedLists(maskcount_t* masks, INT32 nummasks)
 {
 	ZoneScoped;
 	drawnode_t *heads;	/**< Drawnode lists; as many as number of views/portals. */
@@ -3986,6 +3966,13 @@ void R_DrawMasked(maskcount_t* masks, INT32 nummasks)
 		R_CreateDrawNodes(&masks[i], &heads[i], false);
 	}
 
+	return heads;
+}
+
+void R_DrawMaskedLists(drawnode_t *heads, maskcount_t* masks, INT32 nummasks)
+{
+	ZoneScoped;
+
 	//for (i = 0; i < nummasks; i++)
 	//	CONS_Printf("Mask no.%d:\ndrawsegs: %d\n vissprites: %d\n\n", i, masks[i].drawsegs[1] - masks[i].drawsegs[0], masks[i].vissprites[1] - masks[i].vissprites[0]);
 
@@ -115,7 +115,10 @@ struct maskcount_t
 	sector_t* viewsector;
 };
 
-void R_DrawMasked(maskcount_t* masks, INT32 nummasks);
+// Masked drawing in two steps. Creating and sorting the drawnode lists
+// doesn't touch the screen, so it may overlap with plane drawing jobs.
+drawnode_t *R_CreateMaskedLists(maskcount_t* masks, INT32 nummasks);
+void R_DrawMaskedLists(drawnode_t *heads, maskcount_t* masks, INT32 nummasks);
 
 // ----------
 // VISSPRITES
@@ -0,0 +1,600 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "null_rhi.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+using namespace srb2;
+using namespace rhi;
+
+namespace
+{
+
+constexpr uint32_t texture_format_size(rhi::TextureFormat format)
+{
+	switch (format)
+	{
+	case rhi::TextureFormat::kLuminance:
+		return 1;
+	case rhi::TextureFormat::kLuminanceAlpha:
+		return 2;
+	case rhi::TextureFormat::kRGB:
+		return 3;
+	case rhi::TextureFormat::kRGBA:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+constexpr uint32_t pixel_format_size(rhi::PixelFormat format)
+{
+	switch (format)
+	{
+	case rhi::PixelFormat::kR8:
+		return 1;
+	case rhi::PixelFormat::kRG8:
+		return 2;
+	case rhi::PixelFormat::kRGB8:
+		return 3;
+	case rhi::PixelFormat::kRGBA8:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+// Matches the format check of the GL backends, so misuse fails here too
+constexpr bool pixel_format_matches(rhi::PixelFormat data_format, rhi::TextureFormat format)
+{
+	return pixel_format_size(data_format) == texture_format_size(format);
+}
+
+constexpr uint64_t texture_bytes(const rhi::TextureDesc& desc)
+{
+	return static_cast<uint64_t>(desc.width) * desc.height * texture_format_size(desc.format);
+}
+
+} // namespace
+
+NullPlatform::~NullPlatform() = default;
+
+NullRhiStats& NullRhiStats::operator+=(const NullRhiStats& rhs) noexcept
+{
+	draw_calls += rhs.draw_calls;
+	vertices += rhs.vertices;
+	render_passes += rhs.render_passes;
+	pipeline_binds += rhs.pipeline_binds;
+	uniform_sets += rhs.uniform_sets;
+	binding_sets += rhs.binding_sets;
+	buffer_uploads += rhs.buffer_uploads;
+	buffer_upload_bytes += rhs.buffer_upload_bytes;
+	texture_uploads += rhs.texture_uploads;
+	texture_upload_bytes += rhs.texture_upload_bytes;
+	framebuffer_copies += rhs.framebuffer_copies;
+	readback_bytes += rhs.readback_bytes;
+	resources_created += rhs.resources_created;
+	resources_destroyed += rhs.resources_destroyed;
+	return *this;
+}
+
+NullRhi::NullRhi(std::unique_ptr<NullPlatform>&& platform) : platform_(std::move(platform))
+{
+}
+
+NullRhi::~NullRhi() = default;
+
+void NullRhi::assert_context(Handle<GraphicsContext> ctx) const
+{
+	SRB2_ASSERT(graphics_context_active_ == true && graphics_context_generation_ == ctx.generation());
+}
+
+void NullRhi::record(NullRhiCommandType type, uint32_t count)
+{
+	if (recording_)
+	{
+		commands_.push_back({type, count});
+	}
+}
+
+void NullRhi::resource_created()
+{
+	frame_stats_.resources_created += 1;
+
+	peak_.textures = std::max(peak_.textures, live_.textures);
+	peak_.buffers = std::max(peak_.buffers, live_.buffers);
+	peak_.renderbuffers = std::max(peak_.renderbuffers, live_.renderbuffers);
+	peak_.pipelines = std::max(peak_.pipelines, live_.pipelines);
+	peak_.render_passes = std::max(peak_.render_passes, live_.render_passes);
+	peak_.texture_bytes = std::max(peak_.texture_bytes, live_.texture_bytes);
+	peak_.buffer_bytes = std::max(peak_.buffer_bytes, live_.buffer_bytes);
+}
+
+rhi::Handle<rhi::RenderPass> NullRhi::create_render_pass(const rhi::RenderPassDesc& desc)
+{
+	NullRenderPass pass;
+	pass.desc = desc;
+	live_.render_passes += 1;
+	resource_created();
+	return render_pass_slab_.insert(std::move(pass));
+}
+
+void NullRhi::destroy_render_pass(rhi::Handle<rhi::RenderPass> handle)
+{
+	SRB2_ASSERT(render_pass_slab_.is_valid(handle) == true);
+	render_pass_slab_.remove(handle);
+	live_.render_passes -= 1;
+	frame_stats_.resources_destroyed += 1;
+}
+
+rhi::Handle<rhi::Pipeline> NullRhi::create_pipeline(const PipelineDesc& desc)
+{
+	NullPipeline pipeline;
+	pipeline.desc = desc;
+	live_.pipelines += 1;
+	resource_created();
+	return pipeline_slab_.insert(std::move(pipeline));
+}
+
+void NullRhi::destroy_pipeline(rhi::Handle<rhi::Pipeline> handle)
+{
+	SRB2_ASSERT(pipeline_slab_.is_valid(handle) == true);
+	pipeline_slab_.remove(handle);
+	live_.pipelines -= 1;
+	frame_stats_.resources_destroyed += 1;
+}
+
+rhi::Handle<rhi::Texture> NullRhi::create_texture(const rhi::TextureDesc& desc)
+{
+	SRB2_ASSERT(texture_format_size(desc.format) != 0);
+
+	NullTexture texture;
+	texture.desc = desc;
+	live_.textures += 1;
+	live_.texture_bytes += texture_bytes(desc);
+	resource_created();
+	return texture_slab_.insert(std::move(texture));
+}
+
+void NullRhi::destroy_texture(rhi::Handle<rhi::Texture> handle)
+{
+	SRB2_ASSERT(texture_slab_.is_valid(handle) == true);
+	NullTexture casted = texture_slab_.remove(handle);
+	live_.textures -= 1;
+	live_.texture_bytes -= texture_bytes(casted.desc);
+	frame_stats_.resources_destroyed += 1;
+}
+
+rhi::Handle<rhi::Buffer> NullRhi::create_buffer(const rhi::BufferDesc& desc)
+{
+	NullBuffer buffer;
+	buffer.desc = desc;
+	live_.buffers += 1;
+	live_.buffer_bytes += desc.size;
+	resource_created();
+	return buffer_slab_.insert(std::move(buffer));
+}
+
+void NullRhi::destroy_buffer(rhi::Handle<rhi::Buffer> handle)
+{
+	SRB2_ASSERT(buffer_slab_.is_valid(handle) == true);
+	NullBuffer casted = buffer_slab_.remove(handle);
+	live_.buffers -= 1;
+	live_.buffer_bytes -= casted.desc.size;
+	frame_stats_.resources_destroyed += 1;
+}
+
+rhi::Handle<rhi::Renderbuffer> NullRhi::create_renderbuffer(const rhi::RenderbufferDesc& desc)
+{
+	NullRenderbuffer renderbuffer;
+	renderbuffer.desc = desc;
+	live_.renderbuffers += 1;
+	resource_created();
+	return renderbuffer_slab_.insert(std::move(renderbuffer));
+}
+
+void NullRhi::destroy_renderbuffer(rhi::Handle<rhi::Renderbuffer> handle)
+{
+	SRB2_ASSERT(renderbuffer_slab_.is_valid(handle) == true);
+	renderbuffer_slab_.remove(handle);
+	live_.renderbuffers -= 1;
+	frame_stats_.resources_destroyed += 1;
+}
+
+rhi::TextureDetails NullRhi::get_texture_details(rhi::Handle<rhi::Texture> texture)
+{
+	SRB2_ASSERT(texture_slab_.is_valid(texture));
+	auto& t = texture_slab_[texture];
+
+	return {t.desc.width, t.desc.height, t.desc.format};
+}
+
+rhi::Rect NullRhi::get_renderbuffer_size(rhi::Handle<rhi::Renderbuffer> renderbuffer)
+{
+	SRB2_ASSERT(renderbuffer_slab_.is_valid(renderbuffer));
+	auto& rb = renderbuffer_slab_[renderbuffer];
+
+	return {0, 0, rb.desc.width, rb.desc.height};
+}
+
+uint32_t NullRhi::get_buffer_size(rhi::Handle<rhi::Buffer> buffer)
+{
+	SRB2_ASSERT(buffer_slab_.is_valid(buffer));
+	auto& buf = buffer_slab_[buffer];
+
+	return buf.desc.size;
+}
+
+void NullRhi::update_buffer(
+	rhi::Handle<GraphicsContext> ctx,
+	rhi::Handle<rhi::Buffer> handle,
+	uint32_t offset,
+	tcb::span<const std::byte> data
+)
+{
+	assert_context(ctx);
+
+	if (data.empty())
+	{
+		return;
+	}
+
+	SRB2_ASSERT(buffer_slab_.is_valid(handle) == true);
+	auto& b = buffer_slab_[handle];
+
+	SRB2_ASSERT(offset < b.desc.size && offset + data.size() <= b.desc.size);
+
+	frame_stats_.buffer_uploads += 1;
+	frame_stats_.buffer_upload_bytes += data.size();
+	record(NullRhiCommandType::kUpdateBuffer, data.size());
+}
+
+void NullRhi::update_texture(
+	Handle<GraphicsContext> ctx,
+	Handle<Texture> texture,
+	Rect region,
+	srb2::rhi::PixelFormat data_format,
+	tcb::span<const std::byte> data
+)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+
+	if (data.empty())
+	{
+		return;
+	}
+
+	SRB2_ASSERT(texture_slab_.is_valid(texture) == true);
+	auto& t = texture_slab_[texture];
+
+	const uint32_t size = pixel_format_size(data_format);
+	SRB2_ASSERT(size != 0);
+	SRB2_ASSERT(pixel_format_matches(data_format, t.desc.format));
+
+	const std::size_t expected_row_span =
+		(((size * region.w) + kPixelRowUnpackAlignment - 1) / kPixelRowUnpackAlignment) * kPixelRowUnpackAlignment;
+	SRB2_ASSERT(expected_row_span * region.h == data.size_bytes());
+	SRB2_ASSERT(region.x + region.w <= t.desc.width && region.y + region.h <= t.desc.height);
+
+	frame_stats_.texture_uploads += 1;
+	frame_stats_.texture_upload_bytes += data.size_bytes();
+	record(NullRhiCommandType::kUpdateTexture, data.size_bytes());
+}
+
+void NullRhi::update_texture_settings(
+	Handle<GraphicsContext> ctx,
+	Handle<Texture> texture,
+	TextureWrapMode u_wrap,
+	TextureWrapMode v_wrap,
+	TextureFilterMode min,
+	TextureFilterMode mag
+)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+
+	SRB2_ASSERT(texture_slab_.is_valid(texture) == true);
+	auto& t = texture_slab_[texture];
+
+	t.desc.u_wrap = u_wrap;
+	t.desc.v_wrap = v_wrap;
+	t.desc.min = min;
+	t.desc.mag = mag;
+}
+
+rhi::Handle<rhi::UniformSet>
+NullRhi::create_uniform_set(rhi::Handle<rhi::GraphicsContext> ctx, const rhi::CreateUniformSetInfo& info)
+{
+	assert_context(ctx);
+
+	frame_stats_.uniform_sets += 1;
+	return uniform_set_slab_.insert(NullUniformSet {});
+}
+
+rhi::Handle<rhi::BindingSet> NullRhi::create_binding_set(
+	rhi::Handle<rhi::GraphicsContext> ctx,
+	Handle<Pipeline> pipeline,
+	const rhi::CreateBindingSetInfo& info
+)
+{
+	assert_context(ctx);
+
+	SRB2_ASSERT(pipeline_slab_.is_valid(pipeline) == true);
+	auto& pl = pipeline_slab_[pipeline];
+
+	SRB2_ASSERT(info.vertex_buffers.size() == pl.desc.vertex_input.buffer_layouts.size());
+
+	for (auto& vertex_buffer : info.vertex_buffers)
+	{
+		SRB2_ASSERT(buffer_slab_.is_valid(vertex_buffer.vertex_buffer));
+		SRB2_ASSERT(buffer_slab_[vertex_buffer.vertex_buffer].desc.type == rhi::BufferType::kVertexBuffer);
+	}
+
+	for (size_t i = 0; i < info.sampler_textures.size(); i++)
+	{
+		auto& binding = info.sampler_textures[i];
+		SRB2_ASSERT(binding.name == pl.desc.sampler_input.enabled_samplers[i]);
+		SRB2_ASSERT(texture_slab_.is_valid(binding.texture));
+	}
+
+	NullBindingSet binding_set;
+	binding_set.pipeline = pipeline;
+
+	frame_stats_.binding_sets += 1;
+	return binding_set_slab_.insert(std::move(binding_set));
+}
+
+rhi::Handle<rhi::GraphicsContext> NullRhi::begin_graphics()
+{
+	SRB2_ASSERT(graphics_context_active_ == false);
+	graphics_context_active_ = true;
+	return rhi::Handle<rhi::GraphicsContext>(0, graphics_context_generation_);
+}
+
+void NullRhi::end_graphics(rhi::Handle<rhi::GraphicsContext> handle)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(current_pipeline_.has_value() == false && current_render_pass_.has_value() == false);
+	graphics_context_generation_ += 1;
+	if (graphics_context_generation_ == 0)
+	{
+		graphics_context_generation_ = 1;
+	}
+	graphics_context_active_ = false;
+}
+
+void NullRhi::begin_default_render_pass(Handle<GraphicsContext> ctx, bool clear)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(current_render_pass_.has_value() == false);
+
+	current_render_pass_ = NullRhi::DefaultRenderPassState {};
+	frame_stats_.render_passes += 1;
+	record(NullRhiCommandType::kBeginRenderPass);
+}
+
+void NullRhi::begin_render_pass(Handle<GraphicsContext> ctx, const RenderPassBeginInfo& info)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(current_render_pass_.has_value() == false);
+
+	SRB2_ASSERT(render_pass_slab_.is_valid(info.render_pass) == true);
+	auto& rp = render_pass_slab_[info.render_pass];
+	SRB2_ASSERT(rp.desc.use_depth_stencil == info.depth_stencil_attachment.has_value());
+
+	SRB2_ASSERT(texture_slab_.is_valid(info.color_attachment));
+	SRB2_ASSERT(texture_slab_[info.color_attachment].desc.format == TextureFormat::kRGBA);
+
+	if (info.depth_stencil_attachment)
+	{
+		SRB2_ASSERT(renderbuffer_slab_.is_valid(*info.depth_stencil_attachment));
+	}
+
+	current_render_pass_ = info;
+	frame_stats_.render_passes += 1;
+	record(NullRhiCommandType::kBeginRenderPass);
+}
+
+void NullRhi::end_render_pass(Handle<GraphicsContext> ctx)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(current_render_pass_.has_value() == true);
+
+	current_pipeline_ = std::nullopt;
+	current_render_pass_ = std::nullopt;
+	record(NullRhiCommandType::kEndRenderPass);
+}
+
+void NullRhi::bind_pipeline(Handle<GraphicsContext> ctx, Handle<Pipeline> pipeline)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(current_render_pass_.has_value() == true);
+	SRB2_ASSERT(pipeline_slab_.is_valid(pipeline) == true);
+
+	current_pipeline_ = pipeline;
+	frame_stats_.pipeline_binds += 1;
+	record(NullRhiCommandType::kBindPipeline);
+}
+
+void NullRhi::bind_uniform_set(Handle<GraphicsContext> ctx, uint32_t slot, Handle<UniformSet> set)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(current_render_pass_.has_value() == true && current_pipeline_.has_value() == true);
+
+	SRB2_ASSERT(pipeline_slab_.is_valid(*current_pipeline_));
+	auto& pl = pipeline_slab_[*current_pipeline_];
+
+	SRB2_ASSERT(uniform_set_slab_.is_valid(set));
+	SRB2_ASSERT(slot < pl.desc.uniform_input.enabled_uniforms.size());
+
+	record(NullRhiCommandType::kBindUniformSet);
+}
+
+void NullRhi::bind_binding_set(Handle<GraphicsContext> ctx, Handle<BindingSet> set)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(current_render_pass_.has_value() == true && current_pipeline_.has_value() == true);
+
+	SRB2_ASSERT(binding_set_slab_.is_valid(set));
+	SRB2_ASSERT(binding_set_slab_[set].pipeline == *current_pipeline_);
+
+	record(NullRhiCommandType::kBindBindingSet);
+}
+
+void NullRhi::bind_index_buffer(Handle<GraphicsContext> ctx, Handle<Buffer> buffer)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(current_render_pass_.has_value() == true && current_pipeline_.has_value() == true);
+
+	SRB2_ASSERT(buffer_slab_.is_valid(buffer));
+	SRB2_ASSERT(buffer_slab_[buffer].desc.type == rhi::BufferType::kIndexBuffer);
+
+	current_index_buffer_ = buffer;
+	record(NullRhiCommandType::kBindIndexBuffer);
+}
+
+void NullRhi::set_scissor(Handle<GraphicsContext> ctx, const Rect& rect)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(current_render_pass_.has_value() == true && current_pipeline_.has_value() == true);
+
+	record(NullRhiCommandType::kSetScissor);
+}
+
+void NullRhi::set_viewport(Handle<GraphicsContext> ctx, const Rect& rect)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(current_render_pass_.has_value() == true && current_pipeline_.has_value() == true);
+
+	record(NullRhiCommandType::kSetViewport);
+}
+
+void NullRhi::draw(Handle<GraphicsContext> ctx, uint32_t vertex_count, uint32_t first_vertex)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(current_render_pass_.has_value() == true && current_pipeline_.has_value() == true);
+
+	frame_stats_.draw_calls += 1;
+	frame_stats_.vertices += vertex_count;
+	record(NullRhiCommandType::kDraw, vertex_count);
+}
+
+void NullRhi::draw_indexed(Handle<GraphicsContext> ctx, uint32_t index_count, uint32_t first_index)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(current_render_pass_.has_value() == true && current_pipeline_.has_value() == true);
+
+	SRB2_ASSERT(current_index_buffer_ != kNullHandle);
+	SRB2_ASSERT(buffer_slab_.is_valid(current_index_buffer_));
+	SRB2_ASSERT((index_count + first_index) * 2 <= buffer_slab_[current_index_buffer_].desc.size);
+
+	frame_stats_.draw_calls += 1;
+	frame_stats_.vertices += index_count;
+	record(NullRhiCommandType::kDrawIndexed, index_count);
+}
+
+void NullRhi::read_pixels(Handle<GraphicsContext> ctx, const Rect& rect, PixelFormat format, tcb::span<std::byte> out)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(current_render_pass_.has_value());
+
+	const uint32_t size = pixel_format_size(format);
+	SRB2_ASSERT(size != 0);
+
+	const std::size_t expected_row_span =
+		(((size * rect.w) + kPixelRowPackAlignment - 1) / kPixelRowPackAlignment) * kPixelRowPackAlignment;
+	SRB2_ASSERT(out.size() >= expected_row_span * rect.h);
+
+	// Nothing was drawn; read back black so captures stay deterministic
+	std::fill(out.begin(), out.end(), std::byte {0});
+
+	frame_stats_.readback_bytes += out.size();
+	record(NullRhiCommandType::kReadPixels, out.size());
+}
+
+void NullRhi::copy_framebuffer_to_texture(
+	Handle<GraphicsContext> ctx,
+	Handle<Texture> dst_tex,
+	const Rect& dst_region,
+	const Rect& src_region
+)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(current_render_pass_.has_value());
+	SRB2_ASSERT(texture_slab_.is_valid(dst_tex));
+
+	auto& tex = texture_slab_[dst_tex];
+	SRB2_ASSERT(dst_region.w == src_region.w);
+	SRB2_ASSERT(dst_region.h == src_region.h);
+	SRB2_ASSERT(dst_region.x >= 0);
+	SRB2_ASSERT(dst_region.y >= 0);
+	SRB2_ASSERT(dst_region.x + dst_region.w <= tex.desc.width);
+	SRB2_ASSERT(dst_region.y + dst_region.h <= tex.desc.height);
+
+	Rect src_dim;
+	auto render_pass_visitor = srb2::Overload {
+		[&](const DefaultRenderPassState& state) {
+			SRB2_ASSERT(platform_ != nullptr);
+			src_dim = platform_->get_default_framebuffer_dimensions();
+		},
+		[&](const RenderPassBeginInfo& state) {
+			SRB2_ASSERT(texture_slab_.is_valid(state.color_attachment));
+			auto& attach_tex = texture_slab_[state.color_attachment];
+			src_dim = {0, 0, attach_tex.desc.width, attach_tex.desc.height};
+		}
+	};
+	std::visit(render_pass_visitor, *current_render_pass_);
+
+	SRB2_ASSERT(src_region.x >= 0);
+	SRB2_ASSERT(src_region.y >= 0);
+	SRB2_ASSERT(src_region.x + src_region.w <= src_dim.w);
+	SRB2_ASSERT(src_region.y + src_region.h <= src_dim.h);
+
+	frame_stats_.framebuffer_copies += 1;
+	record(NullRhiCommandType::kCopyFramebufferToTexture, dst_region.w * dst_region.h * texture_format_size(tex.desc.format));
+}
+
+void NullRhi::set_stencil_reference(Handle<GraphicsContext> ctx, CullMode face, uint8_t reference)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(face != CullMode::kNone);
+}
+
+void NullRhi::set_stencil_compare_mask(Handle<GraphicsContext> ctx, CullMode face, uint8_t mask)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(face != CullMode::kNone);
+}
+
+void NullRhi::set_stencil_write_mask(Handle<GraphicsContext> ctx, CullMode face, uint8_t mask)
+{
+	assert_context(ctx);
+	SRB2_ASSERT(face != CullMode::kNone);
+}
+
+void NullRhi::present()
+{
+	SRB2_ASSERT(graphics_context_active_ == false);
+
+	last_frame_stats_ = std::exchange(frame_stats_, {});
+	total_stats_ += last_frame_stats_;
+
+	last_frame_commands_.clear();
+	std::swap(last_frame_commands_, commands_);
+}
+
+void NullRhi::finish()
+{
+	SRB2_ASSERT(graphics_context_active_ == false);
+
+	binding_set_slab_.clear();
+	uniform_set_slab_.clear();
+}
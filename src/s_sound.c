@@ -106,6 +106,19 @@ void Captioning_OnChange(void)
 static channel_t *channels = NULL;
 static INT32 numofchannels = 0;
 
+// busy channels as a binary min-heap, least important (lowest priority,
+// then oldest) first, so a victim can be found without a scan
+static INT32 *channelheap = NULL;
+static INT32 channelheapsize = 0;
+static UINT32 channelstarts = 0;
+
+// per-channel scratch for S_UpdateSounds
+static INT32 *sourcechannel = NULL;
+static fixed_t *sourcex = NULL;
+static fixed_t *sourcey = NULL;
+static INT64 *sourcedist = NULL;
+static UINT8 *sourcelistener = NULL;
+
 caption_t closedcaptions[NUMCAPTIONS];
 
 void S_ResetCaptions(void)
@@ -125,6 +138,133 @@ void S_ResetCaptions(void)
 //
 static void S_StopChannel(INT32 cnum);
 
+static boolean S_ChannelBefore(INT32 a, INT32 b)
+{
+	const channel_t *ca = &channels[a];
+	const channel_t *cb = &channels[b];
+
+	if (ca->priority != cb->priority)
+		return (ca->priority < cb->priority);
+
+	return ((INT32)(ca->startnum - cb->startnum) < 0);
+}
+
+static void S_SetHeapSlot(INT32 slot, INT32 cnum)
+{
+	channelheap[slot] = cnum;
+	channels[cnum].heapslot = slot;
+}
+
+static void S_SiftChannelUp(INT32 slot)
+{
+	INT32 cnum = channelheap[slot];
+
+	while (slot > 0)
+	{
+		INT32 parent = (slot - 1) / 2;
+
+		if (!S_ChannelBefore(cnum, channelheap[parent]))
+			break;
+
+		S_SetHeapSlot(slot, channelheap[parent]);
+		slot = parent;
+	}
+
+	S_SetHeapSlot(slot, cnum);
+}
+
+static void S_SiftChannelDown(INT32 slot)
+{
+	INT32 cnum = channelheap[slot];
+
+	for (;;)
+	{
+		INT32 child = 2 * slot + 1;
+
+		if (child >= channelheapsize)
+			break;
+
+		if (child + 1 < channelheapsize && S_ChannelBefore(channelheap[child + 1], channelheap[child]))
+			child++;
+
+		if (!S_ChannelBefore(channelheap[child], cnum))
+			break;
+
+		S_SetHeapSlot(slot, channelheap[child]);
+		slot = child;
+	}
+
+	S_SetHeapSlot(slot, cnum);
+}
+
+static void S_InsertChannel(INT32 cnum)
+{
+	channels[cnum].priority = channels[cnum].sfxinfo->priority;
+	channels[cnum].startnum = channelstarts++;
+
+	S_SetHeapSlot(channelheapsize++, cnum);
+	S_SiftChannelUp(channelheapsize - 1);
+}
+
+static void S_RemoveChannel(INT32 cnum)
+{
+	INT32 slot = channels[cnum].heapslot;
+	INT32 last = channelheap[--channelheapsize];
+
+	if (last == cnum)
+		return;
+
+	S_SetHeapSlot(slot, last);
+
+	if (slot > 0 && S_ChannelBefore(last, channelheap[(slot - 1) / 2]))
+		S_SiftChannelUp(slot);
+	else
+		S_SiftChannelDown(slot);
+}
+
+//
+// S_FindNearestListeners
+//
+// For each of count sources, picks the closest listener in 2D (0 if there
+// are none). Listeners go on the outside so the inner loop is a straight
+// run over the source arrays for each of them.
+//
+static void S_FindNearestListeners(const listener_t *listener, mobj_t *const *listenmobj,
+	const fixed_t *x, const fixed_t *y, INT64 *dist, UINT8 *nearest, INT32 count)
+{
+	INT32 i;
+	UINT8 j;
+
+	for (i = 0; i < count; i++)
+	{
+		dist[i] = INT64_MAX;
+		nearest[i] = 0;
+	}
+
+	for (j = 0; j <= r_splitscreen; j++)
+	{
+		// Squared, at half precision so it can't overflow
+		const INT64 lx = listener[j].x >> (FRACBITS/2);
+		const INT64 ly = listener[j].y >> (FRACBITS/2);
+
+		if (!listenmobj[j])
+			continue;
+
+		for (i = 0; i < count; i++)
+		{
+			const INT64 dx = lx - (x[i] >> (FRACBITS/2));
+			const INT64 dy = ly - (y[i] >> (FRACBITS/2));
+			const INT64 d = dx*dx + dy*dy;
+
+			if (d < dist[i])
+			{
+				dist[i] = d;
+				nearest[i] = j;
+			}
+		}
+	}
+}
+
 //
 // S_getChannel
 //
@@ -173,20 +313,15 @@ static INT32 S_getChannel(const void *origin, sfxinfo_t *sfxinfo)
 	if (cnum == numofchannels)
 	{
 		// Look for lower priority
-		for (cnum = 0; cnum < numofchannels; cnum++)
-			if (channels[cnum].sfxinfo->priority <= sfxinfo->priority)
-				break;
-
-		if (cnum == numofchannels)
+		if (channelheapsize == 0 || channels[channelheap[0]].priority > sfxinfo->priority)
 		{
 			// No lower priority. Sorry, Charlie.
 			return -1;
 		}
-		else
-		{
-			// Otherwise, kick out lower priority.
-			S_StopChannel(cnum);
-		}
+
+		// Otherwise, kick out the lowest.
+		cnum = channelheap[0];
+		S_StopChannel(cnum);
 	}
 
 	return cnum;
@@ -227,6 +362,15 @@ void SetChannelsNum(void)
 		channels = (channel_t *)Z_Calloc(cv_numChannels.value * sizeof (channel_t), PU_STATIC, NULL);
 	numofchannels = (channels ? cv_numChannels.value : 0);
 
+	channelheap = Z_Realloc(channelheap, numofchannels * sizeof (*channelheap), PU_STATIC, NULL);
+	channelheapsize = 0;
+
+	sourcechannel = Z_Realloc(sourcechannel, numofchannels * sizeof (*sourcechannel), PU_STATIC, NULL);
+	sourcex = Z_Realloc(sourcex, numofchannels * sizeof (*sourcex), PU_STATIC, NULL);
+	sourcey = Z_Realloc(sourcey, numofchannels * sizeof (*sourcey), PU_STATIC, NULL);
+	sourcedist = Z_Realloc(sourcedist, numofchannels * sizeof (*sourcedist), PU_STATIC, NULL);
+	sourcelistener = Z_Realloc(sourcelistener, numofchannels * sizeof (*sourcelistener), PU_STATIC, NULL);
+
 	S_ResetCaptions();
 }
 
@@ -530,32 +674,11 @@ void S_StartSoundAtVolume(const void *origin_p, sfxenum_t sfx_id, INT32 volume)
 		if (origin && !itsUs)
 		{
 			boolean audible = false;
+			INT64 dist;
+			UINT8 nearest;
 
-			if (r_splitscreen > 0)
-			{
-				fixed_t recdist = INT32_MAX;
-				UINT8 j = 0;
-
-				for (; j <= r_splitscreen; j++)
-				{
-					fixed_t thisdist = INT32_MAX;
-
-					if (!listenmobj[j])
-					{
-						continue;
-					}
-
-					thisdist = P_AproxDistance(listener[j].x - origin->x, listener[j].y - origin->y);
-
-					if (thisdist >= recdist)
-					{
-						continue;
-					}
-
-					recdist = thisdist;
-					i = j;
-				}
-			}
+			S_FindNearestListeners(listener, listenmobj, &origin->x, &origin->y, &dist, &nearest, 1);
+			i = nearest;
 
 			if (listenmobj[i])
 			{
@@ -619,6 +742,7 @@ void S_StartSoundAtVolume(const void *origin_p, sfxenum_t sfx_id, INT32 volume)
 		channels[cnum].origin = origin;
 		channels[cnum].volume = initial_volume;
 		channels[cnum].handle = I_StartSound(sfx_id, S_GetSoundVolume(sfx, volume), sep, pitch, priority, cnum);
+		S_InsertChannel(cnum);
 	}
 }
 
@@ -680,9 +804,8 @@ static INT32 actualmastervolume;
 void S_UpdateSounds(void)
 {
 	INT32 cnum, volume, sep, pitch;
-	boolean audible = false;
 	channel_t *c;
-	INT32 i;
+	INT32 i, k, count;
 
 	listener_t listener[MAXSPLITSCREENPLAYERS];
 	mobj_t *listenmobj[MAXSPLITSCREENPLAYERS];
@@ -760,93 +883,83 @@ void S_UpdateSounds(void)
 		}
 	}
 
+	// Gather the channels that need spatializing, so every listener can be
+	// measured against all of them in one pass.
+	count = 0;
+
 	for (cnum = 0; cnum < numofchannels; cnum++)
 	{
-		c = &channels[cnum];
+		boolean itsUs = false;
 
-		if (c->sfxinfo)
-		{
-			if (I_SoundIsPlaying(c->handle))
-			{
-				// initialize parameters
-				volume = c->volume; // 8 bits internal volume precision
-				pitch = NORM_PITCH;
-				sep = NORM_SEP;
-
-				// check non-local sounds for distance clipping
-				//  or modify their params
-				if (c->origin)
-				{
-					boolean itsUs = false;
+		c = &channels[cnum];
 
-					for (i = r_splitscreen; i >= 0; i--)
-					{
-						if (camera[i].freecam)
-							continue;
+		if (!c->sfxinfo)
+			continue;
 
-						if (c->origin != listenmobj[i])
-							continue;
+		if (!I_SoundIsPlaying(c->handle))
+		{
+			// if channel is allocated but sound has stopped, free it
+			S_StopChannel(cnum);
+			continue;
+		}
 
-						if (listenmobj[i]->player && listenmobj[i]->player->exiting)
-							continue;
+		// local sounds don't get distance clipping
+		if (!c->origin)
+			continue;
 
-						itsUs = true;
-					}
+		for (i = r_splitscreen; i >= 0; i--)
+		{
+			if (camera[i].freecam)
+				continue;
 
-					if (itsUs == false)
-					{
-						const mobj_t *origin = c->origin;
+			if (c->origin != listenmobj[i])
+				continue;
 
-						i = 0;
+			if (listenmobj[i]->player && listenmobj[i]->player->exiting)
+				continue;
 
-						if (r_splitscreen > 0)
-						{
-							fixed_t recdist = INT32_MAX;
-							UINT8 j = 0;
+			itsUs = true;
+		}
 
-							for (; j <= r_splitscreen; j++)
-							{
-								fixed_t thisdist = INT32_MAX;
+		if (itsUs)
+			continue;
 
-								if (!listenmobj[j])
-								{
-									continue;
-								}
+		sourcechannel[count] = cnum;
+		sourcex[count] = ((const mobj_t *)c->origin)->x;
+		sourcey[count] = ((const mobj_t *)c->origin)->y;
+		count++;
+	}
 
-								thisdist = P_AproxDistance(listener[j].x - origin->x, listener[j].y - origin->y);
+	S_FindNearestListeners(listener, listenmobj, sourcex, sourcey, sourcedist, sourcelistener, count);
 
-								if (thisdist >= recdist)
-								{
-									continue;
-								}
+	for (k = 0; k < count; k++)
+	{
+		boolean audible = false;
 
-								recdist = thisdist;
-								i = j;
-							}
-						}
+		cnum = sourcechannel[k];
+		c = &channels[cnum];
+		i = sourcelistener[k];
 
-						if (listenmobj[i])
-						{
-							audible = S_AdjustSoundParams(
-								listenmobj[i], c->origin,
-								&volume, &sep, &pitch,
-								c->sfxinfo
-							);
-						}
+		// initialize parameters
+		volume = c->volume; // 8 bits internal volume precision
+		pitch = NORM_PITCH;
+		sep = NORM_SEP;
 
-						if (audible)
-							I_UpdateSoundParams(c->handle, S_GetSoundVolume(c->sfxinfo, volume), sep, pitch);
-						else
-							S_StopChannel(cnum);
-					}
-				}
-			}
-			else
-			{
-				// if channel is allocated but sound has stopped, free it
-				S_StopChannel(cnum);
-			}
+		// check non-local sounds for distance clipping
+		//  or modify their params
+		if (listenmobj[i])
+		{
+			audible = S_AdjustSoundParams(
+				listenmobj[i], c->origin,
+				&volume, &sep, &pitch,
+				c->sfxinfo
+			);
 		}
+
+		if (audible)
+			I_UpdateSoundParams(c->handle, S_GetSoundVolume(c->sfxinfo, volume), sep, pitch);
+		else
+			S_StopChannel(cnum);
 	}
 
 notinlevel:
@@ -914,6 +1027,8 @@ static void S_StopChannel(INT32 cnum)
 		// degrade usefulness of sound data
 		c->sfxinfo->usefulness--;
 		c->sfxinfo = 0;
+
+		S_RemoveChannel(cnum);
 	}
 
 	c->origin = NULL;
@@ -1000,10 +1115,30 @@ boolean S_AdjustSoundParams(const mobj_t *listener, const mobj_t *source, INT32
 
 	if (sfxinfo->pitch & SF_OUTSIDESOUND) // Rain special case
 	{
+		// The search below doesn't depend on the source, so every rain
+		// channel heard by one listener in one tic shares the result.
+		static struct
+		{
+			fixed_t x, y;
+			tic_t time;
+			INT16 map;
+			fixed_t dist;
+		} outsidecache[MAXSPLITSCREENPLAYERS];
+		static UINT8 outsidenext = 0;
+
 		INT64 x, y, yl, yh, xl, xh;
 		fixed_t newdist;
 
-		if (R_PointInSubsector(listensource.x, listensource.y)->sector->ceilingpic == skyflatnum)
+		for (i = 0; i < MAXSPLITSCREENPLAYERS; i++)
+		{
+			if (outsidecache[i].x == listensource.x && outsidecache[i].y == listensource.y
+				&& outsidecache[i].time == leveltime && outsidecache[i].map == gamemap)
+				break;
+		}
+
+		if (i < MAXSPLITSCREENPLAYERS)
+			approx_dist = outsidecache[i].dist;
+		else if (R_PointInSubsector(listensource.x, listensource.y)->sector->ceilingpic == skyflatnum)
 			approx_dist = 0;
 		else
 		{
@@ -1027,6 +1162,16 @@ boolean S_AdjustSoundParams(const mobj_t *listener, const mobj_t *source, INT32
 					}
 				}
 		}
+
+		if (i == MAXSPLITSCREENPLAYERS)
+		{
+			outsidecache[outsidenext].x = listensource.x;
+			outsidecache[outsidenext].y = listensource.y;
+			outsidecache[outsidenext].time = leveltime;
+			outsidecache[outsidenext].map = gamemap;
+			outsidecache[outsidenext].dist = approx_dist;
+			outsidenext = (outsidenext + 1) % MAXSPLITSCREENPLAYERS;
+		}
 	}
 	else
 	{
@@ -1206,12 +1351,52 @@ void S_InitSfxChannels(void)
 		// Initialize external data (all sounds) at start, keep static.
 		CONS_Printf(M_GetText("Loading sounds... "));
 
-		for (i = 1; i < NUMSFX; i++)
-			if (S_sfx[i].name)
-				S_sfx[i].data = I_GetSfx(&S_sfx[i]);
+		S_PrecacheSounds(UINT16_MAX);
 
 		CONS_Printf(M_GetText(" pre-cached all sound data\n"));
 	}
+	else
+	{
+		// Addons loaded from the command line
+		for (i = mainwads; i < numwadfiles; i++)
+			S_PrecacheSounds((UINT16)i);
+	}
+}
+
+//
+// Decodes every sound that isn't loaded yet and comes from wadnum
+// (UINT16_MAX for any file), so the first play doesn't stall the game.
+//
+void S_PrecacheSounds(UINT16 wadnum)
+{
+	sfxinfo_t **batch;
+	size_t count = 0;
+	INT32 i;
+
+	if (dedicated || sound_disabled)
+		return;
+
+	batch = Z_Malloc(NUMSFX * sizeof(*batch), PU_STATIC, NULL);
+
+	for (i = 1; i < NUMSFX; i++)
+	{
+		sfxinfo_t *sfx = &S_sfx[i];
+
+		if (!sfx->name || sfx->data)
+			continue;
+
+		if (sfx->lumpnum == LUMPERROR)
+			sfx->lumpnum = S_GetSfxLumpNum(sfx);
+
+		if (wadnum != UINT16_MAX && WADFILENUM(sfx->lumpnum) != wadnum)
+			continue;
+
+		batch[count++] = sfx;
+	}
+
+	I_GetSfxBatch(batch, count);
+
+	Z_Free(batch);
 }
 
 /// ------------------------
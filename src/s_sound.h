@@ -77,6 +77,12 @@ struct channel_t
 	// handle of the sound being played
 	INT32 handle;
 
+	// priority it was started with, and when, for picking victims
+	INT32 priority;
+	UINT32 startnum;
+
+	// position in the priority heap while the channel is busy
+	INT32 heapslot;
 };
 
 struct caption_t {
@@ -103,6 +109,9 @@ void S_RegisterSoundStuff(void);
 //
 void S_InitSfxChannels(void);
 
+// Decodes the sounds provided by a file ahead of time. UINT16_MAX for all of them.
+void S_PrecacheSounds(UINT16 wadnum);
+
 //
 // Per level startup code.
 // Kills playing sounds at start of level, determines music if any, changes music.
@@ -22,6 +22,9 @@
 
 #include "../rhi/rhi.hpp"
 #include "../rhi/gl2/gl2_rhi.hpp"
+#include "../rhi/null/null_rhi.hpp"
+#include "../hwr2/hardware_state.hpp"
+#include "../hwr2/patch_atlas_test.hpp"
 #include "rhi_gl2_platform.hpp"
 
 #ifdef _MSC_VER
@@ -134,6 +137,7 @@ static       SDL_bool    mousegrabok = SDL_TRUE;
 static       SDL_bool    wrapmouseok = SDL_FALSE;
 static       SDL_bool    exposevideo = SDL_FALSE;
 static       SDL_bool    borderlesswindow = SDL_FALSE;
+static       SDL_bool    nullrhi = SDL_FALSE; // -nullrhi: draw nothing, no GL context
 
 // SDL2 vars
 SDL_Window   *window;
@@ -143,6 +147,23 @@ static const char *fallback_resolution_name = "Fallback";
 static std::unique_ptr<rhi::Rhi> g_rhi;
 static uint32_t g_rhi_generation = 0;
 
+namespace
+{
+
+struct SdlNullPlatform final : public rhi::NullPlatform
+{
+	virtual rhi::Rect get_default_framebuffer_dimensions() override
+	{
+		SRB2_ASSERT(window != nullptr);
+		int w;
+		int h;
+		SDL_GetWindowSize(window, &w, &h);
+		return {0, 0, static_cast<uint32_t>(w), static_cast<uint32_t>(h)};
+	}
+};
+
+} // namespace
+
 // windowed video modes from which to choose from.
 static INT32 windowedModes[MAXWINMODES][2] =
 {
@@ -404,6 +425,22 @@ static void VID_Command_Info_f (void)
 	SurfaceInfo(vidSurface, M_GetText("Current Video Mode"));
 }
 
+static void VID_Command_TestPatchAtlas_f(void)
+{
+	rhi::NullRhi test_rhi {std::make_unique<SdlNullPlatform>()};
+	const bool passed = hwr2::test_patch_atlas_address_reuse(test_rhi);
+
+	// The test took the freed patch list, so the screen's atlas can't trust its lookups anymore
+	rhi::Rhi* rhi = srb2::sys::get_rhi(srb2::sys::g_current_rhi);
+	hwr2::HardwareState* hw_state = srb2::sys::main_hardware_state();
+	if (rhi != nullptr && hw_state->patch_atlas_cache)
+	{
+		hw_state->patch_atlas_cache->reset(*rhi);
+	}
+
+	CONS_Printf("Patch atlas address reuse: %s\n", passed ? "passed" : "FAILED");
+}
+
 static void VID_Command_ModeList_f(void)
 {
 	// List windowed modes
@@ -1406,6 +1443,19 @@ static SDL_bool Impl_CreateContext(void)
 	}
 #endif
 
+	if (nullrhi)
+	{
+		init_imgui();
+
+		if (!g_rhi)
+		{
+			g_rhi = std::make_unique<rhi::NullRhi>(std::make_unique<SdlNullPlatform>());
+			g_rhi_generation += 1;
+		}
+
+		return SDL_TRUE;
+	}
+
 	// RHI always uses OpenGL 2.0 (for now)
 
 	if (!sdlglcontext)
@@ -1553,8 +1603,9 @@ static SDL_bool Impl_CreateWindow(SDL_bool fullscreen)
 	if (borderlesswindow)
 		flags |= SDL_WINDOW_BORDERLESS;
 
-	// RHI: always create window as OPENGL
-	flags |= SDL_WINDOW_OPENGL;
+	// RHI: always create window as OPENGL, unless nothing will be drawn
+	if (!nullrhi)
+		flags |= SDL_WINDOW_OPENGL;
 
 	// Create a window
 	window = SDL_CreateWindow("Dr. Robotnik's Ring Racers " VERSIONSTRING, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
@@ -1605,6 +1656,7 @@ void I_StartupGraphics(void)
 	COM_AddCommand ("vid_info", VID_Command_Info_f);
 	COM_AddCommand ("vid_modelist", VID_Command_ModeList_f);
 	COM_AddCommand ("vid_mode", VID_Command_Mode_f);
+	COM_AddDebugCommand("vid_testpatchatlas", VID_Command_TestPatchAtlas_f);
 	{
 		extern CVarList *cvlist_graphics_driver;
 		CV_RegisterList(cvlist_graphics_driver);
@@ -1659,6 +1711,14 @@ void I_StartupGraphics(void)
 	}
 #endif
 
+	// Null RHI backend, for profiling the hwr2 passes without a GPU.
+	// The legacy OpenGL renderer needs a real context, so it's software only.
+	if (M_CheckParm("-nullrhi"))
+	{
+		nullrhi = SDL_TRUE;
+		chosenrendermode = render_soft;
+	}
+
 	if (chosenrendermode != render_none)
 		rendermode = chosenrendermode;
 
@@ -9,19 +9,26 @@
 //-----------------------------------------------------------------------------
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <memory>
+#include <string>
+#include <utility>
 
 #include <SDL.h>
 #include <tracy/tracy/Tracy.hpp>
 
+#include "../audio/chunk_cache.hpp"
 #include "../audio/chunk_load.hpp"
 #include "../audio/gain.hpp"
+#include "../audio/kernels.hpp"
 #include "../audio/mixer.hpp"
 #include "../audio/music_player.hpp"
 #include "../audio/resample.hpp"
 #include "../audio/sound_chunk.hpp"
 #include "../audio/sound_effect_player.hpp"
+#include "../core/spsc_queue.hpp"
+#include "../core/thread_pool.h"
 #include "../cxxutil.hpp"
 #include "../io/streams.hpp"
 
@@ -29,8 +36,10 @@
 #include "../m_avrecorder.hpp"
 #endif
 
+#include "../d_main.h"
 #include "../doomdef.h"
 #include "../i_sound.h"
+#include "../m_argv.h"
 #include "../s_sound.h"
 #include "../sounds.h"
 #include "../w_wad.h"
@@ -74,6 +83,303 @@ static shared_ptr<srb2::media::AVRecorder> av_recorder;
 
 static void (*music_fade_callback)();
 
+// Game-side audio operations are not applied to the mixer graph directly.
+// They are queued here and consumed at the start of audio_callback, so the
+// game thread and the audio thread never wait on each other. The SDL audio
+// lock is only taken for structural changes (loading songs, freeing sounds,
+// initialization). Queries are answered from state the audio thread
+// publishes after each mix, or from what the game thread last asked for.
+
+namespace
+{
+
+enum class AudioCommandType
+{
+	kStartSound,
+	kStopSound,
+	kUpdateSound,
+	kSfxVolume,
+	kMasterVolume,
+	kMusicVolume,
+	kSongVolume,
+	kSongSpeed,
+	kPlaySong,
+	kStopSong,
+	kPauseSong,
+	kResumeSong,
+	kSeekSong,
+	kSongLoopPoint,
+	kInternalMusicVolume,
+	kStopFade,
+	kFadeTo,
+	kFadeFromTo,
+};
+
+struct AudioCommand
+{
+	AudioCommandType type;
+	INT32 channel;
+	uint32_t seq;
+	const SoundChunk* chunk;
+	float a;
+	float b;
+	float c;
+	bool looping;
+};
+
+// Per-channel state shared between the threads. The game thread tags each
+// sound it starts with a sequence number; the audio thread publishes the
+// sequence number of the last sound on the channel that ran to completion.
+struct SoundChannelSync
+{
+	// Game thread only
+	uint32_t issued_seq = 0;
+	bool stopped = true;
+
+	// Audio thread (or the game thread holding the lock) only
+	uint32_t applied_seq = 0;
+
+	std::atomic<uint32_t> finished_seq {0};
+};
+
+constexpr size_t kAudioCommandCapacity = 1024;
+
+SpScQueue<AudioCommand> audio_commands {kAudioCommandCapacity};
+std::unique_ptr<SoundChannelSync[]> sound_channel_sync;
+uint32_t next_sound_seq = 1;
+
+// Fades use the same scheme as sound channels
+uint32_t music_fade_seq = 0;
+uint32_t music_fade_applied_seq = 0;
+std::atomic<uint32_t> music_fade_finished_seq {0};
+
+// Music queries. Play, stop, pause, resume and seek are tagged with a
+// sequence number too. Until the audio thread has published the state
+// after the last of them, the game thread answers with what it asked for.
+struct MusicExpected
+{
+	// Only change when a song is loaded, always under the lock
+	std::optional<audio::MusicType> type;
+	std::optional<float> duration;
+	std::optional<float> loop_point;
+
+	bool playing = false;
+	float position = 0.f;
+};
+
+// Game thread only
+MusicExpected music_expected;
+uint32_t music_seq = 0;
+
+// Audio thread (or the game thread holding the lock) only
+uint32_t music_applied_seq = 0;
+
+std::atomic<uint32_t> music_published_seq {0};
+std::atomic<bool> music_published_playing {false};
+std::atomic<float> music_published_position {0.f};
+
+void apply_command(const AudioCommand& cmd)
+{
+	switch (cmd.type)
+	{
+	case AudioCommandType::kStartSound:
+		sound_effect_channels[cmd.channel]->start(cmd.chunk, cmd.a, cmd.b);
+		sound_channel_sync[cmd.channel].applied_seq = cmd.seq;
+		break;
+	case AudioCommandType::kStopSound:
+		sound_effect_channels[cmd.channel]->reset();
+		break;
+	case AudioCommandType::kUpdateSound:
+		if (!sound_effect_channels[cmd.channel]->finished())
+			sound_effect_channels[cmd.channel]->update(cmd.a, cmd.b);
+		break;
+	case AudioCommandType::kSfxVolume:
+		gain_sound_effects->gain(cmd.a);
+		break;
+	case AudioCommandType::kMasterVolume:
+		master_gain->gain(cmd.a);
+		break;
+	case AudioCommandType::kMusicVolume:
+		gain_music_channel->gain(cmd.a);
+		break;
+	case AudioCommandType::kSongVolume:
+		gain_music_player->gain(cmd.a);
+		break;
+	case AudioCommandType::kSongSpeed:
+		resample_music_player->ratio(cmd.a);
+		break;
+	case AudioCommandType::kPlaySong:
+		music_player->play(cmd.looping);
+		music_applied_seq = cmd.seq;
+		break;
+	case AudioCommandType::kStopSong:
+		music_player->stop();
+		music_applied_seq = cmd.seq;
+		break;
+	case AudioCommandType::kPauseSong:
+		music_player->pause();
+		music_applied_seq = cmd.seq;
+		break;
+	case AudioCommandType::kResumeSong:
+		music_player->unpause();
+		music_applied_seq = cmd.seq;
+		break;
+	case AudioCommandType::kSeekSong:
+		music_player->seek(cmd.a);
+		music_applied_seq = cmd.seq;
+		break;
+	case AudioCommandType::kSongLoopPoint:
+		music_player->loop_point_seconds(cmd.a);
+		break;
+	case AudioCommandType::kInternalMusicVolume:
+		music_player->internal_gain(cmd.a);
+		break;
+	case AudioCommandType::kStopFade:
+		music_player->stop_fade();
+		break;
+	case AudioCommandType::kFadeTo:
+		music_player->fade_to(cmd.a, cmd.c);
+		music_fade_applied_seq = cmd.seq;
+		break;
+	case AudioCommandType::kFadeFromTo:
+		music_player->fade_from_to(cmd.a, cmd.b, cmd.c);
+		music_fade_applied_seq = cmd.seq;
+		break;
+	}
+}
+
+// Consumer side. Runs on the audio thread, or on the game thread while it
+// holds the SDL audio lock.
+void drain_commands()
+{
+	while (std::optional<AudioCommand> cmd = audio_commands.pop())
+	{
+		apply_command(*cmd);
+	}
+}
+
+// Makes the results of the last mix visible to the game thread.
+void publish_state()
+{
+	for (size_t i = 0; i < sound_effect_channels.size(); i++)
+	{
+		if (sound_effect_channels[i]->finished())
+		{
+			SoundChannelSync& sync = sound_channel_sync[i];
+			sync.finished_seq.store(sync.applied_seq, std::memory_order_release);
+		}
+	}
+
+	if (music_player && !music_player->fading())
+	{
+		music_fade_finished_seq.store(music_fade_applied_seq, std::memory_order_release);
+	}
+
+	if (music_player)
+	{
+		music_published_playing.store(music_player->playing(), std::memory_order_relaxed);
+		music_published_position.store(music_player->position_seconds().value_or(0.f), std::memory_order_relaxed);
+		music_published_seq.store(music_applied_seq, std::memory_order_release);
+	}
+}
+
+class SdlAudioLockHandle
+{
+public:
+	// Everything queued before taking the lock is applied first, so the
+	// holder sees the mixer graph as the game thread expects it to be.
+	SdlAudioLockHandle()
+	{
+		SDL_LockAudio();
+		drain_commands();
+	}
+	~SdlAudioLockHandle()
+	{
+		publish_state();
+		SDL_UnlockAudio();
+	}
+};
+
+// Producer side; game thread only.
+void push_command(const AudioCommand& cmd)
+{
+	if (!audio_commands.push(cmd))
+	{
+		// The audio thread has fallen far behind (or isn't running at all).
+		SdlAudioLockHandle _;
+		apply_command(cmd);
+	}
+}
+
+bool sound_channel_playing(size_t index)
+{
+	const SoundChannelSync& sync = sound_channel_sync[index];
+	return !sync.stopped && sync.finished_seq.load(std::memory_order_acquire) != sync.issued_seq;
+}
+
+bool music_fade_pending()
+{
+	return music_fade_finished_seq.load(std::memory_order_acquire) != music_fade_seq;
+}
+
+// Game thread only. playing and position are what the command leads to.
+void push_music_command(AudioCommand cmd, bool playing, float position)
+{
+	cmd.seq = ++music_seq;
+	music_expected.playing = playing;
+	music_expected.position = position;
+	push_command(cmd);
+}
+
+bool music_state_published()
+{
+	return music_published_seq.load(std::memory_order_acquire) == music_seq;
+}
+
+float music_position()
+{
+	return music_state_published() ? music_published_position.load(std::memory_order_relaxed) : music_expected.position;
+}
+
+// With the lock held, after the song in music_player was replaced.
+void reset_music_expected()
+{
+	music_expected.type = music_player->music_type();
+	music_expected.duration = music_player->duration_seconds();
+	music_expected.loop_point = music_player->loop_point_seconds();
+	music_expected.playing = false;
+	music_expected.position = 0.f;
+	music_applied_seq = ++music_seq;
+}
+
+// Empty unless -sfxcache is given
+std::string sfx_cache_directory;
+
+// Safe to call from any thread; the lump must stay alive until it returns.
+SoundChunk* decode_sfx(tcb::span<std::byte> data)
+{
+	std::optional<SoundChunk> chunk;
+
+	if (!sfx_cache_directory.empty())
+	{
+		chunk = srb2::audio::load_cached_chunk(sfx_cache_directory, data);
+		if (chunk)
+			return new SoundChunk {std::move(*chunk)};
+	}
+
+	chunk = srb2::audio::try_load_chunk(data);
+
+	if (!chunk)
+		return nullptr;
+
+	if (!sfx_cache_directory.empty())
+		srb2::audio::store_cached_chunk(sfx_cache_directory, data, *chunk);
+
+	return new SoundChunk {std::move(*chunk)};
+}
+
+} // namespace
+
 void* I_GetSfx(sfxinfo_t* sfx)
 {
 	if (sfx->lumpnum == LUMPERROR)
@@ -83,15 +389,64 @@ void* I_GetSfx(sfxinfo_t* sfx)
 	std::byte* lump = static_cast<std::byte*>(W_CacheLumpNum(sfx->lumpnum, PU_SOUND));
 	auto _ = srb2::finally([lump]() { Z_Free(lump); });
 
-	tcb::span<std::byte> data_span(lump, sfx->length);
-	std::optional<SoundChunk> chunk = srb2::audio::try_load_chunk(data_span);
+	return decode_sfx(tcb::span<std::byte>(lump, sfx->length));
+}
 
-	if (!chunk)
-		return nullptr;
+void I_GetSfxBatch(sfxinfo_t** sfx, size_t count)
+{
+	ZoneScoped;
 
-	SoundChunk* heap_chunk = new SoundChunk {std::move(*chunk)};
+	if (count == 0)
+		return;
+
+	// Lumps are read here, since the WAD code and the zone allocator are
+	// main thread only; only the decoding itself is handed to the pool.
+	vector<std::byte*> lumps(count);
+	vector<SoundChunk*> chunks(count, nullptr);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (sfx[i]->lumpnum == LUMPERROR)
+			sfx[i]->lumpnum = S_GetSfxLumpNum(sfx[i]);
+		sfx[i]->length = W_LumpLength(sfx[i]->lumpnum);
+		lumps[i] = static_cast<std::byte*>(W_CacheLumpNum(sfx[i]->lumpnum, PU_SOUND));
+	}
+
+	if (srb2::g_main_threadpool == nullptr)
+	{
+		for (size_t i = 0; i < count; i++)
+			chunks[i] = decode_sfx(tcb::span<std::byte>(lumps[i], sfx[i]->length));
+	}
+	else
+	{
+		std::byte** lump_data = lumps.data();
+		SoundChunk** chunk_data = chunks.data();
+
+		srb2::g_main_threadpool->begin_sema();
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t length = sfx[i]->length;
+			srb2::g_main_threadpool->schedule([=]() {
+				try
+				{
+					chunk_data[i] = decode_sfx(tcb::span<std::byte>(lump_data[i], length));
+				}
+				catch (...)
+				{
+					// Left null; I_GetSfx will try again when it is played
+				}
+			});
+		}
+		srb2::ThreadPool::Sema sema = srb2::g_main_threadpool->end_sema();
+		srb2::g_main_threadpool->notify_sema(sema);
+		srb2::g_main_threadpool->wait_sema(sema);
+	}
 
-	return heap_chunk;
+	for (size_t i = 0; i < count; i++)
+	{
+		Z_Free(lumps[i]);
+		sfx[i]->data = chunks[i];
+	}
 }
 
 void I_FreeSfx(sfxinfo_t* sfx)
@@ -101,6 +456,9 @@ void I_FreeSfx(sfxinfo_t* sfx)
 		SoundChunk* chunk = static_cast<SoundChunk*>(sfx->data);
 		auto _ = srb2::finally([chunk]() { delete chunk; });
 
+		// Queued starts may still refer to this chunk
+		SdlAudioLockHandle lock;
+
 		// Stop any channels playing this chunk
 		for (auto& player : sound_effect_channels)
 		{
@@ -117,13 +475,6 @@ void I_FreeSfx(sfxinfo_t* sfx)
 namespace
 {
 
-class SdlAudioLockHandle
-{
-public:
-	SdlAudioLockHandle() { SDL_LockAudio(); }
-	~SdlAudioLockHandle() { SDL_UnlockAudio(); }
-};
-
 #ifdef TRACY_ENABLE
 static const char* kAudio = "Audio";
 #endif
@@ -141,23 +492,18 @@ void audio_callback(void* userdata, Uint8* buffer, int len)
 		Sample<2>* float_buffer = reinterpret_cast<Sample<2>*>(buffer);
 		size_t float_len = len / 8;
 
-		for (size_t i = 0; i < float_len; i++)
-		{
-			float_buffer[i] = Sample<2> {0.f, 0.f};
-		}
+		std::fill_n(reinterpret_cast<float*>(buffer), float_len * 2, 0.f);
 
 		if (!master_gain)
 			return;
 
+		drain_commands();
+
 		master_gain->generate(tcb::span {float_buffer, float_len});
 
-		for (size_t i = 0; i < float_len; i++)
-		{
-			float_buffer[i] = {
-				std::clamp(float_buffer[i].amplitudes[0], -1.f, 1.f),
-				std::clamp(float_buffer[i].amplitudes[1], -1.f, 1.f),
-			};
-		}
+		audio::kernels::clamp(reinterpret_cast<float*>(buffer), float_len * 2);
+
+		publish_state();
 #ifdef SRB2_CONFIG_ENABLE_WEBM_MOVIES
 		if (av_recorder)
 			av_recorder->push_audio_samples(tcb::span {float_buffer, float_len});
@@ -196,6 +542,9 @@ void initialize_sound()
 
 	SDL_PauseAudio(SDL_FALSE);
 
+	if (M_CheckParm("-sfxcache"))
+		sfx_cache_directory = std::string(srb2home) + PATHSEP + "sfxcache";
+
 	{
 		SdlAudioLockHandle _;
 
@@ -216,6 +565,7 @@ void initialize_sound()
 		master->add_source(gain_music_channel);
 		mixer_music->add_source(gain_music_player);
 		sound_effect_channels.clear();
+		sound_channel_sync = make_unique<SoundChannelSync[]>(cv_numChannels.value);
 		for (size_t i = 0; i < static_cast<size_t>(cv_numChannels.value); i++)
 		{
 			shared_ptr<SoundEffectPlayer> player = make_shared<SoundEffectPlayer>();
@@ -245,11 +595,7 @@ void I_ShutdownSound(void)
 
 void I_UpdateSound(void)
 {
-	// The SDL audio lock is re-entrant, so it is safe to lock twice
-	// for the "fade to stop music" callback later.
-	SdlAudioLockHandle _;
-
-	if (music_fade_callback && !music_player->fading())
+	if (music_fade_callback && !music_fade_pending())
 	{
 		auto old_callback = music_fade_callback;
 		music_fade_callback = nullptr;
@@ -267,31 +613,23 @@ INT32 I_StartSound(sfxenum_t id, UINT8 vol, UINT8 sep, UINT8 pitch, UINT8 priori
 	(void) pitch;
 	(void) priority;
 
-	SdlAudioLockHandle _;
-
 	if (channel >= 0 && static_cast<size_t>(channel) >= sound_effect_channels.size())
 		return -1;
 
-	shared_ptr<SoundEffectPlayer> player_channel;
 	if (channel < 0)
 	{
 		// find a free sfx channel
 		for (size_t i = 0; i < sound_effect_channels.size(); i++)
 		{
-			if (sound_effect_channels[i]->finished())
+			if (!sound_channel_playing(i))
 			{
-				player_channel = sound_effect_channels[i];
 				channel = i;
 				break;
 			}
 		}
 	}
-	else
-	{
-		player_channel = sound_effect_channels[channel];
-	}
 
-	if (!player_channel)
+	if (channel < 0)
 		return -1;
 
 	SoundChunk* chunk = static_cast<SoundChunk*>(S_sfx[id].data);
@@ -301,15 +639,19 @@ INT32 I_StartSound(sfxenum_t id, UINT8 vol, UINT8 sep, UINT8 pitch, UINT8 priori
 	float vol_float = static_cast<float>(vol) / 255.f;
 	float sep_float = static_cast<float>(sep) / 127.f - 1.f;
 
-	player_channel->start(chunk, vol_float, sep_float);
+	SoundChannelSync& sync = sound_channel_sync[channel];
+	sync.issued_seq = next_sound_seq++;
+	sync.stopped = false;
+	if (next_sound_seq == 0)
+		next_sound_seq = 1;
+
+	push_command({AudioCommandType::kStartSound, channel, sync.issued_seq, chunk, vol_float, sep_float});
 
 	return channel;
 }
 
 void I_StopSound(INT32 handle)
 {
-	SdlAudioLockHandle _;
-
 	if (sound_effect_channels.empty())
 		return;
 
@@ -321,13 +663,12 @@ void I_StopSound(INT32 handle)
 	if (index >= sound_effect_channels.size())
 		return;
 
-	sound_effect_channels[index]->reset();
+	sound_channel_sync[index].stopped = true;
+	push_command({AudioCommandType::kStopSound, handle});
 }
 
 boolean I_SoundIsPlaying(INT32 handle)
 {
-	SdlAudioLockHandle _;
-
 	// Handle is channel index
 	if (sound_effect_channels.empty())
 		return 0;
@@ -340,15 +681,13 @@ boolean I_SoundIsPlaying(INT32 handle)
 	if (index >= sound_effect_channels.size())
 		return 0;
 
-	return sound_effect_channels[index]->finished() ? 0 : 1;
+	return sound_channel_playing(index) ? 1 : 0;
 }
 
 void I_UpdateSoundParams(INT32 handle, UINT8 vol, UINT8 sep, UINT8 pitch)
 {
 	(void) pitch;
 
-	SdlAudioLockHandle _;
-
 	if (sound_effect_channels.empty())
 		return;
 
@@ -360,34 +699,31 @@ void I_UpdateSoundParams(INT32 handle, UINT8 vol, UINT8 sep, UINT8 pitch)
 	if (index >= sound_effect_channels.size())
 		return;
 
-	shared_ptr<SoundEffectPlayer>& channel = sound_effect_channels[index];
-	if (!channel->finished())
+	if (sound_channel_playing(index))
 	{
 		float vol_float = static_cast<float>(vol) / 255.f;
 		float sep_float = static_cast<float>(sep) / 127.f - 1.f;
-		channel->update(vol_float, sep_float);
+		push_command({AudioCommandType::kUpdateSound, handle, 0, nullptr, vol_float, sep_float});
 	}
 }
 
 void I_SetSfxVolume(int volume)
 {
-	SdlAudioLockHandle _;
 	float vol = static_cast<float>(volume) / 100.f;
 
 	if (gain_sound_effects)
 	{
-		gain_sound_effects->gain(std::clamp(vol * vol * vol, 0.f, 1.f));
+		push_command({AudioCommandType::kSfxVolume, 0, 0, nullptr, std::clamp(vol * vol * vol, 0.f, 1.f)});
 	}
 }
 
 void I_SetMasterVolume(int volume)
 {
-	SdlAudioLockHandle _;
 	float vol = static_cast<float>(volume) / 100.f;
 
 	if (master_gain)
 	{
-		master_gain->gain(std::clamp(vol * vol * vol, 0.f, 1.f));
+		push_command({AudioCommandType::kMasterVolume, 0, 0, nullptr, std::clamp(vol * vol * vol, 0.f, 1.f)});
 	}
 }
 
@@ -403,7 +739,10 @@ void I_InitMusic(void)
 	SdlAudioLockHandle _;
 
 	if (music_player != nullptr)
+	{
 		*music_player = audio::MusicPlayer();
+		reset_music_expected();
+	}
 }
 
 void I_ShutdownMusic(void)
@@ -411,7 +750,10 @@ void I_ShutdownMusic(void)
 	SdlAudioLockHandle _;
 
 	if (music_player)
+	{
 		*music_player = audio::MusicPlayer();
+		reset_music_expected();
+	}
 }
 
 /// ------------------------
@@ -423,9 +765,7 @@ const char* I_SongType(void)
 	if (!music_player)
 		return nullptr;
 
-	SdlAudioLockHandle _;
-
-	std::optional<audio::MusicType> music_type = music_player->music_type();
+	std::optional<audio::MusicType> music_type = music_expected.type;
 
 	if (music_type == std::nullopt)
 	{
@@ -448,9 +788,7 @@ boolean I_SongPlaying(void)
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
-
-	return music_player->music_type().has_value();
+	return music_expected.type.has_value();
 }
 
 boolean I_SongPaused(void)
@@ -458,9 +796,10 @@ boolean I_SongPaused(void)
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
+	if (music_state_published())
+		return !music_published_playing.load(std::memory_order_relaxed);
 
-	return !music_player->playing();
+	return !music_expected.playing;
 }
 
 /// ------------------------
@@ -471,7 +810,7 @@ boolean I_SetSongSpeed(float speed)
 {
 	if (resample_music_player)
 	{
-		resample_music_player->ratio(speed);
+		push_command({AudioCommandType::kSongSpeed, 0, 0, nullptr, speed});
 		return true;
 	}
 
@@ -487,9 +826,7 @@ UINT32 I_GetSongLength(void)
 	if (!music_player)
 		return 0;
 
-	SdlAudioLockHandle _;
-
-	std::optional<float> duration = music_player->duration_seconds();
+	std::optional<float> duration = music_expected.duration;
 
 	if (!duration)
 		return 0;
@@ -502,11 +839,10 @@ boolean I_SetSongLoopPoint(UINT32 looppoint)
 	if (!music_player)
 		return 0;
 
-	SdlAudioLockHandle _;
-
-	if (music_player->music_type() == audio::MusicType::kOgg)
+	if (music_expected.type == audio::MusicType::kOgg)
 	{
-		music_player->loop_point_seconds(looppoint / 1000.f);
+		push_command({AudioCommandType::kSongLoopPoint, 0, 0, nullptr, looppoint / 1000.f});
+		music_expected.loop_point = looppoint / 1000.f;
 		return true;
 	}
 
@@ -518,9 +854,7 @@ UINT32 I_GetSongLoopPoint(void)
 	if (!music_player)
 		return 0;
 
-	SdlAudioLockHandle _;
-
-	std::optional<float> loop_point_seconds = music_player->loop_point_seconds();
+	std::optional<float> loop_point_seconds = music_expected.loop_point;
 
 	if (!loop_point_seconds)
 		return 0;
@@ -533,9 +867,7 @@ boolean I_SetSongPosition(UINT32 position)
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
-
-	music_player->seek(position / 1000.f);
+	push_music_command({AudioCommandType::kSeekSong, 0, 0, nullptr, position / 1000.f}, music_expected.playing, position / 1000.f);
 	return true;
 }
 
@@ -544,14 +876,10 @@ UINT32 I_GetSongPosition(void)
 	if (!music_player)
 		return 0;
 
-	SdlAudioLockHandle _;
-
-	std::optional<float> position_seconds = music_player->position_seconds();
-
-	if (!position_seconds)
+	if (!music_expected.type)
 		return 0;
 
-	return static_cast<UINT32>(std::round(*position_seconds * 1000.f));
+	return static_cast<UINT32>(std::round(music_position() * 1000.f));
 }
 
 void I_UpdateSongLagThreshold(void)
@@ -612,25 +940,23 @@ boolean I_LoadSong(char* data, size_t len)
 		return false;
 	}
 
+	SdlAudioLockHandle _;
+
 	if (music_fade_callback && music_player->fading())
 	{
 		auto old_callback = music_fade_callback;
 		music_fade_callback = nullptr;
 		(old_callback)();
-	}
-
-	SdlAudioLockHandle _;
 
-	try
-	{
-		*music_player = std::move(new_player);
-	}
-	catch (const std::exception& ex)
-	{
-		print_ex(ex);
-		return false;
+		// Whatever the callback queued is meant for the outgoing song
+		drain_commands();
 	}
 
+	// The outgoing song ends up in new_player, which is destroyed after
+	// the lock is released, so joining its decode thread can't stall the mix.
+	std::swap(*music_player, new_player);
+	reset_music_expected();
+
 	if (gain_music_player)
 	{
 		// Reset song volume to 1.0 for newly loaded songs.
@@ -645,16 +971,21 @@ void I_UnloadSong(void)
 	if (!music_player)
 		return;
 
+	// Destroyed after the lock is released, see I_LoadSong
+	audio::MusicPlayer old_player;
+
+	SdlAudioLockHandle _;
+
 	if (music_fade_callback && music_player->fading())
 	{
 		auto old_callback = music_fade_callback;
 		music_fade_callback = nullptr;
 		(old_callback)();
+		drain_commands();
 	}
 
-	SdlAudioLockHandle _;
-
-	*music_player = audio::MusicPlayer();
+	std::swap(*music_player, old_player);
+	reset_music_expected();
 }
 
 boolean I_PlaySong(boolean looping)
@@ -662,9 +993,7 @@ boolean I_PlaySong(boolean looping)
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
-
-	music_player->play(looping);
+	push_music_command({AudioCommandType::kPlaySong, 0, 0, nullptr, 0.f, 0.f, 0.f, static_cast<bool>(looping)}, music_expected.type.has_value(), 0.f);
 
 	return true;
 }
@@ -674,9 +1003,7 @@ void I_StopSong(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->stop();
+	push_music_command({AudioCommandType::kStopSong}, false, 0.f);
 }
 
 void I_PauseSong(void)
@@ -684,9 +1011,7 @@ void I_PauseSong(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->pause();
+	push_music_command({AudioCommandType::kPauseSong}, false, music_position());
 }
 
 void I_ResumeSong(void)
@@ -694,9 +1019,7 @@ void I_ResumeSong(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->unpause();
+	push_music_command({AudioCommandType::kResumeSong}, music_expected.type.has_value(), music_position());
 }
 
 void I_SetMusicVolume(int volume)
@@ -707,7 +1030,7 @@ void I_SetMusicVolume(int volume)
 	{
 		// Music channel volume is interpreted as logarithmic rather than linear.
 		// We approximate by cubing the gain level so vol 50 roughly sounds half as loud.
-		gain_music_channel->gain(std::clamp(vol * vol * vol, 0.f, 1.f));
+		push_command({AudioCommandType::kMusicVolume, 0, 0, nullptr, std::clamp(vol * vol * vol, 0.f, 1.f)});
 	}
 }
 
@@ -718,7 +1041,7 @@ void I_SetCurrentSongVolume(int volume)
 	if (gain_music_player)
 	{
 		// However, different from music channel volume, musicdef volumes are explicitly linear.
-		gain_music_player->gain(std::max(vol, 0.f));
+		push_command({AudioCommandType::kSongVolume, 0, 0, nullptr, std::max(vol, 0.f)});
 	}
 }
 
@@ -737,10 +1060,8 @@ void I_SetInternalMusicVolume(UINT8 volume)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
 	float gain = volume / 100.f;
-	music_player->internal_gain(gain);
+	push_command({AudioCommandType::kInternalMusicVolume, 0, 0, nullptr, gain});
 }
 
 void I_StopFadingSong(void)
@@ -748,9 +1069,7 @@ void I_StopFadingSong(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->stop_fade();
+	push_command({AudioCommandType::kStopFade});
 }
 
 boolean I_FadeSongFromVolume(UINT8 target_volume, UINT8 source_volume, UINT32 ms, void (*callback)(void))
@@ -758,13 +1077,11 @@ boolean I_FadeSongFromVolume(UINT8 target_volume, UINT8 source_volume, UINT32 ms
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
-
 	float source_gain = source_volume / 100.f;
 	float target_gain = target_volume / 100.f;
 	float seconds = ms / 1000.f;
 
-	music_player->fade_from_to(source_gain, target_gain, seconds);
+	push_command({AudioCommandType::kFadeFromTo, 0, ++music_fade_seq, nullptr, source_gain, target_gain, seconds});
 
 	if (music_fade_callback)
 		music_fade_callback();
@@ -778,12 +1095,10 @@ boolean I_FadeSong(UINT8 target_volume, UINT32 ms, void (*callback)(void))
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
-
 	float target_gain = target_volume / 100.f;
 	float seconds = ms / 1000.f;
 
-	music_player->fade_to(target_gain, seconds);
+	push_command({AudioCommandType::kFadeTo, 0, ++music_fade_seq, nullptr, target_gain, 0.f, seconds});
 
 	if (music_fade_callback)
 		music_fade_callback();
@@ -797,9 +1112,7 @@ static void stop_song_cb(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->stop();
+	push_music_command({AudioCommandType::kStopSong}, false, 0.f);
 }
 
 boolean I_FadeOutStopSong(UINT32 ms)
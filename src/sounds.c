@@ -20,6 +20,7 @@
 #include "z_zone.h"
 #include "w_wad.h"
 #include "lua_script.h"
+#include "deh_tables.h"
 
 //
 // Information about all the sfx
@@ -1580,6 +1581,7 @@ void S_InitRuntimeSounds (void)
 		strcpy(freeslotnames[value-1], soundname);
 
 		S_sfx[i].name = freeslotnames[value-1];
+		DEH_AddName(DEHNAME_SFX, S_sfx[i].name, i);
 		S_sfx[i].singularity = false;
 		S_sfx[i].priority = 0;
 		S_sfx[i].pitch = 0;
@@ -1617,6 +1619,7 @@ sfxenum_t S_AddSoundFx(const char *name, boolean singular, INT32 flags, boolean
 	if (i < NUMSFX)
 	{
 		strncpy(freeslotnames[i-sfx_freeslot0], name, 6);
+		DEH_AddName(DEHNAME_SFX, S_sfx[i].name, i);
 		S_sfx[i].singularity = singular;
 		S_sfx[i].priority = 60;
 		S_sfx[i].pitch = flags;
@@ -16,6 +16,9 @@
 
 #include <cmath>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 #include <tracy/tracy/Tracy.hpp>
 
@@ -2767,7 +2770,7 @@ void V_DrawStringScaled(
 	}
 }
 
-fixed_t V_StringScaledWidth(
+static fixed_t V_MeasureStringScaledWidth(
 		fixed_t      scale,
 		fixed_t spacescale,
 		fixed_t    lfscale,
@@ -2892,6 +2895,76 @@ fixed_t V_StringScaledWidth(
 	return fullwidth;
 }
 
+namespace
+{
+
+// Measured string widths. HUD and menu code measures the same strings every frame, usually
+// to center or right-align them, so remember the last few thousand.
+struct StringWidthEntry
+{
+	std::string string;
+	fixed_t scale;
+	fixed_t spacescale;
+	fixed_t lfscale;
+	INT32 flags;
+	INT32 dupx;
+	int fontno;
+	fixed_t width;
+};
+
+constexpr std::size_t kMaxStringWidthEntries = 4096;
+
+// Only these flags change how a string is measured; the rest (colors, translucency, snapping)
+// would just split the cache.
+constexpr INT32 kStringWidthFlags = V_SPACINGMASK | V_FORCEUPPERCASE | V_NOSCALESTART;
+
+std::unordered_map<std::size_t, StringWidthEntry> g_string_widths;
+UINT32 g_string_widths_generation;
+
+} // namespace
+
+fixed_t V_StringScaledWidth(
+		fixed_t      scale,
+		fixed_t spacescale,
+		fixed_t    lfscale,
+		INT32      flags,
+		int        fontno,
+		const char *s)
+{
+	const std::string_view string = s;
+	const INT32 dupx = (flags & V_NOSCALESTART) ? vid.dupx : 1;
+
+	flags &= kStringWidthFlags;
+
+	if (g_string_widths_generation != fontgeneration || g_string_widths.size() >= kMaxStringWidthEntries)
+	{
+		g_string_widths.clear();
+		g_string_widths_generation = fontgeneration;
+	}
+
+	std::size_t hash = 0;
+	srb2::hash_combine(hash, string, scale, spacescale, lfscale, flags, dupx, fontno);
+
+	StringWidthEntry& entry = g_string_widths[hash];
+	if (entry.string != string || entry.scale != scale || entry.spacescale != spacescale ||
+		entry.lfscale != lfscale || entry.flags != flags || entry.dupx != dupx || entry.fontno != fontno)
+	{
+		// New string, or a hash collision; either way the slot now belongs to this one
+		entry = {
+			std::string(string),
+			scale,
+			spacescale,
+			lfscale,
+			flags,
+			dupx,
+			fontno,
+			V_MeasureStringScaledWidth(scale, spacescale, lfscale, flags, fontno, s)
+		};
+	}
+
+	return entry.width;
+}
+
 // Modify a string to wordwrap at any given width.
 char * V_ScaledWordWrap(
 		fixed_t          w,
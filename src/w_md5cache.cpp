@@ -0,0 +1,397 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  w_md5cache.cpp
+/// \brief Persistent cache of file MD5 digests
+///
+/// Hashing every addon on every boot (and every candidate file when joining
+/// a server) dominates startup with large addon sets. Digests are stored in
+/// MD5CACHEFILE keyed by path, and trusted for as long as the file's size and
+/// modification time stay the same. Only entries looked up or hashed this
+/// session are written back, so files that were deleted, moved or replaced
+/// drop out of the cache the next time it is saved.
+
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "core/thread_pool.h"
+#include "io/streams.hpp"
+#include "w_md5cache.h"
+#include "doomdef.h"
+#include "d_main.h" // srb2home
+#include "i_time.h"
+#include "m_argv.h"
+#include "md5.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+constexpr uint32_t kCacheMagic = 0x35444D52; // "RMD5"
+constexpr uint32_t kCacheVersion = 1;
+
+struct FileStamp
+{
+	uint64_t size;
+	int64_t mtime;
+
+	bool operator==(const FileStamp& rhs) const noexcept { return size == rhs.size && mtime == rhs.mtime; }
+};
+
+struct CacheEntry
+{
+	FileStamp stamp;
+	std::array<uint8_t, 16> md5;
+	bool used = false; // looked up or hashed this session
+	bool saved = false; // present in MD5CACHEFILE as last loaded or saved
+};
+
+struct HashJob
+{
+	std::string key;
+	std::string path;
+	FileStamp stamp;
+	std::array<uint8_t, 16> md5;
+	INT32 result;
+};
+
+std::unordered_map<std::string, CacheEntry> g_cache;
+bool g_loaded = false;
+bool g_dirty = false;
+
+bool persist_enabled()
+{
+	return !M_CheckParm("-nomd5cache");
+}
+
+std::string cache_path()
+{
+	return fmt::format("{}/{}", srb2home, MD5CACHEFILE);
+}
+
+// Absolute, normalized path so the same file reached through different
+// relative paths (e.g. after a findfile search) shares one entry.
+std::string cache_key(const char* filename)
+{
+	std::error_code ec;
+	fs::path p = fs::absolute(fs::u8path(filename), ec);
+	if (ec)
+	{
+		return filename;
+	}
+	return p.lexically_normal().u8string();
+}
+
+bool stat_file(const char* filename, FileStamp& stamp)
+{
+	std::error_code ec;
+	fs::path p = fs::u8path(filename);
+
+	uintmax_t size = fs::file_size(p, ec);
+	if (ec)
+	{
+		return false;
+	}
+
+	fs::file_time_type mtime = fs::last_write_time(p, ec);
+	if (ec)
+	{
+		return false;
+	}
+
+	stamp.size = size;
+	stamp.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+	return true;
+}
+
+INT32 hash_file(const char* filename, uint8_t* resblock)
+{
+	FILE* fhandle = fopen(filename, "rb");
+	if (fhandle == nullptr)
+	{
+		return 1;
+	}
+
+	INT32 result = md5_stream(fhandle, resblock) == 1 ? 1 : 0;
+	fclose(fhandle);
+	return result;
+}
+
+void load_cache()
+{
+	g_loaded = true;
+
+	if (!persist_enabled())
+	{
+		return;
+	}
+
+	std::vector<std::byte> data;
+	try
+	{
+		srb2::io::FileStream file {cache_path(), srb2::io::FileStreamMode::kRead};
+		data = srb2::io::read_to_vec(file);
+	}
+	catch (const srb2::io::FileStreamException&)
+	{
+		// No cache yet
+		return;
+	}
+
+	try
+	{
+		srb2::io::VecStream stream {std::move(data)};
+
+		if (srb2::io::read_uint32(stream) != kCacheMagic || srb2::io::read_uint32(stream) != kCacheVersion)
+		{
+			g_dirty = true;
+			return;
+		}
+
+		uint32_t count = srb2::io::read_uint32(stream);
+		g_cache.reserve(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			std::string key(srb2::io::read_uint16(stream), '\0');
+			srb2::io::read_exact(stream, tcb::as_writable_bytes(tcb::make_span(key)));
+
+			CacheEntry entry;
+			entry.saved = true;
+			entry.stamp.size = srb2::io::read_uint64(stream);
+			entry.stamp.mtime = srb2::io::read_int64(stream);
+			srb2::io::read_exact(stream, tcb::as_writable_bytes(tcb::make_span(entry.md5)));
+
+			g_cache[std::move(key)] = entry;
+		}
+	}
+	catch (const std::exception& ex)
+	{
+		// Treat a damaged cache as empty; it is rewritten on the next save.
+		CONS_Debug(DBG_SETUP, "Discarding %s: %s\n", MD5CACHEFILE, ex.what());
+		g_cache.clear();
+		g_dirty = true;
+	}
+}
+
+void ensure_loaded()
+{
+	if (!g_loaded)
+	{
+		load_cache();
+	}
+}
+
+bool lookup(const std::string& key, const FileStamp& stamp, uint8_t* resblock)
+{
+	auto it = g_cache.find(key);
+	if (it == g_cache.end() || !(it->second.stamp == stamp))
+	{
+		return false;
+	}
+
+	// An earlier save this session left it out as unused; put it back.
+	if (!it->second.saved)
+	{
+		g_dirty = true;
+	}
+	it->second.used = true;
+
+	std::copy(it->second.md5.begin(), it->second.md5.end(), resblock);
+	return true;
+}
+
+void store(std::string key, const FileStamp& stamp, const uint8_t* md5)
+{
+	CacheEntry& entry = g_cache[std::move(key)];
+	entry.stamp = stamp;
+	std::copy(md5, md5 + 16, entry.md5.begin());
+	entry.used = true;
+	entry.saved = false;
+	g_dirty = true;
+}
+
+} // namespace
+
+INT32 W_GetFileMD5(const char *filename, UINT8 *resblock)
+{
+	FileStamp stamp;
+	std::string key;
+
+	ensure_loaded();
+
+	if (!stat_file(filename, stamp))
+	{
+		return 1;
+	}
+
+	key = cache_key(filename);
+	if (lookup(key, stamp, resblock))
+	{
+		return 0;
+	}
+
+	tic_t t = I_GetTime();
+	CONS_Debug(DBG_SETUP, "Making MD5 for %s\n", filename);
+	if (hash_file(filename, resblock) != 0)
+	{
+		return 1;
+	}
+	CONS_Debug(DBG_SETUP, "MD5 calc for %s took %f seconds\n",
+		filename, (float)(I_GetTime() - t)/NEWTICRATE);
+
+	store(std::move(key), stamp, resblock);
+	return 0;
+}
+
+void W_PrecacheFileMD5s(char **filenames)
+{
+	std::vector<HashJob> jobs;
+
+	ensure_loaded();
+
+	for (; *filenames; filenames++)
+	{
+		HashJob job {};
+		uint8_t scratch[16];
+
+		// Files that need a findfile search are left for W_InitFile.
+		if (!stat_file(*filenames, job.stamp))
+		{
+			continue;
+		}
+
+		job.key = cache_key(*filenames);
+		if (lookup(job.key, job.stamp, scratch))
+		{
+			continue;
+		}
+
+		job.path = *filenames;
+		jobs.push_back(std::move(job));
+	}
+
+	if (jobs.empty())
+	{
+		return;
+	}
+
+	tic_t t = I_GetTime();
+
+	if (jobs.size() == 1 || srb2::g_main_threadpool == nullptr)
+	{
+		for (HashJob& job : jobs)
+		{
+			job.result = hash_file(job.path.c_str(), job.md5.data());
+		}
+	}
+	else
+	{
+		// The job vector is not resized past this point, so workers can
+		// safely write into their own element.
+		srb2::g_main_threadpool->begin_sema();
+		for (HashJob& job : jobs)
+		{
+			HashJob* pjob = &job;
+			srb2::g_main_threadpool->schedule([pjob]() {
+				pjob->result = hash_file(pjob->path.c_str(), pjob->md5.data());
+			});
+		}
+		srb2::ThreadPool::Sema sema = srb2::g_main_threadpool->end_sema();
+		srb2::g_main_threadpool->notify_sema(sema);
+		srb2::g_main_threadpool->wait_sema(sema);
+	}
+
+	for (HashJob& job : jobs)
+	{
+		if (job.result == 0)
+		{
+			store(std::move(job.key), job.stamp, job.md5.data());
+		}
+	}
+
+	CONS_Debug(DBG_SETUP, "MD5 calc for %s files took %f seconds\n",
+		sizeu1(jobs.size()), (float)(I_GetTime() - t)/NEWTICRATE);
+}
+
+void W_SaveMD5Cache(void)
+{
+	if (!g_dirty || !persist_enabled())
+	{
+		return;
+	}
+
+	srb2::io::VecStream stream;
+
+	srb2::io::write(kCacheMagic, stream);
+	srb2::io::write(kCacheVersion, stream);
+
+	// Entries not hit this session are stale as far as this cache can tell,
+	// and are pruned rather than carried forward forever.
+	auto keep = [](const std::string& key, const CacheEntry& entry)
+	{
+		return entry.used && key.size() <= UINT16_MAX;
+	};
+
+	uint32_t count = 0;
+	for (const auto& [key, entry] : g_cache)
+	{
+		if (keep(key, entry))
+		{
+			count++;
+		}
+	}
+	srb2::io::write(count, stream);
+
+	for (const auto& [key, entry] : g_cache)
+	{
+		if (!keep(key, entry))
+		{
+			continue;
+		}
+
+		srb2::io::write(static_cast<uint16_t>(key.size()), stream);
+		srb2::io::write_exact(stream, tcb::as_bytes(tcb::make_span(key)));
+		srb2::io::write(entry.stamp.size, stream);
+		srb2::io::write(entry.stamp.mtime, stream);
+		srb2::io::write_exact(stream, tcb::as_bytes(tcb::make_span(entry.md5)));
+	}
+
+	// Write beside the real file and rename over it, so a crash mid-save
+	// never leaves a truncated cache behind.
+	std::string path = cache_path();
+	std::string tmppath = path + ".tmp";
+
+	try
+	{
+		srb2::io::FileStream file {tmppath, srb2::io::FileStreamMode::kWrite};
+		srb2::io::write_exact(file, tcb::as_bytes(tcb::make_span(stream.vector())));
+		file.close();
+
+		fs::rename(tmppath, path);
+	}
+	catch (const std::exception& ex)
+	{
+		CONS_Alert(CONS_WARNING, "Failed to save %s: %s\n", MD5CACHEFILE, ex.what());
+		return;
+	}
+
+	for (auto& [key, entry] : g_cache)
+	{
+		entry.saved = keep(key, entry);
+	}
+
+	g_dirty = false;
+}
@@ -0,0 +1,40 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  w_md5cache.h
+/// \brief Persistent cache of file MD5 digests
+
+#ifndef __W_MD5CACHE_H__
+#define __W_MD5CACHE_H__
+
+#include "doomtype.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MD5CACHEFILE "md5cache.dat"
+
+// Writes the MD5 of filename into resblock (16 bytes), reusing the
+// cached digest if the file's size and modification time are unchanged.
+// Returns 0 on success, 1 if the file could not be read.
+INT32 W_GetFileMD5(const char *filename, UINT8 *resblock);
+
+// Hashes every file in the NULL-terminated list that is not already
+// cached, in parallel on the thread pool. Missing files are skipped.
+void W_PrecacheFileMD5s(char **filenames);
+
+// Writes the cache back to disk if anything changed since it was loaded.
+// Entries that were not looked up or hashed this session are dropped.
+void W_SaveMD5Cache(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __W_MD5CACHE_H__
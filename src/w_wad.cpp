@@ -68,6 +68,7 @@
 #include "i_time.h"
 #include "i_system.h"
 #include "md5.h"
+#include "w_md5cache.h"
 #include "lua_script.h"
 #include "g_game.h" // G_SetGameModified
 
@@ -120,6 +121,10 @@ wadfile_t *wadfiles[MAX_WADFILES]; // 0 to numwadfiles-1 are valid
 // being ejected
 void W_Shutdown(void)
 {
+#ifndef NOMD5
+	W_SaveMD5Cache();
+#endif
+
 	while (numwadfiles--)
 	{
 		wadfile_t *wad = wadfiles[numwadfiles];
@@ -284,7 +289,7 @@ static inline void W_LoadDehackedLumps(UINT16 wadnum, boolean mainfile)
 /** Compute MD5 message digest for bytes read from STREAM of this filname.
   *
   * The resulting message digest number will be written into the 16 bytes
-  * beginning at RESBLOCK.
+  * beginning at RESBLOCK. Digests of unchanged files come from the MD5 cache.
   *
   * \param filename path of file
   * \param resblock resulting MD5 checksum
@@ -295,25 +300,10 @@ static inline INT32 W_MakeFileMD5(const char *filename, void *resblock)
 #ifdef NOMD5
 	(void)filename;
 	memset(resblock, 0x00, 16);
+	return 1;
 #else
-	FILE *fhandle;
-
-	if ((fhandle = fopen(filename, "rb")) != NULL)
-	{
-		tic_t t = I_GetTime();
-		CONS_Debug(DBG_SETUP, "Making MD5 for %s\n",filename);
-		if (md5_stream(fhandle, resblock) == 1)
-		{
-			fclose(fhandle);
-			return 1;
-		}
-		CONS_Debug(DBG_SETUP, "MD5 calc for %s took %f seconds\n",
-			filename, (float)(I_GetTime() - t)/NEWTICRATE);
-		fclose(fhandle);
-		return 0;
-	}
+	return W_GetFileMD5(filename, static_cast<UINT8*>(resblock));
 #endif
-	return 1;
 }
 
 // Invalidates the cache of lump numbers. Call this whenever a wad is added.
@@ -972,6 +962,11 @@ INT32 W_InitMultipleFiles(char **filenames, boolean addons)
 	INT32 rc = 1;
 	INT32 overallrc = 1;
 
+#ifndef NOMD5
+	// Hash everything up front so cache misses are spread across threads
+	W_PrecacheFileMD5s(filenames);
+#endif
+
 	// will be realloced as lumps are added
 	for (; *filenames; filenames++)
 	{
@@ -985,6 +980,10 @@ INT32 W_InitMultipleFiles(char **filenames, boolean addons)
 		overallrc &= (rc != INT16_MAX) ? 1 : 0;
 	}
 
+#ifndef NOMD5
+	W_SaveMD5Cache();
+#endif
+
 	if (!numwadfiles)
 		I_Error("W_InitMultipleFiles: no files found");
 
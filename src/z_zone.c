@@ -66,6 +66,8 @@ typedef struct memblock_s
 	const char *ownerfile;
 	INT32 ownerline;
 
+	boolean patch; // a patch_t, see Z_MarkPatch
+
 	struct memblock_s *next, *prev;
 } memblock_t;
 
@@ -145,6 +147,10 @@ void Z_Free2(void *ptr, const char *file, INT32 line)
 	if (block->tag != PU_LUA)
 		LUA_InvalidateUserdata(ptr);
 
+	// However it was freed, caches keyed by patch pointer must hear of it.
+	if (block->patch)
+		Patch_NoteFreed((patch_t *)ptr);
+
 	// TODO: if zdebugging, make sure no other block has a user
 	// that is about to be freed.
 
@@ -230,6 +236,7 @@ void *Z_Malloc2(size_t size, INT32 tag, void *user, INT32 alignbits,
 
 	block->tag = tag;
 	block->user = NULL;
+	block->patch = false;
 	block->ownerline = line;
 	block->ownerfile = file;
 	block->size = sizeof (memblock_t) + size;
@@ -527,6 +534,28 @@ void Z_ChangeTag(void *ptr, INT32 tag)
 	block->tag = tag;
 }
 
+/** Marks a block as holding a patch_t, so freeing it by any means
+  * (Z_Free, Z_FreeTags, purging) is passed on to Patch_NoteFreed.
+  *
+  * \param ptr A pointer to allocated memory,
+  *             assumed to have been allocated with Z_Malloc/Z_Calloc.
+  */
+void Z_MarkPatch(void *ptr)
+{
+	memblock_t *block;
+
+	if (ptr == NULL)
+		return;
+
+	block = MEMBLOCK(ptr);
+
+#ifdef PARANOIA
+	if (block->id != ZONEID) I_Error("Z_MarkPatch: wrong id");
+#endif
+
+	block->patch = true;
+}
+
 /** Changes a memory block's user.
   *
   * \param ptr A pointer to allocated memory,
@@ -132,6 +132,8 @@ void Z_ChangeTag(void *ptr, INT32 tag);
 void Z_SetUser(void *ptr, void **newuser);
 #endif
 
+void Z_MarkPatch(void *ptr);
+
 //
 // Zone memory usage
 //